@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "aux.h"
+#include "collective.h"
+#include "err.h"
+#include "factory.h"
+#include "hlop.h"
+#include "msg.h"
+#include "platform.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+// the C enums are cast to the enums of hlop, every enumerator must have the same value
+static_assert(static_cast<int>(hlop::platform::DF) == HLOP_PLATFORM_DF);
+static_assert(static_cast<int>(hlop::platform::TH) == HLOP_PLATFORM_TH);
+static_assert(static_cast<int>(hlop::op_type::ALLGATHER) == HLOP_OP_ALLGATHER);
+static_assert(static_cast<int>(hlop::op_type::ALLREDUCE) == HLOP_OP_ALLREDUCE);
+static_assert(static_cast<int>(hlop::op_type::ALLTOALL) == HLOP_OP_ALLTOALL);
+static_assert(static_cast<int>(hlop::op_type::BCAST) == HLOP_OP_BCAST);
+static_assert(static_cast<int>(hlop::op_type::GATHER) == HLOP_OP_GATHER);
+static_assert(static_cast<int>(hlop::op_type::REDUCE) == HLOP_OP_REDUCE);
+static_assert(static_cast<int>(hlop::op_type::SCATTER) == HLOP_OP_SCATTER);
+static_assert(static_cast<int>(hlop::algo_type::BINOMIAL) == HLOP_ALGO_BINOMIAL);
+static_assert(static_cast<int>(hlop::algo_type::RING) == HLOP_ALGO_RING);
+static_assert(static_cast<int>(hlop::algo_type::RECURSIVE_DOUBLING) == HLOP_ALGO_RECURSIVE_DOUBLING);
+static_assert(static_cast<int>(hlop::algo_type::SMP) == HLOP_ALGO_SMP);
+static_assert(static_cast<int>(hlop::algo_type::SCATTER_RING_ALLGATHER) == HLOP_ALGO_SCATTER_RING_ALLGATHER);
+static_assert(static_cast<int>(hlop::algo_type::SCATTER_RECURSIVE_DOUBLING_ALLGATHER) ==
+              HLOP_ALGO_SCATTER_RECURSIVE_DOUBLING_ALLGATHER);
+static_assert(static_cast<int>(hlop::algo_type::REDUCE_SCATTER_ALLGATHER) == HLOP_ALGO_REDUCE_SCATTER_ALLGATHER);
+static_assert(static_cast<int>(hlop::algo_type::REDUCE_SCATTER_GATHER) == HLOP_ALGO_REDUCE_SCATTER_GATHER);
+static_assert(static_cast<int>(hlop::algo_type::PAIRWISE) == HLOP_ALGO_PAIRWISE);
+static_assert(static_cast<int>(hlop::algo_type::BRUCKS) == HLOP_ALGO_BRUCKS);
+static_assert(static_cast<int>(hlop::algo_type::K_BRUCKS) == HLOP_ALGO_K_BRUCKS);
+static_assert(static_cast<int>(hlop::rank_arrangement::BLOCK) == HLOP_ARRANGE_BLOCK);
+static_assert(static_cast<int>(hlop::rank_arrangement::CYCLIC) == HLOP_ARRANGE_CYCLIC);
+
+/**
+ * @brief the node list snapshot of a handle and the predictions made on it, in an LRU cache
+ * keyed by operation, algorithm (BEST for hlop_best_algo) and message size.
+ */
+struct hlop_topology {
+	struct prediction {
+		hlop::algo_type_t algo;
+		double time;
+	};
+	static constexpr std::uint64_t BEST = 0xff;
+	/// @brief predictions kept by a handle, the least recently used one is dropped beyond it.
+	static constexpr std::size_t CAPACITY = 4096;
+	static std::uint64_t key(hlop_op_t op, std::uint64_t algo, int msg_size) {
+		return (static_cast<std::uint64_t>(op) << 40) | (algo << 32) | static_cast<std::uint32_t>(msg_size);
+	}
+	using entry = std::pair<std::uint64_t, prediction>;
+
+	hlop::const_node_list_ptr_t nl;
+	mutable std::mutex mtx;
+	mutable std::list<entry> lru; // the most recently used first
+	mutable std::unordered_map<std::uint64_t, std::list<entry>::iterator> predictions;
+};
+
+namespace {
+thread_local std::string last_error;
+
+hlop_status_t fail(hlop_status_t status, const std::string &msg) {
+	last_error = msg;
+	return status;
+}
+
+/**
+ * @brief run a call, its exceptions are turned into a status and the error of this thread.
+ */
+template <typename F>
+hlop_status_t guard(F &&f) noexcept {
+	try {
+		return f();
+	} catch (const std::bad_alloc &e) {
+		return fail(HLOP_ERR_NOMEM, e.what());
+	} catch (const std::exception &e) {
+		// hlop_err is local to each translation unit, the errors of the library are caught as its base
+		return fail(HLOP_ERR_FAILED, e.what());
+	} catch (...) {
+		return fail(HLOP_ERR_INTERNAL, "unknown error");
+	}
+}
+
+/**
+ * @brief get the predictor of an operation, created once and shared by all topologies.
+ * @return collective *, nullptr if the operation is not supported.
+ */
+const hlop::collective *predictor(hlop_op_t op) {
+	static const auto predictors = []() {
+		std::map<hlop::op_type_t, std::unique_ptr<const hlop::collective>> res;
+		for (const auto o : hlop::get_collective_ops())
+			res.emplace(o, hlop::make_collective(o));
+		return res;
+	}();
+	const auto it = predictors.find(static_cast<hlop::op_type_t>(op));
+	return it == predictors.end() ? nullptr : it->second.get();
+}
+
+bool valid_platform(hlop_platform_t pf) { return pf == HLOP_PLATFORM_DF || pf == HLOP_PLATFORM_TH; }
+
+bool valid_arrangement(hlop_arrangement_t ra) { return ra == HLOP_ARRANGE_BLOCK || ra == HLOP_ARRANGE_CYCLIC; }
+
+/**
+ * @brief check the arguments shared by hlop_predict and hlop_best_algo.
+ */
+hlop_status_t check_query(const hlop_topology_t *topo, hlop_op_t op, int msg_size, const hlop::collective *&c) {
+	if (topo == nullptr)
+		return fail(HLOP_ERR_ARG, "topology is null");
+	if (msg_size <= 0)
+		return fail(HLOP_ERR_ARG, hlop::format("message size {} should be greater than 0", msg_size));
+	c = predictor(op);
+	if (c == nullptr)
+		return fail(HLOP_ERR_ARG, hlop::format("unsupported operation type: {}", static_cast<int>(op)));
+	return HLOP_SUCCESS;
+}
+
+/**
+ * @brief look a prediction up in a topology.
+ * @return bool, true if it is there.
+ */
+bool find(const hlop_topology_t *topo, std::uint64_t key, hlop_topology::prediction &p) {
+	std::lock_guard<std::mutex> lock{topo->mtx};
+	auto it = topo->predictions.find(key);
+	if (it == topo->predictions.end())
+		return false;
+	topo->lru.splice(topo->lru.begin(), topo->lru, it->second);
+	p = it->second->second;
+	return true;
+}
+
+/**
+ * @brief keep a prediction in a topology, the least recently used one is dropped beyond its capacity.
+ */
+void keep(const hlop_topology_t *topo, std::uint64_t key, const hlop_topology::prediction &p) {
+	std::lock_guard<std::mutex> lock{topo->mtx};
+	auto it = topo->predictions.find(key);
+	if (it != topo->predictions.end()) {
+		// predicted by another thread meanwhile, the same value
+		topo->lru.splice(topo->lru.begin(), topo->lru, it->second);
+		return;
+	}
+	topo->lru.emplace_front(key, p);
+	topo->predictions.emplace(key, topo->lru.begin());
+	if (topo->lru.size() > hlop_topology::CAPACITY) {
+		topo->predictions.erase(topo->lru.back().first);
+		topo->lru.pop_back();
+	}
+}
+} // namespace
+
+hlop_status_t hlop_topology_create(hlop_platform_t pf, const char *const *hosts, int nhost, const int *rank_nodes,
+                                   const int *rank_cores, int nrank, hlop_topology_t **topo) {
+	return guard([&] {
+		if (topo == nullptr || hosts == nullptr || rank_nodes == nullptr || rank_cores == nullptr)
+			return fail(HLOP_ERR_ARG, "a pointer argument is null");
+		*topo = nullptr;
+		if (!valid_platform(pf))
+			return fail(HLOP_ERR_ARG, hlop::format("unknown platform: {}", static_cast<int>(pf)));
+		if (nhost <= 0 || nrank <= 0)
+			return fail(HLOP_ERR_ARG, hlop::format("{} hosts and {} ranks should be greater than 0", nhost, nrank));
+		std::string host_list;
+		for (int i = 0; i < nhost; ++i) {
+			if (hosts[i] == nullptr)
+				return fail(HLOP_ERR_ARG, hlop::format("host {} is null", i));
+			host_list += (i == 0 ? "" : ",") + std::string{hosts[i]};
+		}
+		// the processes per node of the placement is the most ranks a host holds
+		std::vector<int> load(nhost, 0);
+		int ppn = 0;
+		for (int i = 0; i < nrank; ++i)
+			if (rank_nodes[i] >= 0 && rank_nodes[i] < nhost)
+				ppn = std::max(ppn, ++load[rank_nodes[i]]);
+		auto res = std::make_unique<hlop_topology>();
+		res->nl = std::make_shared<const hlop::node_list_t>(
+		    static_cast<hlop::platform_t>(pf), host_list, std::max(ppn, 1), std::vector<int>(rank_nodes, rank_nodes + nrank),
+		    std::vector<int>(rank_cores, rank_cores + nrank));
+		*topo = res.release();
+		return HLOP_SUCCESS;
+	});
+}
+
+hlop_status_t hlop_topology_create_regular(hlop_platform_t pf, const char *host_list, int ppn,
+                                           hlop_arrangement_t node_arrange, hlop_arrangement_t core_arrange,
+                                           hlop_topology_t **topo) {
+	return guard([&] {
+		if (topo == nullptr || host_list == nullptr)
+			return fail(HLOP_ERR_ARG, "a pointer argument is null");
+		*topo = nullptr;
+		if (!valid_platform(pf))
+			return fail(HLOP_ERR_ARG, hlop::format("unknown platform: {}", static_cast<int>(pf)));
+		if (!valid_arrangement(node_arrange) || !valid_arrangement(core_arrange))
+			return fail(HLOP_ERR_ARG, hlop::format("unknown rank arrangement: {}/{}", static_cast<int>(node_arrange),
+			                                       static_cast<int>(core_arrange)));
+		if (ppn <= 0)
+			return fail(HLOP_ERR_ARG, hlop::format("number of process per node {} should be greater than 0", ppn));
+		auto res = std::make_unique<hlop_topology>();
+		res->nl = std::make_shared<const hlop::node_list_t>(
+		    static_cast<hlop::platform_t>(pf), host_list, ppn,
+		    hlop::arrangement_t{.node_arrange = static_cast<hlop::rank_arrangement_t>(node_arrange),
+		                        .core_arrange = static_cast<hlop::rank_arrangement_t>(core_arrange)});
+		*topo = res.release();
+		return HLOP_SUCCESS;
+	});
+}
+
+void hlop_topology_free(hlop_topology_t *topo) { delete topo; }
+
+int hlop_topology_ranks(const hlop_topology_t *topo) { return topo == nullptr ? 0 : topo->nl->get_rank_num(); }
+
+hlop_status_t hlop_predict(const hlop_topology_t *topo, hlop_op_t op, hlop_algo_t algo, int msg_size, double *time) {
+	return guard([&] {
+		const hlop::collective *c;
+		if (const auto s = check_query(topo, op, msg_size, c); s != HLOP_SUCCESS)
+			return s;
+		if (time == nullptr)
+			return fail(HLOP_ERR_ARG, "time is null");
+		if (algo < HLOP_ALGO_BINOMIAL || algo > HLOP_ALGO_K_BRUCKS)
+			return fail(HLOP_ERR_ARG, hlop::format("unknown algorithm type: {}", static_cast<int>(algo)));
+
+		const auto key = hlop_topology::key(op, algo, msg_size);
+		hlop_topology::prediction p;
+		if (!find(topo, key, p)) {
+			const auto a = static_cast<hlop::algo_type_t>(algo);
+			// predicted outside of the lock, a prediction made by two threads at once is kept once
+			p = hlop_topology::prediction{a, c->predict(a, *topo->nl, msg_size, 0)};
+			keep(topo, key, p);
+		}
+		*time = p.time;
+		return HLOP_SUCCESS;
+	});
+}
+
+hlop_status_t hlop_best_algo(const hlop_topology_t *topo, hlop_op_t op, int msg_size, hlop_algo_t *algo,
+                             double *time) {
+	return guard([&] {
+		const hlop::collective *c;
+		if (const auto s = check_query(topo, op, msg_size, c); s != HLOP_SUCCESS)
+			return s;
+		if (algo == nullptr)
+			return fail(HLOP_ERR_ARG, "algo is null");
+
+		const auto key = hlop_topology::key(op, hlop_topology::BEST, msg_size);
+		hlop_topology::prediction p;
+		if (!find(topo, key, p)) {
+			// ranked in the calling thread, the library starts no thread of its own for a runtime
+			const auto best = c->select_best(*topo->nl, std::vector<int>{msg_size}, 0, nullptr).front().front();
+			if (best.status != hlop::algo_status::OK)
+				return fail(HLOP_ERR_FAILED, hlop::format("no algorithm of {} can be predicted: {}",
+				                                          hlop::enum_name(static_cast<hlop::op_type_t>(op)), best.reason));
+			p = hlop_topology::prediction{best.algo, best.time};
+			keep(topo, key, p);
+		}
+		*algo = static_cast<hlop_algo_t>(p.algo);
+		if (time != nullptr)
+			*time = p.time;
+		return HLOP_SUCCESS;
+	});
+}
+
+const char *hlop_last_error(void) { return last_error.c_str(); }
@@ -3,6 +3,10 @@
 #include "allgather.h"
 #include "err.h"
 #include "m_debug.h"
+#include "msg.h"
+#include "struct/comm_round.h"
+#include "struct/plan.h"
+#include "struct/symmetric.h"
 #include "struct/type.h"
 
 hlop::allgather::allgather() : hlop::collective() {
@@ -11,37 +15,54 @@ hlop::allgather::allgather() : hlop::collective() {
 
 double hlop::allgather::brucks(const hlop::node_list_t &nl,
                                int msg_size,
-                               const hlop::algo_diff_param_t &dp) {
+                               const hlop::algo_diff_param_t &dp) const {
 	HLOP_ERR("unimplemented algorithm brucks");
 	return 0.0;
 }
 
 double hlop::allgather::k_brucks(const hlop::node_list_t &nl,
                                  int msg_size,
-                                 const hlop::algo_diff_param_t &dp) {
+                                 const hlop::algo_diff_param_t &dp) const {
 	HLOP_ERR("unimplemented algorithm k brucks");
 	return 0.0;
 }
 
 double hlop::allgather::recursive_doubling(const hlop::node_list_t &nl,
                                            int msg_size,
-                                           const hlop::algo_diff_param_t &dp) {
+                                           const hlop::algo_diff_param_t &dp) const {
+	return evaluate(plan_recursive_doubling(nl, dp, {}), msg_size);
+}
+
+hlop::plan_t hlop::allgather::plan_recursive_doubling(const hlop::node_list_t &nl,
+                                                      const hlop::algo_diff_param_t &dp,
+                                                      const hlop::plan_t::round_hook &hook) const {
 	// check if the root is valid
 	if (!std::holds_alternative<int>(dp))
 		HLOP_ERR("invalid algo_diff_param_t for binomial algorithm");
 
 	int root = std::get<int>(dp);
-	double cost = 0.0;
-	const auto &ranks = nl.get_ranks();
+	hlop::plan_t p{hook};
 	int comm_size = nl.get_rank_num(),
 	    mask = 0x01;
+	if (root < 0 || root >= comm_size)
+		HLOP_ERR(hlop::format("root {} is out of the {} ranks", root, comm_size));
+	std::vector<bool> has_value(comm_size);
+	hlop::comm_round_t r;
+
+	// a regular node list is priced from the classes of the pairs, rank & mask == 0 sends to rank + mask
+	if (root == 0 && hlop::is_symmetric(nl)) {
+		for (; mask < comm_size; mask <<= 1)
+			if (!p.add_round(nl, hlop::mask_pattern_t{mask, mask}, mask))
+				break;
+		return p;
+	}
 
 	while (mask < comm_size) {
 		INFO("mask = {}", mask);
 		// generate communication pairs
 		DEBUG("generate communication pairs: ");
-		std::vector<bool> has_value(comm_size, false);
-		std::vector<hlop::comm_pair> p;
+		has_value.assign(comm_size, false);
+		r.clear();
 		for (int rank = 0; rank < comm_size; ++rank) {
 			int relative_rank = (rank >= root) ? (rank - root) : (rank - root + comm_size);
 			int relative_dst = relative_rank ^ mask;
@@ -51,24 +72,24 @@ double hlop::allgather::recursive_doubling(const hlop::node_list_t &nl,
 					continue;
 				has_value[rank] = true;
 				has_value[dst_rank] = true;
-				hlop::comm_pair tcp{nl.get_node_ptr_by_rank(rank), rank,
-				                    nl.get_node_ptr_by_rank(dst_rank), dst_rank};
-				DEBUG("{}", tcp);
-				DEBUG("transport {} bytes from rank {} to rank {}", msg_size, rank, dst_rank);
-				p.emplace_back(std::move(tcp));
+				r.add(nl, rank, dst_rank);
+				DEBUG("{}", r.get_pairs().back());
+				DEBUG("transport {} x the message from rank {} to rank {}", mask, rank, dst_rank);
 			}
 		}
-		DEBUG_VEC("communication pairs: ", p);
-		cost += calc_cost(nl, p, msg_size * mask);
+		DEBUG_VEC("communication pairs: ", r.get_pairs());
+		// every round doubles the message size, the schedule does not depend on it
+		if (!p.add_round(nl, r, mask))
+			break;
 		// next loop
 		mask <<= 1;
 	}
-	return cost;
+	return p;
 }
 
 double hlop::allgather::ring(const hlop::node_list_t &nl,
                              int msg_size,
-                             const hlop::algo_diff_param_t &dp) {
+                             const hlop::algo_diff_param_t &dp) const {
 	HLOP_ERR("unimplemented algorithm ring");
 	return 0.0;
 }
@@ -90,4 +111,22 @@ void hlop::allgather::initialize_ftbl() {
 	             [this](const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) -> double {
 		             return this->ring(nl, msg_size, dp);
 	             }});
+
+	stubs = {hlop::algo_type::BRUCKS,
+	         hlop::algo_type::K_BRUCKS,
+	         hlop::algo_type::RING};
+
+	plan_ftbl.insert({hlop::algo_type::RECURSIVE_DOUBLING,
+	                  [this](const hlop::node_list_t &nl, const hlop::algo_diff_param_t &dp,
+	                         const hlop::plan_t::round_hook &hook) -> hlop::plan_t {
+		                  return this->plan_recursive_doubling(nl, dp, hook);
+	                  }});
+	shape_ftbl.insert({hlop::algo_type::RECURSIVE_DOUBLING,
+	                   [](const hlop::node_list_t &nl) -> std::vector<int> {
+		                   // one round for each mask below comm_size, of mask times the message
+		                   std::vector<int> scales;
+		                   for (int mask = 0x01; mask < nl.get_rank_num(); mask <<= 1)
+			                   scales.push_back(mask);
+		                   return scales;
+	                   }});
 }
\ No newline at end of file
@@ -5,8 +5,11 @@
 #include "collective.h"
 #include "err.h"
 #include "m_debug.h"
-#include "struct/comm_pair.h"
+#include "msg.h"
+#include "struct/comm_round.h"
 #include "struct/node_list.h"
+#include "struct/plan.h"
+#include "struct/symmetric.h"
 #include "struct/type.h"
 
 hlop::bcast::bcast() : hlop::collective() {
@@ -14,26 +17,41 @@ hlop::bcast::bcast() : hlop::collective() {
 }
 
 double hlop::bcast::binomial(const hlop::node_list_t &nl, int msg_size,
-                             const hlop::algo_diff_param_t &dp) {
+                             const hlop::algo_diff_param_t &dp) const {
+	return evaluate(plan_binomial(nl, dp, {}), msg_size);
+}
+
+hlop::plan_t hlop::bcast::plan_binomial(const hlop::node_list_t &nl, const hlop::algo_diff_param_t &dp,
+                                        const hlop::plan_t::round_hook &hook) const {
 	// check if the root is valid
 	if (!std::holds_alternative<int>(dp))
 		HLOP_ERR("invalid algo_diff_param_t for binomial algorithm");
 
 	int root = std::get<int>(dp);
-	double cost = 0.0;
-	const auto &ranks = nl.get_ranks();
+	hlop::plan_t p{hook};
 	int comm_size = nl.get_rank_num(),
 	    mask = hlop::pof2_ceil(comm_size);
+	if (root < 0 || root >= comm_size)
+		HLOP_ERR(hlop::format("root {} is out of the {} ranks", root, comm_size));
 	std::vector<bool> has_value(comm_size, false);
 	has_value[root] = true;
+	hlop::comm_round_t r;
+
+	// a regular node list is priced from the classes of the pairs, rank 0 sends to mask in each round
+	if (root == 0 && hlop::is_symmetric(nl)) {
+		for (mask >>= 1; mask > 0; mask >>= 1)
+			if (!p.add_round(nl, hlop::mask_pattern_t{mask, 1}, 1))
+				break;
+		return p;
+	}
 
-	// simulate the sender procedure
+	// simulate the sender procedure, the schedule does not depend on the message size
 	mask >>= 1;
 	while (mask > 0) {
 		INFO("mask = {}", mask);
 		// generate communication pairs
 		DEBUG("generate communication pairs: ");
-		std::vector<hlop::comm_pair> p;
+		r.clear();
 		for (int rank = 0; rank < comm_size; ++rank) {
 			int relative_rank = (rank >= root) ? (rank - root) : (rank - root + comm_size);
 			if (relative_rank + mask < comm_size && has_value[rank]) {
@@ -42,39 +60,38 @@ double hlop::bcast::binomial(const hlop::node_list_t &nl, int msg_size,
 					dst_rank -= comm_size;
 				if (!has_value[dst_rank]) {
 					has_value[dst_rank] = true;
-					hlop::comm_pair tcp{nl.get_node_ptr_by_rank(rank), rank,
-					                    nl.get_node_ptr_by_rank(dst_rank), dst_rank};
-					DEBUG("{}", tcp);
-					DEBUG("transport {} bytes from rank {} to rank {}", msg_size, rank, dst_rank);
-					p.emplace_back(std::move(tcp));
+					r.add(nl, rank, dst_rank);
+					DEBUG("{}", r.get_pairs().back());
+					DEBUG("transport the message from rank {} to rank {}", rank, dst_rank);
 				}
 			}
 		}
-		DEBUG_VEC("communication pairs: ", p);
-		cost += calc_cost(nl, p, msg_size);
+		DEBUG_VEC("communication pairs: ", r.get_pairs());
+		if (!p.add_round(nl, r, 1))
+			break;
 		// next loop
 		mask >>= 1;
 	}
-	return cost;
+	return p;
 }
 
 double hlop::bcast::scatter_recursive_doubling_allgather(const hlop::node_list_t &nl,
                                                          int msg_size,
-                                                         const hlop::algo_diff_param_t &dp) {
+                                                         const hlop::algo_diff_param_t &dp) const {
 	HLOP_ERR("unimplemented algorithm scatter recursive doubling allgather");
 	return 0.0;
 }
 
 double hlop::bcast::scatter_ring_allgather(const hlop::node_list_t &nl,
                                            int msg_size,
-                                           const hlop::algo_diff_param_t &dp) {
+                                           const hlop::algo_diff_param_t &dp) const {
 	HLOP_ERR("unimplemented algorithm scatter ring allgather");
 	return 0.0;
 }
 
 double hlop::bcast::smp(const hlop::node_list_t &nl,
                         int msg_size,
-                        const hlop::algo_diff_param_t &dp) {
+                        const hlop::algo_diff_param_t &dp) const {
 	HLOP_ERR("unimplemented algorithm smp");
 	return 0.0;
 }
@@ -96,4 +113,22 @@ void hlop::bcast::initialize_ftbl() {
 	             [this](const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) -> double {
 		             return this->smp(nl, msg_size, dp);
 	             }});
+
+	stubs = {hlop::algo_type::SCATTER_RECURSIVE_DOUBLING_ALLGATHER,
+	         hlop::algo_type::SCATTER_RING_ALLGATHER,
+	         hlop::algo_type::SMP};
+
+	plan_ftbl.insert({hlop::algo_type::BINOMIAL,
+	                  [this](const hlop::node_list_t &nl, const hlop::algo_diff_param_t &dp,
+	                         const hlop::plan_t::round_hook &hook) -> hlop::plan_t {
+		                  return this->plan_binomial(nl, dp, hook);
+	                  }});
+	shape_ftbl.insert({hlop::algo_type::BINOMIAL,
+	                   [](const hlop::node_list_t &nl) -> std::vector<int> {
+		                   // one round for each mask below pof2_ceil(comm_size), each of the whole message
+		                   int rounds = 0;
+		                   for (int mask = hlop::pof2_ceil(nl.get_rank_num()) >> 1; mask > 0; mask >>= 1)
+			                   ++rounds;
+		                   return std::vector<int>(rounds, 1);
+	                   }});
 }
\ No newline at end of file
@@ -1,5 +1,15 @@
+#include <algorithm>
+#include <atomic>
 #include <cmath>
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -12,10 +22,121 @@
 #include "msg.h"
 #include "param/param.h"
 #include "resources.h"
-#include "struct/comm_pair.h"
+#include "struct/comm_round.h"
+#include "struct/cost_cache.h"
+#include "struct/plan.h"
+#include "struct/type.h"
+#include "thread_pool.h"
 
-const hlop::param_t hlop::collective::hlop_param_lat{hlop::RESOURCE_BASE + hlop::DF_HLOP_PARAM_LAT};
-const hlop::param_t hlop::collective::hlop_param_bw{hlop::RESOURCE_BASE + hlop::DF_HLOP_PARAM_BW};
+namespace {
+/// @brief the latency parameter file, chosen once.
+const std::string &param_lat_file() {
+	static const std::string file = hlop::param::choose_file(hlop::RESOURCE_BIN_BASE + hlop::DF_HLOP_PARAM_LAT_BIN,
+	                                                         hlop::RESOURCE_BASE + hlop::DF_HLOP_PARAM_LAT);
+	return file;
+}
+
+/// @brief the bandwidth parameter file, chosen once.
+const std::string &param_bw_file() {
+	static const std::string file = hlop::param::choose_file(hlop::RESOURCE_BIN_BASE + hlop::DF_HLOP_PARAM_BW_BIN,
+	                                                         hlop::RESOURCE_BASE + hlop::DF_HLOP_PARAM_BW);
+	return file;
+}
+
+/// @brief interpolation mode set by collective::set_interp_mode, the mode of the parameter file if empty.
+std::optional<hlop::interp_mode_t> interp_override;
+/// @brief whether any parameter file is loaded, the parameters may be loaded by concurrent predictions.
+std::atomic<bool> params_loaded{false};
+
+/**
+ * @brief load a parameter file with the interpolation mode in effect.
+ * @param file string, path to the parameter file, see param::choose_file.
+ * @return param, the loaded parameters.
+ */
+hlop::param_t load_param(const std::string &file) {
+	params_loaded = true;
+	return interp_override.has_value() ? hlop::param_t{file, interp_override.value()}
+	                                   : hlop::param_t{file};
+}
+} // namespace
+
+const hlop::param_t &hlop::collective::hlop_param_lat() {
+	static const hlop::param_t p = load_param(param_lat_file());
+	return p;
+}
+
+const hlop::param_t &hlop::collective::hlop_param_bw() {
+	static const hlop::param_t p = load_param(param_bw_file());
+	return p;
+}
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::algo_rank_t &r) {
+	os << r.algo << ": ";
+	if (r.status == hlop::algo_status::OK)
+		os << r.time;
+	else if (r.status == hlop::algo_status::PRUNED)
+		os << r.status << " > " << r.time;
+	else
+		os << r.status;
+	return os;
+}
+
+hlop::cost_cache_t &hlop::collective::round_cost_cache() {
+	static hlop::cost_cache_t cache{DEFAULT_COST_CACHE_CAPACITY};
+	return cache;
+}
+
+const hlop::cost_cache_stats_t hlop::collective::get_cost_cache_stats() {
+	return round_cost_cache().get_stats();
+}
+
+void hlop::collective::set_cost_cache_capacity(std::size_t capacity) {
+	round_cost_cache().set_capacity(capacity);
+}
+
+hlop::thread_pool_t &hlop::collective::shared_pool() {
+	static hlop::thread_pool_t pool;
+	return pool;
+}
+
+void hlop::collective::set_interp_mode(hlop::interp_mode_t mode) {
+	if (params_loaded)
+		HLOP_ERR("interpolation mode must be set before the first prediction");
+	interp_override = mode;
+}
+
+const std::uint64_t hlop::collective::get_param_fingerprint() {
+	static const std::uint64_t fp = []() {
+		// the mode is part of the fingerprint, it must not change once it is taken
+		params_loaded = true;
+		std::uint64_t h = 14695981039346656037ull;
+		const auto mix = [&h](const char *data, std::size_t n) {
+			for (std::size_t i = 0; i < n; ++i) {
+				h ^= static_cast<unsigned char>(data[i]);
+				h *= 1099511628211ull;
+			}
+		};
+		const auto mix_file = [&mix](const std::string &file) {
+			std::ifstream in{file, std::ios::binary};
+			char buf[65536];
+			while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+				mix(buf, in.gcount());
+			mix("", 1);
+			return in.eof();
+		};
+		for (const auto &file : {param_lat_file(), param_bw_file()}) {
+			// a missing file fails the prediction, not the fingerprint
+			mix_file(file);
+			// a csv is predicted with the curves of its fit file, a binary has them compiled in
+			if (!hlop::param::is_binary(file) && !mix_file(hlop::param::fit_file(file)))
+				mix("#no fit", 8);
+		}
+		const int mode = interp_override.has_value() ? static_cast<int>(interp_override.value()) : -1;
+		mix(reinterpret_cast<const char *>(&mode), sizeof(mode));
+		return h;
+	}();
+	return fp;
+}
 
 hlop::collective::collective()
     : small_scales_param{std::nullopt}, other_param{std::nullopt} {}
@@ -37,6 +158,96 @@ const std::vector<hlop::algo_type> hlop::collective::get_algos() const {
 	return res;
 }
 
+bool hlop::collective::is_implemented(hlop::algo_type algo) const {
+	return has_algo(algo) && stubs.find(algo) == stubs.end();
+}
+
+const std::vector<hlop::algo_rank_t> hlop::collective::select_best(const hlop::node_list_t &nl,
+                                                                   int msg_size,
+                                                                   const hlop::algo_diff_param_t &dp) const {
+	return select_best(nl, std::vector<int>{msg_size}, dp, &shared_pool()).front();
+}
+
+const std::vector<std::vector<hlop::algo_rank_t>> hlop::collective::select_best(const hlop::node_list_t &nl,
+                                                                                const std::vector<int> &msg_sizes,
+                                                                                const hlop::algo_diff_param_t &dp,
+                                                                                hlop::thread_pool_t *pool,
+                                                                                bool prune) const {
+	auto algos = get_algos();
+	std::sort(algos.begin(), algos.end());
+	std::vector<std::vector<double>> times(algos.size());
+	std::vector<std::vector<bool>> pruned(algos.size(), std::vector<bool>(msg_sizes.size(), false));
+	std::vector<std::string> errors(algos.size());
+	// the best cost finished so far of each message size, bounds the others if prune
+	std::vector<double> best(msg_sizes.size(), std::numeric_limits<double>::infinity());
+	std::mutex best_mutex;
+	auto bound = [&](std::size_t s) {
+		std::lock_guard<std::mutex> lock{best_mutex};
+		return best[s];
+	};
+	auto run = [&](std::size_t i) {
+		try {
+			if (!prune) {
+				times[i] = predict(algos[i], nl, msg_sizes, dp);
+				return;
+			}
+			times[i] = predict_bounded(algos[i], nl, msg_sizes, dp, bound, pruned[i]);
+			std::lock_guard<std::mutex> lock{best_mutex};
+			for (std::size_t s = 0; s < msg_sizes.size(); ++s)
+				if (!pruned[i][s])
+					best[s] = std::min(best[s], times[i][s]);
+		} catch (const std::exception &e) {
+			errors[i] = e.what();
+		}
+	};
+
+	// with prune, the cheapest candidates start first so that the bounds tighten early
+	std::vector<std::size_t> order(algos.size());
+	std::iota(order.begin(), order.end(), 0);
+	if (prune) {
+		std::vector<double> lb(algos.size(), 0.0);
+		for (std::size_t i = 0; i < algos.size(); ++i) {
+			const auto b = lower_bound(algos[i], nl, msg_sizes);
+			lb[i] = std::accumulate(b.begin(), b.end(), 0.0);
+		}
+		std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return lb[a] < lb[b]; });
+	}
+	std::vector<std::future<void>> futures;
+	for (const auto i : order) {
+		if (!is_implemented(algos[i]))
+			continue;
+		if (pool != nullptr)
+			futures.emplace_back(pool->submit([&run, i]() { run(i); }));
+		else
+			run(i);
+	}
+	for (auto &f : futures)
+		f.get();
+
+	std::vector<std::vector<hlop::algo_rank_t>> res(msg_sizes.size());
+	for (std::size_t s = 0; s < msg_sizes.size(); ++s) {
+		auto &ranking = res[s];
+		for (std::size_t i = 0; i < algos.size(); ++i) {
+			if (!is_implemented(algos[i]))
+				ranking.push_back(hlop::algo_rank_t{algos[i], hlop::algo_status::UNIMPLEMENTED, 0.0, ""});
+			else if (!errors[i].empty())
+				ranking.push_back(hlop::algo_rank_t{algos[i], hlop::algo_status::FAILED, 0.0, errors[i]});
+			else if (pruned[i][s])
+				ranking.push_back(hlop::algo_rank_t{algos[i], hlop::algo_status::PRUNED, times[i][s], ""});
+			else
+				ranking.push_back(hlop::algo_rank_t{algos[i], hlop::algo_status::OK, times[i][s], ""});
+		}
+		// predicted algorithms first from the fastest, then the pruned ones from the cheapest partial cost,
+		// ties and the others keep the order of algo_type
+		std::stable_sort(ranking.begin(), ranking.end(), [](const auto &a, const auto &b) {
+			if (a.status != b.status)
+				return a.status < b.status;
+			return (a.status == hlop::algo_status::OK || a.status == hlop::algo_status::PRUNED) && a.time < b.time;
+		});
+	}
+	return res;
+}
+
 const double hlop::collective::predict(hlop::algo_type algo,
                                        const hlop::node_list_t &nl,
                                        int msg_size,
@@ -46,43 +257,204 @@ const double hlop::collective::predict(hlop::algo_type algo,
 	return ftbl.at(algo)(nl, msg_size, dp);
 }
 
-const std::map<hlop::comm_pair, int> hlop::collective::get_contentions(const std::vector<hlop::comm_pair> &pairs) const {
-	std::map<hlop::comm_pair, int> res;
-	for (const auto &p : pairs) {
-		const auto &iter = std::find_if(res.begin(), res.end(),
-		                                [&p](const auto &pair) { return pair.first == p; });
-		if (iter != res.end())
-			++iter->second;
-		else
-			res.emplace(p, 1);
+const std::vector<double> hlop::collective::predict(hlop::algo_type algo,
+                                                    const hlop::node_list_t &nl,
+                                                    const std::vector<int> &msg_sizes,
+                                                    const hlop::algo_diff_param_t &dp) const {
+	if (has_plan(algo))
+		return evaluate(make_plan(algo, nl, dp), msg_sizes);
+	std::vector<double> res;
+	res.reserve(msg_sizes.size());
+	for (const auto &m : msg_sizes)
+		res.emplace_back(predict(algo, nl, m, dp));
+	return res;
+}
+
+const std::vector<double> hlop::collective::predict(hlop::algo_type algo,
+                                                    const hlop::node_list_t &nl,
+                                                    const std::vector<int> &msg_sizes,
+                                                    const hlop::algo_diff_param_t &dp,
+                                                    const std::vector<double> &bounds) const {
+	if (bounds.size() != msg_sizes.size())
+		HLOP_ERR(hlop::format("{} bounds given for {} message sizes", bounds.size(), msg_sizes.size()));
+	std::vector<bool> pruned;
+	return predict_bounded(algo, nl, msg_sizes, dp, [&bounds](std::size_t s) { return bounds[s]; }, pruned);
+}
+
+const std::vector<double> hlop::collective::predict_bounded(hlop::algo_type algo,
+                                                            const hlop::node_list_t &nl,
+                                                            const std::vector<int> &msg_sizes,
+                                                            const hlop::algo_diff_param_t &dp,
+                                                            const std::function<double(std::size_t)> &bound,
+                                                            std::vector<bool> &pruned) const {
+	const std::size_t n = msg_sizes.size();
+	pruned.assign(n, false);
+	if (!has_plan(algo)) {
+		auto cost = predict(algo, nl, msg_sizes, dp);
+		for (std::size_t i = 0; i < n; ++i)
+			pruned[i] = cost[i] > bound(i);
+		return cost;
 	}
+
+	// price each round as soon as it is simulated, a message size above its bound is not priced any more
+	std::vector<double> cost(n, 0.0);
+	std::vector<std::size_t> live(n);
+	std::iota(live.begin(), live.end(), 0);
+	auto hook = [&](const hlop::plan_t &p) {
+		accumulate(p, p.get_rounds().back(), msg_sizes, live, cost);
+		std::size_t k = 0;
+		for (const auto i : live) {
+			if (cost[i] > bound(i))
+				pruned[i] = true;
+			else
+				live[k++] = i;
+		}
+		live.resize(k);
+		return !live.empty();
+	};
+	plan_ftbl.at(algo)(nl, dp, hook);
+	return cost;
+}
+
+const std::vector<double> hlop::collective::lower_bound(hlop::algo_type algo,
+                                                        const hlop::node_list_t &nl,
+                                                        const std::vector<int> &msg_sizes) const {
+	// the cheapest latency of any category at each power of 2 of the parameters
+	static const std::vector<double> floor_lat = [] {
+		const auto &lat = hlop_param_lat();
+		std::vector<double> res(lat.get_msg_size_range().size(), std::numeric_limits<double>::infinity());
+		for (const auto &c : lat.get_categorys()) {
+			const auto y = lat.get_category_params(std::string{c});
+			for (std::size_t i = 0; i < res.size() && i < y.size(); ++i)
+				res[i] = std::min(res[i], y[i]);
+		}
+		return res;
+	}();
+	const auto &x = hlop_param_lat().get_msg_size_range();
+
+	std::vector<double> res(msg_sizes.size(), 0.0);
+	const auto it = shape_ftbl.find(algo);
+	if (it == shape_ftbl.end() || floor_lat.empty())
+		return res;
+	const auto scales = it->second(nl);
+	for (std::size_t i = 0; i < msg_sizes.size(); ++i)
+		for (const auto scale : scales) {
+			const double e = std::log2(std::max(1.0, static_cast<double>(msg_sizes[i]) * scale));
+			const std::size_t b = std::upper_bound(x.begin(), x.end(), e) - x.begin();
+			res[i] += floor_lat[b == 0 ? 0 : b - 1];
+		}
 	return res;
 }
 
+bool hlop::collective::has_plan(hlop::algo_type algo) const {
+	return plan_ftbl.find(algo) != plan_ftbl.end();
+}
+
+const hlop::plan_t hlop::collective::make_plan(hlop::algo_type algo,
+                                               const hlop::node_list_t &nl,
+                                               const hlop::algo_diff_param_t &dp) const {
+	if (!has_algo(algo))
+		HLOP_ERR(hlop::format("this operation do not have algorithm {}", algo));
+	if (!has_plan(algo))
+		HLOP_ERR(hlop::format("the schedule of algorithm {} depends on the message size, it can not be planned", algo));
+	return plan_ftbl.at(algo)(nl, dp, {});
+}
+
+const double hlop::collective::evaluate(const hlop::plan_t &p, int msg_size) const {
+	return evaluate(p, std::vector<int>{msg_size}).front();
+}
+
+const std::vector<double> hlop::collective::evaluate(const hlop::plan_t &p, const std::vector<int> &msg_sizes) const {
+	std::vector<double> cost(msg_sizes.size(), 0.0);
+	std::vector<std::size_t> live(msg_sizes.size());
+	std::iota(live.begin(), live.end(), 0);
+	for (const auto &r : p.get_rounds())
+		accumulate(p, r, msg_sizes, live, cost);
+	return cost;
+}
+
+void hlop::collective::accumulate(const hlop::plan_t &p,
+                                  const hlop::plan_round_t &r,
+                                  const std::vector<int> &msg_sizes,
+                                  const std::vector<std::size_t> &live,
+                                  std::vector<double> &cost) const {
+	DEBUG("round x{}: {} groups", r.scale, r.end - r.begin);
+	if (r.begin == r.end)
+		return;
+	// the bandwidth term only applies to large messages, unless the node list is small
+	const bool all_bw = p.get_node_num() < 4;
+	const void *param_set = &hlop_param_lat();
+	auto &cache = round_cost_cache();
+	const auto &groups = p.get_groups();
+	// only the message sizes whose round cost is not cached are priced, in batch
+	std::vector<int> round_sizes;
+	std::vector<std::size_t> missed;
+	for (const auto i : live) {
+		double c;
+		if (cache.find(&groups[r.begin], r.end - r.begin, msg_sizes[i] * r.scale, all_bw, param_set, c)) {
+			cost[i] += c;
+			continue;
+		}
+		missed.push_back(i);
+		round_sizes.push_back(msg_sizes[i] * r.scale);
+	}
+	const std::size_t m = missed.size();
+	if (m == 0)
+		return;
+	const bool any_bw = all_bw || std::any_of(round_sizes.begin(), round_sizes.end(), [](int s) { return s > 8192; });
+	std::vector<double> max_cost(m, 0.0), cost_lat(m), cost_bw(m);
+	for (std::size_t g = r.begin; g < r.end; ++g) {
+		const auto &key = groups[g].key;
+		hlop_param_lat().get_param_batch(round_sizes.data(), m, key, cost_lat.data());
+		if (any_bw)
+			hlop_param_bw().get_param_batch(round_sizes.data(), m, key, cost_bw.data());
+		for (std::size_t i = 0; i < m; ++i) {
+			double tmp_cost = cost_lat[i];
+			if (all_bw || round_sizes[i] > 8192)
+				tmp_cost += round_sizes[i] / cost_bw[i];
+			max_cost[i] = std::max(tmp_cost, max_cost[i]);
+		}
+	}
+	for (std::size_t i = 0; i < m; ++i) {
+		const double c = std::round(max_cost[i] * 100) / 100.0;
+		cache.insert(&groups[r.begin], r.end - r.begin, round_sizes[i], all_bw, param_set, c);
+		cost[missed[i]] += c;
+	}
+}
+
 const double hlop::collective::calc_cost(const hlop::node_list_t &nl,
-                                         const std::vector<hlop::comm_pair> &pairs,
+                                         hlop::comm_round_t &r,
                                          int msg_size) const {
 	INFO("calculate contention: ");
+	std::vector<hlop::plan_group_t> groups;
+	hlop::plan::append_histogram(nl, r, groups);
+	DEBUG("{} distinct contended links", groups.size());
+	return calc_cost(nl, groups, msg_size);
+}
+
+const double hlop::collective::calc_cost(const hlop::node_list_t &nl,
+                                         const std::vector<hlop::plan_group_t> &groups,
+                                         int msg_size) const {
+	const bool all_bw = nl.get_node_num() < 4;
+	const void *param_set = &hlop_param_lat();
+	double cost;
+	if (round_cost_cache().find(groups.data(), groups.size(), msg_size, all_bw, param_set, cost)) {
+		INFO("cached cost: {}", cost);
+		return cost;
+	}
 	double max_cost = 0.0;
-	const auto contention = get_contentions(pairs);
-	DEBUG_MAP("contentions", contention);
-	for (const auto &c : contention) {
-		const auto &cp = c.first;
-		INFO("{}", cp);
-		int nc = c.second;
-		INFO("contention: {}", nc);
-		const auto &param_category = param::get_category_with_labels(
-		    cp.is_intra_node_pair() ? "L0" : "L1",
-		    std::to_string(nl.get_level(cp)),
-		    std::to_string(nc));
-		double tmp_cost_lat = hlop_param_lat.get_param(msg_size, param_category),
+	for (const auto &g : groups) {
+		INFO("{} x {} links", g.key, g.links);
+		double tmp_cost_lat = hlop_param_lat().get_param(msg_size, g.key),
 		       tmp_cost_bw = 0.0;
-		if (/*cp.is_inter_node_pair() && */ msg_size > 8192 || nl.get_node_num() < 4)
-			tmp_cost_bw = msg_size / hlop_param_bw.get_param(msg_size, param_category);
+		if (/*cp.is_inter_node_pair() && */ msg_size > 8192 || all_bw)
+			tmp_cost_bw = msg_size / hlop_param_bw().get_param(msg_size, g.key);
 
 		double tmp_cost = tmp_cost_lat + tmp_cost_bw;
 		INFO("cost: {}", tmp_cost);
 		max_cost = std::max(tmp_cost, max_cost);
 	}
-	return std::round(max_cost * 100) / 100.0;
+	cost = std::round(max_cost * 100) / 100.0;
+	round_cost_cache().insert(groups.data(), groups.size(), msg_size, all_bw, param_set, cost);
+	return cost;
 }
@@ -0,0 +1,33 @@
+#include <memory>
+#include <vector>
+
+#include "allgather.h"
+#include "aux.h"
+#include "bcast.h"
+#include "collective.h"
+#include "err.h"
+#include "factory.h"
+#include "msg.h"
+#include "scatter.h"
+#include "struct/type.h"
+
+const std::vector<hlop::op_type_t> &hlop::get_collective_ops() {
+	static const std::vector<hlop::op_type_t> ops{hlop::op_type::ALLGATHER, hlop::op_type::BCAST,
+	                                              hlop::op_type::SCATTER};
+	return ops;
+}
+
+std::unique_ptr<hlop::collective> hlop::make_collective(hlop::op_type_t op) {
+	switch (op) {
+	case hlop::op_type::ALLGATHER:
+		return std::make_unique<hlop::allgather>();
+	case hlop::op_type::BCAST:
+		return std::make_unique<hlop::bcast>();
+	case hlop::op_type::SCATTER:
+		return std::make_unique<hlop::scatter>();
+	default:
+		HLOP_ERR(hlop::format("unsupported operation type: {}", hlop::enum_name(op)));
+		break;
+	}
+	return nullptr; // unreachable
+}
@@ -0,0 +1,178 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "collective.h"
+#include "disk_cache.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "prediction_cache.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+namespace {
+constexpr std::uint64_t BEST_ALGO = 0xff;
+
+/**
+ * @brief two FNV-1a hashes of different offsets, a 128-bit hash of the words mixed into it.
+ */
+class hasher {
+public:
+	void mix(const void *data, std::size_t n) {
+		const auto *p = static_cast<const unsigned char *>(data);
+		for (std::size_t i = 0; i < n; ++i) {
+			hi = (hi ^ p[i]) * PRIME;
+			lo = (lo ^ p[i]) * PRIME;
+		}
+	}
+	void mix(std::uint64_t v) { mix(&v, sizeof(v)); }
+	void mix(const std::string &s) {
+		mix(s.size());
+		mix(s.data(), s.size());
+	}
+	const hlop::disk_cache_key_t key() const { return hlop::disk_cache_key_t{hi, lo}; }
+
+private:
+	static constexpr std::uint64_t PRIME = 1099511628211ull;
+	std::uint64_t hi = 14695981039346656037ull;
+	std::uint64_t lo = 0x6c62272e07bb0142ull;
+};
+} // namespace
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::prediction_cache_stats_t &s) {
+	const std::uint64_t total = s.hits + s.misses;
+	os << "cache hits: " << s.hits << "/" << total << " (" << (total == 0 ? 0.0 : 100.0 * s.hits / total) << "%)"
+	   << " capacity: " << s.capacity;
+	return os;
+}
+
+hlop::prediction_cache::prediction_cache(const std::string &path, std::size_t capacity)
+    : cache{path, capacity}, param_fp{hlop::collective::get_param_fingerprint()} {}
+
+const hlop::disk_cache_key_t hlop::prediction_cache::fingerprint(const hlop::node_list_t &nl) {
+	hasher h;
+	const auto rule = nl.get_arrangement();
+	h.mix(static_cast<std::uint64_t>(nl.get_platform()));
+	h.mix(static_cast<std::uint64_t>(nl.get_ppn()));
+	h.mix(static_cast<std::uint64_t>(rule.node_arrange));
+	h.mix(static_cast<std::uint64_t>(rule.core_arrange));
+	h.mix(static_cast<std::uint64_t>(nl.get_rank_num()));
+	// the expanded names, the way the list is written does not matter
+	for (const auto &node : nl.get_node_list())
+		h.mix(node->name());
+	if (!nl.is_regular()) {
+		// a rank subset or an explicit placement is not made by the rule alone
+		const int max_rank = nl.get_ppn() * nl.get_node_num();
+		for (int r = 0; r < max_rank; ++r) {
+			if (!nl.has_rank(r))
+				continue;
+			h.mix(static_cast<std::uint64_t>(r));
+			h.mix(static_cast<std::uint64_t>(nl.get_node_id_by_rank(r)));
+			h.mix(static_cast<std::uint64_t>(nl.get_core_id_by_rank(r)));
+		}
+	}
+	return h.key();
+}
+
+const hlop::disk_cache_key_t hlop::prediction_cache::key(const hlop::disk_cache_key_t &topology, hlop::op_type_t op,
+                                                         std::optional<hlop::algo_type_t> algo, int root,
+                                                         int msg_size) const {
+	hasher h;
+	h.mix(topology.hi);
+	h.mix(topology.lo);
+	h.mix(param_fp);
+	h.mix(static_cast<std::uint64_t>(op));
+	h.mix(algo.has_value() ? static_cast<std::uint64_t>(algo.value()) : BEST_ALGO);
+	h.mix(static_cast<std::uint64_t>(root));
+	h.mix(static_cast<std::uint64_t>(msg_size));
+	return h.key();
+}
+
+bool hlop::prediction_cache::find(const hlop::disk_cache_key_t &topology, hlop::op_type_t op,
+                                  std::optional<hlop::algo_type_t> algo, int root, int msg_size,
+                                  hlop::algo_rank_t &r) {
+	hlop::disk_cache_value_t v;
+	if (!cache.find(key(topology, op, algo, root, msg_size), v)) {
+		++misses;
+		return false;
+	}
+	++hits;
+	r.algo = static_cast<hlop::algo_type_t>(v.second & 0xff);
+	r.status = hlop::algo_status::OK;
+	std::memcpy(&r.time, &v.first, sizeof(r.time));
+	r.reason.clear();
+	return true;
+}
+
+void hlop::prediction_cache::insert(const hlop::disk_cache_key_t &topology, hlop::op_type_t op,
+                                    std::optional<hlop::algo_type_t> algo, int root, int msg_size,
+                                    const hlop::algo_rank_t &r) {
+	if (r.status != hlop::algo_status::OK)
+		return;
+	hlop::disk_cache_value_t v{0, static_cast<std::uint64_t>(r.algo)};
+	std::memcpy(&v.first, &r.time, sizeof(r.time));
+	if (!cache.insert(key(topology, op, algo, root, msg_size), v))
+		INFO("prediction of {} bytes dropped, its cache window is busy", msg_size);
+}
+
+const std::vector<double> hlop::prediction_cache::predict(const hlop::collective &c, hlop::op_type_t op,
+                                                          hlop::algo_type_t algo, const hlop::node_list_t &nl,
+                                                          const std::vector<int> &msg_sizes, int root) {
+	const auto topology = fingerprint(nl);
+	std::vector<double> res(msg_sizes.size());
+	std::vector<int> missing;
+	std::vector<std::size_t> missing_at;
+	for (std::size_t i = 0; i < msg_sizes.size(); ++i) {
+		hlop::algo_rank_t r;
+		if (find(topology, op, algo, root, msg_sizes[i], r)) {
+			res[i] = r.time;
+		} else {
+			missing.push_back(msg_sizes[i]);
+			missing_at.push_back(i);
+		}
+	}
+	if (missing.empty())
+		return res;
+	const auto predicted = c.predict(algo, nl, missing, root);
+	for (std::size_t j = 0; j < missing.size(); ++j) {
+		res[missing_at[j]] = predicted[j];
+		insert(topology, op, algo, root, missing[j], hlop::algo_rank_t{algo, hlop::algo_status::OK, predicted[j], ""});
+	}
+	return res;
+}
+
+const std::vector<hlop::algo_rank_t> hlop::prediction_cache::select_best(const hlop::collective &c, hlop::op_type_t op,
+                                                                         const hlop::node_list_t &nl,
+                                                                         const std::vector<int> &msg_sizes,
+                                                                         bool prune, int root) {
+	const auto topology = fingerprint(nl);
+	std::vector<hlop::algo_rank_t> res(msg_sizes.size());
+	std::vector<int> missing;
+	std::vector<std::size_t> missing_at;
+	for (std::size_t i = 0; i < msg_sizes.size(); ++i) {
+		if (!find(topology, op, std::nullopt, root, msg_sizes[i], res[i])) {
+			missing.push_back(msg_sizes[i]);
+			missing_at.push_back(i);
+		}
+	}
+	if (missing.empty())
+		return res;
+	const auto rankings = c.select_best(nl, missing, root, nullptr, prune);
+	for (std::size_t j = 0; j < missing.size(); ++j) {
+		if (rankings[j].empty()) {
+			res[missing_at[j]] = hlop::algo_rank_t{hlop::algo_type_t{}, hlop::algo_status::FAILED, 0.0, "no algorithm"};
+			continue;
+		}
+		res[missing_at[j]] = rankings[j].front();
+		insert(topology, op, std::nullopt, root, missing[j], rankings[j].front());
+	}
+	return res;
+}
+
+const hlop::prediction_cache_stats_t hlop::prediction_cache::get_stats() const {
+	return hlop::prediction_cache_stats_t{hits.load(), misses.load(), cache.capacity()};
+}
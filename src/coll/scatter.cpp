@@ -1,9 +1,14 @@
 #include <vector>
 
 #include "collective.h"
+#include "err.h"
 #include "m_debug.h"
+#include "msg.h"
 #include "scatter.h"
+#include "struct/comm_round.h"
 #include "struct/node_list.h"
+#include "struct/plan.h"
+#include "struct/symmetric.h"
 #include "struct/type.h"
 
 hlop::scatter::scatter() : hlop::collective() {
@@ -12,19 +17,47 @@ hlop::scatter::scatter() : hlop::collective() {
 
 double hlop::scatter::binomial(const hlop::node_list_t &nl,
                                int msg_size,
-                               const hlop::algo_diff_param_t &dp) {
+                               const hlop::algo_diff_param_t &dp) const {
 	if (!std::holds_alternative<int>(dp))
 		HLOP_ERR("invalid algo_diff_param_t for binomial algorithm");
 
 	int root = std::get<int>(dp);
 	double cost = 0.0;
-	const auto &ranks = nl.get_ranks();
 	int comm_size = nl.get_rank_num(),
 	    mask = hlop::pof2_ceil(comm_size),
 	    scatter_size = (msg_size + comm_size - 1) / comm_size;
+	if (root < 0 || root >= comm_size)
+		HLOP_ERR(hlop::format("root {} is out of the {} ranks", root, comm_size));
 	msg_size = msg_size * comm_size / 4;
+
+	// with root 0, every rank below the last receiver, the chain, keeps scatter_size * mask bytes of its subtree,
+	// only the chain may run out of them, so the senders of a round are the ranks of a mask pattern below a limit.
+	// A chain running out of them exactly looks like a rank that has not received yet and is sent to again,
+	// that is left to the simulation below.
+	if (root == 0 && hlop::is_symmetric(nl)) {
+		std::vector<int> limits;
+		int chain = 0, chain_size = msg_size;
+		for (int m = mask >> 1; m > 0 && chain_size != 0; m >>= 1) {
+			limits.push_back(chain_size > 0 ? chain + 1 : chain);
+			if (chain_size > 0 && chain + m < comm_size) {
+				chain_size -= scatter_size * m;
+				chain += m;
+			}
+		}
+		if (chain_size != 0) {
+			std::vector<hlop::plan_group_t> groups;
+			for (int i = 0; i < limits.size(); ++i) {
+				groups.clear();
+				hlop::append_symmetric_histogram(nl, hlop::mask_pattern_t{mask >> (i + 1), 1, limits[i]}, groups);
+				cost += calc_cost(nl, groups, msg_size);
+			}
+			return cost;
+		}
+	}
+
 	std::vector<int> subtree_msg_size(comm_size, 0);
 	subtree_msg_size[root] = msg_size;
+	hlop::comm_round_t r;
 
 	// simulate the sender procedure
 	mask >>= 1;
@@ -32,7 +65,7 @@ double hlop::scatter::binomial(const hlop::node_list_t &nl,
 		INFO("mask = {}", mask);
 		// generate communication pairs
 		DEBUG("generate communication pairs: ");
-		std::vector<hlop::comm_pair> p;
+		r.clear();
 		for (int rank = 0; rank < comm_size; ++rank) {
 			int relative_rank = (rank >= root) ? (rank - root) : (rank - root + comm_size);
 			if (relative_rank + mask < comm_size && subtree_msg_size[rank] > 0) {
@@ -42,16 +75,14 @@ double hlop::scatter::binomial(const hlop::node_list_t &nl,
 				if (subtree_msg_size[dst_rank] == 0) {
 					subtree_msg_size[dst_rank] = subtree_msg_size[rank] - scatter_size * mask;
 					subtree_msg_size[rank] = scatter_size * mask;
-					hlop::comm_pair tcp{nl.get_node_ptr_by_rank(rank), rank,
-					                    nl.get_node_ptr_by_rank(dst_rank), dst_rank};
-					DEBUG("{}", tcp);
+					r.add(nl, rank, dst_rank);
+					DEBUG("{}", r.get_pairs().back());
 					DEBUG("transport {} bytes from rank {} to rank {}", subtree_msg_size[dst_rank], rank, dst_rank);
-					p.emplace_back(std::move(tcp));
 				}
 			}
 		}
-		DEBUG_VEC("communication pairs: ", p);
-		cost += calc_cost(nl, p, msg_size);
+		DEBUG_VEC("communication pairs: ", r.get_pairs());
+		cost += calc_cost(nl, r, msg_size);
 		// next loop
 		mask >>= 1;
 	}
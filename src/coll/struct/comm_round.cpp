@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "struct/comm_round.h"
+#include "struct/flat_pair.h"
+#include "struct/node_list.h"
+
+void hlop::comm_round::clear() { pairs.clear(); }
+
+void hlop::comm_round::add(const hlop::node_list_t &nl, int src_rank, int dst_rank) {
+	pairs.push_back(hlop::flat_pair_t{src_rank, dst_rank,
+	                                  nl.get_node_id_by_rank(src_rank), nl.get_node_id_by_rank(dst_rank),
+	                                  static_cast<std::int16_t>(nl.get_unit_id_by_rank(src_rank)),
+	                                  static_cast<std::int16_t>(nl.get_unit_id_by_rank(dst_rank))});
+}
+
+const std::vector<hlop::flat_pair_t> &hlop::comm_round::get_pairs() const { return pairs; }
+
+const std::vector<hlop::contention_t> &hlop::comm_round::count_contentions(const hlop::node_list_t &nl) {
+	contentions.clear();
+	if (node_entry.size() < nl.get_node_num())
+		node_entry.resize(nl.get_node_num(), -1);
+	// the table is at most half full, it only grows, stale slots are told apart by the stamp
+	std::size_t capacity = std::max<std::size_t>(link_keys.size(), 16);
+	while (capacity < 2 * pairs.size())
+		capacity <<= 1;
+	if (capacity != link_keys.size()) {
+		link_keys.assign(capacity, 0);
+		link_entry.assign(capacity, -1);
+		link_stamp.assign(capacity, 0);
+		stamp = 0;
+	}
+	if (++stamp == 0) {
+		std::fill(link_stamp.begin(), link_stamp.end(), 0);
+		stamp = 1;
+	}
+	const std::size_t mask = capacity - 1;
+
+	for (const auto &p : pairs) {
+		if (p.src_node != p.dst_node) {
+			// inter-node pairs are equal if they link the same two nodes in either direction
+			std::uint64_t key = (static_cast<std::uint64_t>(std::min(p.src_node, p.dst_node)) << 32) |
+			                    static_cast<std::uint32_t>(std::max(p.src_node, p.dst_node));
+			std::size_t h = static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+			while (link_stamp[h] == stamp && link_keys[h] != key)
+				h = (h + 1) & mask;
+			if (link_stamp[h] == stamp) {
+				++contentions[link_entry[h]].count;
+			} else {
+				link_stamp[h] = stamp;
+				link_keys[h] = key;
+				link_entry[h] = contentions.size();
+				contentions.push_back(hlop::contention_t{p, 1});
+			}
+			continue;
+		}
+
+		int &e = node_entry[p.src_node];
+		if (e < 0) {
+			e = contentions.size();
+			contentions.push_back(hlop::contention_t{p, 1});
+			continue;
+		}
+		// one entry per node, a pair that links other units is not counted
+		auto &c = contentions[e];
+		if (std::min(c.pair.src_unit, c.pair.dst_unit) == std::min(p.src_unit, p.dst_unit) &&
+		    std::max(c.pair.src_unit, c.pair.dst_unit) == std::max(p.src_unit, p.dst_unit))
+			++c.count;
+	}
+
+	for (const auto &c : contentions)
+		if (c.pair.src_node == c.pair.dst_node)
+			node_entry[c.pair.src_node] = -1;
+	return contentions;
+}
@@ -0,0 +1,157 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "param/param.h"
+#include "struct/cost_cache.h"
+#include "struct/plan.h"
+
+namespace {
+/**
+ * @brief mix a value into a hash (splitmix64 finalizer).
+ * @param h uint64_t, the hash so far.
+ * @param v uint64_t, the value to mix in.
+ * @return uint64_t, the new hash.
+ */
+std::uint64_t mix(std::uint64_t h, std::uint64_t v) {
+	h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	return h ^ (h >> 31);
+}
+
+bool same_key(const hlop::param_key_t &a, const hlop::param_key_t &b) {
+	return a.cls == b.cls && a.level == b.level && a.contention == b.contention;
+}
+} // namespace
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::cost_cache_stats_t &s) {
+	os << "hits: " << s.hits << " misses: " << s.misses << " size: " << s.size << "/" << s.capacity;
+	return os;
+}
+
+hlop::cost_cache::cost_cache(std::size_t capacity) : capacity(0) {
+	set_capacity(capacity);
+}
+
+std::uint64_t hlop::cost_cache::hash(const hlop::plan_group_t *groups, std::size_t n, int msg_size, bool all_bw,
+                                     const void *param_set) {
+	std::uint64_t h = mix(reinterpret_cast<std::uintptr_t>(param_set), static_cast<std::uint32_t>(msg_size));
+	h = mix(h, (n << 1) | (all_bw ? 1 : 0));
+	for (std::size_t i = 0; i < n; ++i) {
+		const auto &k = groups[i].key;
+		h = mix(h, (static_cast<std::uint64_t>(k.cls) << 48) ^
+		               (static_cast<std::uint64_t>(static_cast<std::uint32_t>(k.level)) << 32) ^
+		               static_cast<std::uint32_t>(k.contention));
+	}
+	return h;
+}
+
+hlop::cost_cache::shard &hlop::cost_cache::shard_of(std::uint64_t h) {
+	return shards[h >> 60 & (NSHARD - 1)];
+}
+
+hlop::cost_cache::entry_iter hlop::cost_cache::lookup(shard &s, std::uint64_t h, const hlop::plan_group_t *groups,
+                                                      std::size_t n, int msg_size, bool all_bw,
+                                                      const void *param_set) {
+	auto range = s.index.equal_range(h);
+	for (auto it = range.first; it != range.second; ++it) {
+		const auto &e = *it->second;
+		if (e.msg_size != msg_size || e.all_bw != all_bw || e.param_set != param_set || e.keys.size() != n)
+			continue;
+		std::size_t i = 0;
+		while (i < n && same_key(e.keys[i], groups[i].key))
+			++i;
+		if (i == n)
+			return it->second;
+	}
+	return s.lru.end();
+}
+
+bool hlop::cost_cache::find(const hlop::plan_group_t *groups, std::size_t n, int msg_size, bool all_bw,
+                            const void *param_set, double &cost) {
+	const std::uint64_t h = hash(groups, n, msg_size, all_bw, param_set);
+	auto &s = shard_of(h);
+	std::unique_lock<std::mutex> lock{s.mtx};
+	auto it = lookup(s, h, groups, n, msg_size, all_bw, param_set);
+	if (it == s.lru.end()) {
+		lock.unlock();
+		misses.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	s.lru.splice(s.lru.begin(), s.lru, it);
+	cost = it->cost;
+	lock.unlock();
+	hits.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void hlop::cost_cache::insert(const hlop::plan_group_t *groups, std::size_t n, int msg_size, bool all_bw,
+                              const void *param_set, double cost) {
+	const std::uint64_t h = hash(groups, n, msg_size, all_bw, param_set);
+	auto &s = shard_of(h);
+	std::lock_guard<std::mutex> lock{s.mtx};
+	if (s.capacity == 0)
+		return;
+	// another thread may have inserted the same round in the meantime
+	auto it = lookup(s, h, groups, n, msg_size, all_bw, param_set);
+	if (it != s.lru.end()) {
+		s.lru.splice(s.lru.begin(), s.lru, it);
+		return;
+	}
+	std::vector<hlop::param_key_t> keys(n);
+	for (std::size_t i = 0; i < n; ++i)
+		keys[i] = groups[i].key;
+	s.lru.push_front(entry{h, std::move(keys), msg_size, all_bw, param_set, cost});
+	s.index.emplace(h, s.lru.begin());
+	shrink(s);
+}
+
+void hlop::cost_cache::shrink(shard &s) {
+	while (s.lru.size() > s.capacity) {
+		auto last = std::prev(s.lru.end());
+		auto range = s.index.equal_range(last->hash);
+		for (auto it = range.first; it != range.second; ++it)
+			if (it->second == last) {
+				s.index.erase(it);
+				break;
+			}
+		s.lru.pop_back();
+	}
+}
+
+void hlop::cost_cache::set_capacity(std::size_t capacity) {
+	this->capacity = capacity;
+	for (std::size_t i = 0; i < NSHARD; ++i) {
+		std::lock_guard<std::mutex> lock{shards[i].mtx};
+		shards[i].capacity = capacity / NSHARD + (i < capacity % NSHARD ? 1 : 0);
+		shrink(shards[i]);
+	}
+}
+
+void hlop::cost_cache::clear() {
+	for (auto &s : shards) {
+		std::lock_guard<std::mutex> lock{s.mtx};
+		s.lru.clear();
+		s.index.clear();
+	}
+	hits = 0;
+	misses = 0;
+}
+
+const hlop::cost_cache_stats_t hlop::cost_cache::get_stats() const {
+	std::size_t size = 0;
+	for (const auto &s : shards) {
+		std::lock_guard<std::mutex> lock{s.mtx};
+		size += s.lru.size();
+	}
+	return hlop::cost_cache_stats_t{hits.load(), misses.load(), size, capacity.load()};
+}
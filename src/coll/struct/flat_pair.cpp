@@ -0,0 +1,9 @@
+#include <iostream>
+
+#include "struct/flat_pair.h"
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::flat_pair_t &p) {
+	os << "flat_pair{ src: node " << p.src_node << "{" << p.src_rank << ", unit " << p.src_unit
+	   << "}; dst: node " << p.dst_node << "{" << p.dst_rank << ", unit " << p.dst_unit << "}; }";
+	return os;
+}
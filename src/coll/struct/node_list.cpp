@@ -1,6 +1,8 @@
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -83,39 +85,140 @@ const hlop::node_list::rank_util_handler hlop::node_list::get_core_id =
 
 hlop::node_list::node_list(hlop::platform_t pf, const std::string &node_list_str, int ppn)
     : nproc_per_node(ppn),
-      platform(pf) {
+      platform(pf),
+      rule{},
+      nrank(0),
+      numa_num(hlop::node_parser::get_numa_num(pf)),
+      ncore_per_numa(hlop::node_parser::get_ncore_per_numa(pf)),
+      ncore_per_unit(hlop::node_parser::get_ncore_per_unit(pf)) {
 	if (ppn > hlop::node_parser::get_ncore_per_node(pf))
 		HLOP_ERR(hlop::format("number of process per node must less equal to {}", ppn));
 	nlist = hlop::node_parser::parse_node_list(pf, node_list_str);
+
+	// intern the group names of every level, the coordinates of nodes in the same group share the field
+	const int nlevel = hlop::node_parser::get_max_node_level(pf);
+	level_bits = 64 / nlevel;
+	if (nlist.size() >= (std::uint64_t{1} << level_bits))
+		HLOP_ERR(hlop::format("number of nodes must less than {}", std::uint64_t{1} << level_bits));
+	node_coord.assign(nlist.size(), 0);
+	for (int l = 0; l < nlevel; ++l) {
+		std::unordered_map<std::string_view, std::uint64_t> groups;
+		const int shift = (nlevel - l - 1) * level_bits;
+		for (int i = 0; i < nlist.size(); ++i) {
+			const auto it = groups.emplace(nlist[i]->get_level_name(l), groups.size()).first;
+			node_coord[i] |= it->second << shift;
+		}
+	}
+
+	// a level is regular if its groups are aligned runs of the same power of 2 nodes
+	const std::uint64_t field_mask = (std::uint64_t{1} << level_bits) - 1;
+	level_span.assign(nlevel, 0);
+	level_span[0] = 1;
+	for (int l = 1; l < nlevel && !level_span.empty(); ++l) {
+		auto group = [&](int i) { return static_cast<int>((node_coord[i] >> (l * level_bits)) & field_mask); };
+		int span = 0;
+		while (span < nlist.size() && group(span) == 0)
+			++span;
+		if (span == nlist.size())
+			continue;
+		level_span[l] = span;
+		if (!hlop::is_pof2(span))
+			level_span.clear();
+		for (int i = span; i < nlist.size() && !level_span.empty(); ++i)
+			if (group(i) != i / span)
+				level_span.clear();
+	}
 }
 
 hlop::node_list::node_list(hlop::platform_t pf, const std::string &node_list_str,
                            int ppn, hlop::arrangement_t rule)
     : node_list(pf, node_list_str, ppn) {
-	int rank_num = ppn * nlist.size();
-	for (int i = 0; i < rank_num; ++i) {
-		int node_id = hlop::node_list::get_node_id(i, rule.node_arrange, *this);
-		int local_rank = hlop::node_list::get_local_rank(i, rule.node_arrange, *this);
-		int core_id = hlop::node_list::get_core_id(local_rank, rule.core_arrange, *this);
-		rmap.emplace(i, nlist.at(node_id));
-		nlist.at(node_id)->bind_core(i, core_id);
-	}
+	// check the arrangement once, every rank is mapped arithmetically on lookup
+	hlop::node_list::get_core_id(hlop::node_list::get_local_rank(0, rule.node_arrange, *this), rule.core_arrange, *this);
+	hlop::node_list::get_node_id(0, rule.node_arrange, *this);
+	this->rule = rule;
+	nrank = ppn * nlist.size();
 }
 
 hlop::node_list::node_list(hlop::platform_t pf, const std::string &node_list_str,
                            int ppn, hlop::arrangement_t rule, std::vector<int> ranks)
     : node_list(pf, node_list_str, ppn) {
-	if ((*std::max_element(ranks.begin(), ranks.end())) > ppn * nlist.size() ||
+	const int rank_num = ppn * nlist.size();
+	if (ranks.empty())
+		HLOP_ERR("ranks should not be empty");
+	if ((*std::max_element(ranks.begin(), ranks.end())) >= rank_num ||
 	    (*std::min_element(ranks.begin(), ranks.end())) < 0)
-		HLOP_ERR(hlop::format("ranks should be in range [0, {})", ppn * nlist.size()));
-	for (int i = 0; i < ranks.size(); ++i) {
-		int rank = ranks.at(i);
+		HLOP_ERR(hlop::format("ranks should be in range [0, {})", rank_num));
+	this->rule = rule;
+	rank_node.assign(rank_num, -1);
+	rank_core.assign(rank_num, -1);
+	rank_unit.assign(rank_num, -1);
+	for (int rank : ranks) {
+		if (rank_node[rank] >= 0)
+			HLOP_ERR(hlop::format("rank {} is already bound to core {}", rank, rank_core[rank]));
 		int node_id = hlop::node_list::get_node_id(rank, rule.node_arrange, *this);
 		int local_rank = hlop::node_list::get_local_rank(rank, rule.node_arrange, *this);
 		int core_id = hlop::node_list::get_core_id(local_rank, rule.core_arrange, *this);
-		rmap.emplace(rank, nlist.at(node_id));
-		nlist.at(node_id)->bind_core(rank, core_id);
+		rank_node[rank] = node_id;
+		rank_core[rank] = core_id;
+		rank_unit[rank] = core_id / ncore_per_unit;
+	}
+	nrank = ranks.size();
+}
+
+hlop::node_list::node_list(hlop::platform_t pf, const std::string &node_list_str, int ppn,
+                           const std::vector<int> &rank_nodes, const std::vector<int> &rank_cores)
+    : node_list(pf, node_list_str, ppn) {
+	if (rank_nodes.empty() || rank_nodes.size() != rank_cores.size())
+		HLOP_ERR(hlop::format("rank nodes and rank cores should be non-empty and of the same size, not {} and {}",
+		                      rank_nodes.size(), rank_cores.size()));
+	const int rank_num = ppn * nlist.size(), ncore = hlop::node_parser::get_ncore_per_node(pf);
+	if (rank_nodes.size() > rank_num)
+		HLOP_ERR(hlop::format("{} ranks do not fit in {} nodes of {} processes", rank_nodes.size(), nlist.size(), ppn));
+	rule = hlop::arrangement_t{.node_arrange = hlop::rank_arrangement::ARBITRARY,
+	                           .core_arrange = hlop::rank_arrangement::ARBITRARY};
+	rank_node.assign(rank_num, -1);
+	rank_core.assign(rank_num, -1);
+	rank_unit.assign(rank_num, -1);
+	std::vector<int> load(nlist.size(), 0);
+	std::vector<int> owner(nlist.size() * ncore, -1); // the rank bound to each core of each node
+	for (int rank = 0; rank < rank_nodes.size(); ++rank) {
+		const int node_id = rank_nodes[rank], core_id = rank_cores[rank];
+		if (node_id < 0 || node_id >= nlist.size())
+			HLOP_ERR(hlop::format("rank {} is placed on node {} not in range [0, {})", rank, node_id, nlist.size()));
+		if (core_id < 0 || core_id >= ncore)
+			HLOP_ERR(hlop::format("rank {} is bound to core {} not in range [0, {})", rank, core_id, ncore));
+		if (++load[node_id] > ppn)
+			HLOP_ERR(hlop::format("node {} holds more than {} ranks", nlist[node_id]->name(), ppn));
+		int &o = owner[node_id * ncore + core_id];
+		if (o >= 0)
+			HLOP_ERR(hlop::format("rank {} is bound to core {} of node {}, as rank {}", rank, core_id,
+			                      nlist[node_id]->name(), o));
+		o = rank;
+		rank_node[rank] = node_id;
+		rank_core[rank] = core_id;
+		rank_unit[rank] = core_id / ncore_per_unit;
 	}
+	nrank = rank_nodes.size();
+}
+
+void hlop::node_list::map_rank(int rank, int &node_id, int &core_id) const {
+	int local_rank;
+	if (rule.node_arrange == hlop::rank_arrangement::BLOCK)
+		node_id = rank / nproc_per_node, local_rank = rank % nproc_per_node;
+	else
+		node_id = rank % nlist.size(), local_rank = rank / nlist.size();
+	if (rule.core_arrange == hlop::rank_arrangement::BLOCK)
+		core_id = local_rank;
+	else
+		core_id = (local_rank % numa_num) * ncore_per_numa + local_rank / numa_num;
+}
+
+const int hlop::node_list::get_net_level(int node1, int node2) const {
+	const std::uint64_t diff = node_coord[node1] ^ node_coord[node2];
+	if (diff == 0)
+		HLOP_ERR(hlop::format("undefined net level between {} and {}", nlist[node1]->name(), nlist[node2]->name()));
+	return (63 - __builtin_clzll(diff)) / level_bits;
 }
 
 const hlop::platform_t hlop::node_list::get_platform() const { return platform; }
@@ -126,33 +229,69 @@ const int hlop::node_list::get_node_num() const { return nlist.size(); }
 
 const std::vector<hlop::const_node_ptr> &hlop::node_list::get_node_list() const { return nlist; }
 
-const int hlop::node_list::get_rank_num() const { return rmap.size(); }
+const int hlop::node_list::get_rank_num() const { return nrank; }
 
-const std::unordered_map<int, hlop::const_node_ptr> &hlop::node_list::get_ranks() const { return rmap; }
+const hlop::arrangement_t hlop::node_list::get_arrangement() const { return rule; }
+
+const bool hlop::node_list::is_regular() const { return rank_node.empty(); }
+
+const std::vector<int> &hlop::node_list::get_level_spans() const { return level_span; }
+
+const bool hlop::node_list::has_rank(int rank) const {
+	if (rank < 0 || rank >= nproc_per_node * static_cast<int>(nlist.size()))
+		return false;
+	return rank_node.empty() || rank_node[rank] >= 0;
+}
 
 const int hlop::node_list::get_level(int rank1, int rank2) const {
-	const auto &node1 = get_node_by_rank(rank1);
-	const auto &node2 = get_node_by_rank(rank2);
+	int node1 = get_node_id_by_rank(rank1), node2 = get_node_id_by_rank(rank2);
 	if (node1 == node2)
-		return node1.get_core_level(rank1, rank2);
-	else
-		return node1 - node2;
-	HLOP_ERR(hlop::format("undefined net level between {} and {}", node1.name(), node2.name()));
-	return -1; // unreachable
+		return nlist[node1]->get_unit_level(get_unit_id_by_rank(rank1), get_unit_id_by_rank(rank2));
+	return get_net_level(node1, node2);
 }
 
 const int hlop::node_list::get_level(const hlop::comm_pair_t &cp) const {
 	return get_level(cp.get_src_rank(), cp.get_dst_rank());
 }
 
+const int hlop::node_list::get_level(const hlop::flat_pair_t &fp) const {
+	if (fp.src_node == fp.dst_node)
+		return nlist[fp.src_node]->get_unit_level(fp.src_unit, fp.dst_unit);
+	return get_net_level(fp.src_node, fp.dst_node);
+}
+
 const hlop::node_t &hlop::node_list::get_node_by_rank(int rank) const {
 	return *get_node_ptr_by_rank(rank);
 }
 
 hlop::const_node_ptr_t hlop::node_list::get_node_ptr_by_rank(int rank) const {
-	if (rmap.find(rank) == rmap.end())
+	return nlist[get_node_id_by_rank(rank)];
+}
+
+const int hlop::node_list::get_node_id_by_rank(int rank) const {
+	if (!has_rank(rank))
 		HLOP_ERR(hlop::format("rank {} not in this list", rank));
-	return rmap.at(rank);
+	if (!rank_node.empty())
+		return rank_node[rank];
+	int node_id, core_id;
+	map_rank(rank, node_id, core_id);
+	return node_id;
+}
+
+const int hlop::node_list::get_core_id_by_rank(int rank) const {
+	if (!has_rank(rank))
+		HLOP_ERR(hlop::format("rank {} not in this list", rank));
+	if (!rank_core.empty())
+		return rank_core[rank];
+	int node_id, core_id;
+	map_rank(rank, node_id, core_id);
+	return core_id;
+}
+
+const int hlop::node_list::get_unit_id_by_rank(int rank) const {
+	if (!rank_unit.empty() && has_rank(rank))
+		return rank_unit[rank];
+	return get_core_id_by_rank(rank) / ncore_per_unit;
 }
 
 const std::vector<hlop::const_node_ptr> hlop::node_list::get_top_k_nodes(int k) const {
@@ -165,7 +304,8 @@ std::ostream &hlop::operator<<(std::ostream &os, const node_list &nl) {
 	const std::string snl = hlop::vtos(nl.get_node_list());
 	os << snl;
 #ifdef M_DEBUG_VERBOSE
-	os << "{ " << hlop::mtos(nl.get_ranks()) << " }"
+	os << " ranks: " << nl.get_rank_num()
+	   << " arrangement: " << nl.get_arrangement().node_arrange << "/" << nl.get_arrangement().core_arrange
 	   << " ppn: " << nl.get_ppn()
 	   << " platform: " << hlop::platform_to_string(nl.get_platform());
 #endif
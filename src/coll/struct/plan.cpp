@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "err.h"
+#include "msg.h"
+#include "param/param.h"
+#include "struct/comm_round.h"
+#include "struct/node_list.h"
+#include "struct/plan.h"
+#include "struct/symmetric.h"
+
+void hlop::plan::append_histogram(const hlop::node_list_t &nl, hlop::comm_round_t &r,
+                                  std::vector<hlop::plan_group_t> &groups) {
+	const std::size_t begin = groups.size();
+	for (const auto &c : r.count_contentions(nl))
+		groups.push_back(hlop::plan_group_t{{c.pair.is_intra_node_pair() ? hlop::link_class::L0 : hlop::link_class::L1,
+		                                     nl.get_level(c.pair),
+		                                     c.count},
+		                                    1});
+	// links with the same key cost the same, keep one group of each key in canonical order
+	auto key_of = [](const hlop::plan_group_t &g) {
+		return std::make_tuple(static_cast<int>(g.key.cls), g.key.level, g.key.contention);
+	};
+	std::sort(groups.begin() + begin, groups.end(),
+	          [&](const auto &a, const auto &b) { return key_of(a) < key_of(b); });
+	std::size_t end = begin;
+	for (std::size_t i = begin; i < groups.size(); ++i) {
+		if (end > begin && key_of(groups[end - 1]) == key_of(groups[i]))
+			groups[end - 1].links += groups[i].links;
+		else
+			groups[end++] = groups[i];
+	}
+	groups.resize(end);
+}
+
+hlop::plan::plan(round_hook hook) : hook{std::move(hook)} {}
+
+bool hlop::plan::add_round(const hlop::node_list_t &nl, hlop::comm_round_t &r, int scale) {
+	if (!rounds.empty() && node_num != nl.get_node_num())
+		HLOP_ERR(hlop::format("round of {} nodes added to a plan of {} nodes", nl.get_node_num(), node_num));
+	node_num = nl.get_node_num();
+	const std::size_t begin = groups.size();
+	append_histogram(nl, r, groups);
+	rounds.push_back(hlop::plan_round_t{begin, groups.size(), scale});
+	return !hook || hook(*this);
+}
+
+bool hlop::plan::add_round(const hlop::node_list_t &nl, const hlop::mask_pattern_t &mp, int scale) {
+	if (!rounds.empty() && node_num != nl.get_node_num())
+		HLOP_ERR(hlop::format("round of {} nodes added to a plan of {} nodes", nl.get_node_num(), node_num));
+	node_num = nl.get_node_num();
+	const std::size_t begin = groups.size();
+	hlop::append_symmetric_histogram(nl, mp, groups);
+	rounds.push_back(hlop::plan_round_t{begin, groups.size(), scale});
+	return !hook || hook(*this);
+}
+
+const std::vector<hlop::plan_round_t> &hlop::plan::get_rounds() const { return rounds; }
+
+const std::vector<hlop::plan_group_t> &hlop::plan::get_groups() const { return groups; }
+
+const int hlop::plan::get_node_num() const { return node_num; }
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::plan_t &p) {
+	const auto &groups = p.get_groups();
+	for (const auto &r : p.get_rounds()) {
+		os << "{ x" << r.scale << ":";
+		for (std::size_t i = r.begin; i < r.end; ++i)
+			os << " " << groups[i].key << "*" << groups[i].links;
+		os << " }";
+	}
+	return os;
+}
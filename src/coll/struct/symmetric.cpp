@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <vector>
+
+#include "aux.h"
+#include "err.h"
+#include "msg.h"
+#include "param/param.h"
+#include "struct/node_list.h"
+#include "struct/plan.h"
+#include "struct/symmetric.h"
+#include "struct/type.h"
+
+bool hlop::is_symmetric(const hlop::node_list_t &nl) {
+	return nl.is_regular() &&
+	       nl.get_arrangement().node_arrange == hlop::rank_arrangement::BLOCK &&
+	       hlop::is_pof2(nl.get_ppn()) &&
+	       !nl.get_level_spans().empty();
+}
+
+void hlop::append_symmetric_histogram(const hlop::node_list_t &nl, const hlop::mask_pattern_t &mp,
+                                      std::vector<hlop::plan_group_t> &groups) {
+	if (!hlop::is_symmetric(nl))
+		HLOP_ERR("the node list is not symmetric");
+	if (mp.mask < 1 || mp.len < 1 || !hlop::is_pof2(mp.mask) || !hlop::is_pof2(mp.len) || mp.len > mp.mask || mp.limit < 0)
+		HLOP_ERR(hlop::format("invalid mask pattern, mask {} len {} limit {}", mp.mask, mp.len, mp.limit));
+	const int ppn = nl.get_ppn(),
+	          node_num = nl.get_node_num();
+	// a full and a partial class of the same key are one group, the partial one is the cut by the limit
+	auto append = [&](const hlop::param_key_t &key, int links, const hlop::param_key_t &partial_key, int partial_links) {
+		if (links > 0 && partial_links > 0 && key.contention == partial_key.contention) {
+			links += partial_links;
+			partial_links = 0;
+		}
+		if (links > 0 && partial_links > 0 && partial_key.contention < key.contention)
+			groups.push_back(hlop::plan_group_t{partial_key, partial_links}), partial_links = 0;
+		if (links > 0)
+			groups.push_back(hlop::plan_group_t{key, links});
+		if (partial_links > 0)
+			groups.push_back(hlop::plan_group_t{partial_key, partial_links});
+	};
+
+	if (mp.mask < ppn) {
+		// 2 * mask divides ppn, every node below the limit holds the same pairs, its first pair is (0, mask),
+		// the node of the limit only holds the pairs below it
+		const int u1 = nl.get_unit_id_by_rank(0), u2 = nl.get_unit_id_by_rank(mp.mask);
+		auto count_below = [&](int local_limit) {
+			int count = 0;
+			for (int rank = 0; rank < ppn; rank += 2 * mp.mask)
+				for (int i = rank; i < rank + mp.len && i < local_limit; ++i) {
+					const int v1 = nl.get_unit_id_by_rank(i), v2 = nl.get_unit_id_by_rank(i + mp.mask);
+					if (std::min(u1, u2) == std::min(v1, v2) && std::max(u1, u2) == std::max(v1, v2))
+						++count;
+				}
+			return count;
+		};
+		const int full = std::min(node_num, mp.limit / ppn),
+		          rest = full < node_num ? mp.limit % ppn : 0,
+		          level = nl.get_level(0, mp.mask);
+		append({hlop::link_class::L0, level, full > 0 ? count_below(ppn) : 0}, full,
+		       {hlop::link_class::L0, level, rest > 0 ? count_below(rest) : 0}, rest > 0 ? 1 : 0);
+		return;
+	}
+
+	// ppn divides mask, node n sends to node n + dist if n % (2 * dist) < nlen, min(len, ppn) pairs on each link,
+	// a sender node whose pairs are not all below the limit holds the rest of them
+	const int dist = mp.mask / ppn,
+	          nlen = std::max(1, mp.len / ppn),
+	          npair = std::min(mp.len, ppn),
+	          senders = node_num - dist;
+	if (senders <= 0)
+		return;
+	auto count_senders = [&](long long n) -> int {
+		return n <= 0 ? 0 : n / (2 * dist) * nlen + std::min<long long>(n % (2 * dist), nlen);
+	};
+	const long long full_end = mp.limit >= npair ? (static_cast<long long>(mp.limit) - npair) / ppn + 1 : 0,
+	                full = std::min<long long>(full_end, senders);
+	const int partial = full < senders && full % (2 * dist) < nlen && full * ppn < mp.limit
+	                        ? static_cast<int>(mp.limit - full * ppn)
+	                        : 0;
+	// a link crosses the groups of every level whose span is at most dist and no other,
+	// since a sender is in the first half of an aligned run of 2 * dist nodes
+	const auto &spans = nl.get_level_spans();
+	int level = 0;
+	for (int l = 1; l < spans.size(); ++l)
+		if (spans[l] != 0 && spans[l] <= dist)
+			level = l;
+	append({hlop::link_class::L1, level, npair}, count_senders(full),
+	       {hlop::link_class::L1, level, partial}, partial > 0 ? 1 : 0);
+}
@@ -16,4 +16,8 @@ std::ostream &hlop::operator<<(std::ostream &os, const algo_type_t &algo) {
 std::ostream &hlop::operator<<(std::ostream &os, const rank_arrangement_t &ra) {
 	os << hlop::enum_name(ra);
 	return os;
-}
\ No newline at end of file
+}
+std::ostream &hlop::operator<<(std::ostream &os, const algo_status_t &status) {
+	os << hlop::enum_name(status);
+	return os;
+}
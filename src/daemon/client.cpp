@@ -0,0 +1,71 @@
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client.h"
+#include "err.h"
+#include "msg.h"
+#include "protocol.h"
+
+hlop::hlopd_client::hlopd_client(const std::string &socket_path) {
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path))
+		HLOP_ERR(hlop::format("socket path {} is longer than {}", socket_path, sizeof(addr.sun_path) - 1));
+	std::strcpy(addr.sun_path, socket_path.c_str());
+	fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		HLOP_ERR(hlop::format("cannot create socket: {}", std::strerror(errno)));
+	if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0) {
+		const int err = errno;
+		::close(fd);
+		HLOP_ERR(hlop::format("cannot connect to {}: {}", socket_path, std::strerror(err)));
+	}
+}
+
+hlop::hlopd_client::~hlopd_client() { ::close(fd); }
+
+const hlop::hlopd_response_t hlop::hlopd_client::request(hlop::hlopd_request_t req) {
+	req.tag = next_tag++;
+	std::string buf;
+	hlop::encode_request(req, buf);
+	for (std::size_t sent = 0; sent < buf.size();) {
+		const ssize_t n = ::send(fd, buf.data() + sent, buf.size() - sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+			HLOP_ERR(hlop::format("cannot send to hlopd: {}", std::strerror(errno)));
+		sent += n;
+	}
+
+	hlop::hlopd_response_t res;
+	std::size_t used;
+	char chunk[4096];
+	while (!hlop::decode_response(rbuf.data(), rbuf.size(), used, res)) {
+		const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+			HLOP_ERR(hlop::format("cannot receive from hlopd: {}", std::strerror(errno)));
+		if (n == 0)
+			HLOP_ERR("hlopd closed the connection");
+		rbuf.append(chunk, n);
+	}
+	rbuf.erase(0, used);
+	if (res.tag != req.tag)
+		HLOP_ERR(hlop::format("hlopd answered request {} to request {}", res.tag, req.tag));
+	return res;
+}
+
+const hlop::hlopd_stats_t hlop::hlopd_client::get_stats() {
+	hlop::hlopd_request_t req{};
+	req.type = hlop::hlopd_msg_type::STATS;
+	const auto res = request(req);
+	if (!res.ok)
+		HLOP_ERR(hlop::format("hlopd stats failed: {}", res.error));
+	return res.stats;
+}
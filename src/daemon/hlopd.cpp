@@ -0,0 +1,71 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "aux.h"
+#include "collective.h"
+#include "gflags/gflags.h"
+#include "msg.h"
+#include "prediction_cache.h"
+#include "server.h"
+
+DEFINE_string(socket, "", "path of the Unix domain socket, $XDG_RUNTIME_DIR/hlopd.sock or /tmp/hlopd-<uid>.sock by default");
+DEFINE_int32(threads, 0, "number of workers predicting the uncached queries, the number of cores by default");
+DEFINE_int32(topologies, 256, "number of node list snapshots kept");
+DEFINE_int32(results, 1 << 16, "number of predictions of a message size kept");
+DEFINE_string(cache, "", "file of the prediction cache, shared with other processes and runs, created if missing, "
+                         "no cache by default");
+DEFINE_uint64(cache_size, hlop::prediction_cache_t::DEFAULT_CAPACITY,
+              "number of predictions of a new --cache file, 48 bytes each");
+DEFINE_string(interp, "", "interpolation mode of off-grid message sizes, EXPONENTIAL, LOG_LINEAR or MONOTONE_CUBIC, "
+                          "the mode of the parameter file by default");
+
+namespace {
+hlop::hlopd_server_t *serving = nullptr;
+
+void on_signal(int) {
+	if (serving != nullptr)
+		serving->stop();
+}
+
+std::string default_socket() {
+	const char *dir = std::getenv("XDG_RUNTIME_DIR");
+	if (dir != nullptr && dir[0] != '\0')
+		return std::string{dir} + "/hlopd.sock";
+	return hlop::format("/tmp/hlopd-{}.sock", ::getuid());
+}
+} // namespace
+
+// ./hlopd --socket=/tmp/hlopd.sock --threads=8
+// the clients connect with hlopd_client, see client.h and protocol.h
+int main(int argc, char *argv[]) {
+	gflags::SetUsageMessage("serve hlop predictions on a Unix domain socket");
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (FLAGS_threads < 0 || FLAGS_topologies < 0 || FLAGS_results < 0)
+		HLOP_ERR("--threads, --topologies and --results must not be negative");
+	if (FLAGS_interp != "")
+		hlop::collective::set_interp_mode(hlop::enum_cast<hlop::interp_mode>(FLAGS_interp));
+
+	hlop::hlopd_server_t server{hlop::hlopd_config_t{
+	    .socket_path = FLAGS_socket != "" ? FLAGS_socket : default_socket(),
+	    .nthread = static_cast<std::size_t>(FLAGS_threads),
+	    .topology_capacity = static_cast<std::size_t>(FLAGS_topologies),
+	    .result_capacity = static_cast<std::size_t>(FLAGS_results),
+	    .cache_path = FLAGS_cache,
+	    .cache_capacity = static_cast<std::size_t>(FLAGS_cache_size),
+	}};
+	serving = &server;
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+	server.run();
+	std::signal(SIGINT, SIG_DFL);
+	std::signal(SIGTERM, SIG_DFL);
+	serving = nullptr;
+	std::cout << server.get_stats() << std::endl;
+	if (const auto cache = server.get_cache_stats(); cache.has_value())
+		std::cout << cache.value() << std::endl;
+	return 0;
+}
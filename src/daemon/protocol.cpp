@@ -0,0 +1,250 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#include "aux.h"
+#include "err.h"
+#include "msg.h"
+#include "protocol.h"
+
+namespace {
+template <typename T>
+void put(std::string &buf, T v) {
+	static_assert(std::is_trivially_copyable_v<T>);
+	buf.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+/**
+ * @brief read the fields of a message in order, every read is checked against the end of the message.
+ */
+class reader {
+public:
+	reader(const char *data, std::size_t size) : data(data), size(size) {}
+
+	template <typename T>
+	T get() {
+		static_assert(std::is_trivially_copyable_v<T>);
+		need(sizeof(T));
+		T v;
+		std::memcpy(&v, data + pos, sizeof(T));
+		pos += sizeof(T);
+		return v;
+	}
+
+	std::string get_string(std::size_t n) {
+		need(n);
+		std::string s{data + pos, n};
+		pos += n;
+		return s;
+	}
+
+	/// @brief check that the whole message is read.
+	void end() const {
+		if (pos != size)
+			HLOP_ERR(hlop::format("malformed hlopd message, {} trailing bytes", size - pos));
+	}
+
+private:
+	void need(std::size_t n) const {
+		if (size - pos < n)
+			HLOP_ERR("malformed hlopd message, truncated");
+	}
+
+	const char *data;
+	std::size_t size;
+	std::size_t pos = 0;
+};
+
+template <typename E>
+E to_enum(std::uint8_t v) {
+	const auto e = magic_enum::enum_cast<E>(static_cast<std::underlying_type_t<E>>(v));
+	if (!e.has_value())
+		HLOP_ERR(hlop::format("malformed hlopd message, invalid {} {}", magic_enum::enum_type_name<E>(), int{v}));
+	return e.value();
+}
+
+template <typename E>
+std::uint8_t from_enum(E e) {
+	return static_cast<std::uint8_t>(e);
+}
+
+/// @brief an algorithm on the wire, or AUTO_ALGO for none.
+constexpr std::uint8_t AUTO_ALGO = 0xff;
+
+/**
+ * @brief begin a message, the length is filled by finish.
+ */
+std::size_t begin(std::string &buf, hlop::hlopd_msg_type_t type) {
+	const std::size_t start = buf.size();
+	put<std::uint32_t>(buf, 0);
+	put<std::uint8_t>(buf, hlop::HLOPD_PROTOCOL_VERSION);
+	put<std::uint8_t>(buf, from_enum(type));
+	return start;
+}
+
+void finish(std::string &buf, std::size_t start) {
+	const std::size_t len = buf.size() - start - sizeof(std::uint32_t);
+	if (len > hlop::HLOPD_MAX_MESSAGE)
+		HLOP_ERR(hlop::format("hlopd message of {} bytes is larger than {}", len, hlop::HLOPD_MAX_MESSAGE));
+	const auto len32 = static_cast<std::uint32_t>(len);
+	std::memcpy(&buf[start], &len32, sizeof(len32));
+}
+
+/**
+ * @brief get the body of the first message of a buffer and check its header.
+ * @return bool, false if the message is not complete.
+ */
+bool frame(const char *data, std::size_t size, std::size_t &used, std::size_t &len, hlop::hlopd_msg_type_t &type) {
+	if (size < sizeof(std::uint32_t))
+		return false;
+	std::uint32_t len32;
+	std::memcpy(&len32, data, sizeof(len32));
+	if (len32 > hlop::HLOPD_MAX_MESSAGE)
+		HLOP_ERR(hlop::format("hlopd message of {} bytes is larger than {}", len32, hlop::HLOPD_MAX_MESSAGE));
+	if (size - sizeof(len32) < len32)
+		return false;
+	if (len32 < 2)
+		HLOP_ERR("malformed hlopd message, truncated");
+	if (static_cast<std::uint8_t>(data[4]) != hlop::HLOPD_PROTOCOL_VERSION)
+		HLOP_ERR(hlop::format("hlopd protocol version {} is not {}", int{static_cast<std::uint8_t>(data[4])},
+		                      int{hlop::HLOPD_PROTOCOL_VERSION}));
+	type = to_enum<hlop::hlopd_msg_type_t>(static_cast<std::uint8_t>(data[5]));
+	used = sizeof(len32) + len32;
+	len = len32 - 2;
+	return true;
+}
+} // namespace
+
+// message: u32 length of the rest, u8 version, u8 type, then the body of the type
+// QUERY request: u32 tag, u8 op, u8 algo (0xff for the best one), u8 pf, u8 node arrangement, u8 core arrangement,
+//                u8 prune, i32 ppn, u32 message sizes, u32 node list length, i32 x message sizes, node list
+// STATS request: u32 tag
+// QUERY response: u32 tag, u8 ok, then if ok u32 results, (u8 algo, u8 status, f64 time) x results,
+//                 otherwise u32 error length, error
+// STATS response: u32 tag, u8 ok, the u64 counters of hlopd_stats in order
+
+void hlop::encode_request(const hlop::hlopd_request_t &req, std::string &buf) {
+	const std::size_t start = begin(buf, req.type);
+	put<std::uint32_t>(buf, req.tag);
+	if (req.type == hlop::hlopd_msg_type::QUERY) {
+		put<std::uint8_t>(buf, from_enum(req.op));
+		put<std::uint8_t>(buf, req.algo.has_value() ? from_enum(req.algo.value()) : AUTO_ALGO);
+		put<std::uint8_t>(buf, from_enum(req.pf));
+		put<std::uint8_t>(buf, from_enum(req.rule.node_arrange));
+		put<std::uint8_t>(buf, from_enum(req.rule.core_arrange));
+		put<std::uint8_t>(buf, req.prune ? 1 : 0);
+		put<std::int32_t>(buf, req.ppn);
+		put<std::uint32_t>(buf, req.msz.size());
+		put<std::uint32_t>(buf, req.nl.size());
+		for (const int m : req.msz)
+			put<std::int32_t>(buf, m);
+		buf += req.nl;
+	}
+	finish(buf, start);
+}
+
+bool hlop::decode_request(const char *data, std::size_t size, std::size_t &used, hlop::hlopd_request_t &req) {
+	std::size_t len;
+	hlop::hlopd_msg_type_t type;
+	if (!frame(data, size, used, len, type))
+		return false;
+	reader r{data + used - len, len};
+	req = hlop::hlopd_request_t{};
+	req.type = type;
+	req.tag = r.get<std::uint32_t>();
+	if (type == hlop::hlopd_msg_type::QUERY) {
+		req.op = to_enum<hlop::op_type_t>(r.get<std::uint8_t>());
+		const auto algo = r.get<std::uint8_t>();
+		if (algo != AUTO_ALGO)
+			req.algo = to_enum<hlop::algo_type_t>(algo);
+		req.pf = to_enum<hlop::platform_t>(r.get<std::uint8_t>());
+		req.rule.node_arrange = to_enum<hlop::rank_arrangement_t>(r.get<std::uint8_t>());
+		req.rule.core_arrange = to_enum<hlop::rank_arrangement_t>(r.get<std::uint8_t>());
+		req.prune = r.get<std::uint8_t>() != 0;
+		req.ppn = r.get<std::int32_t>();
+		const auto nmsz = r.get<std::uint32_t>(), nl_len = r.get<std::uint32_t>();
+		if (nmsz > len / sizeof(std::int32_t))
+			HLOP_ERR("malformed hlopd message, truncated");
+		req.msz.resize(nmsz);
+		for (auto &m : req.msz)
+			m = r.get<std::int32_t>();
+		req.nl = r.get_string(nl_len);
+	}
+	r.end();
+	return true;
+}
+
+void hlop::encode_response(const hlop::hlopd_response_t &res, std::string &buf) {
+	const std::size_t start = begin(buf, res.type);
+	put<std::uint32_t>(buf, res.tag);
+	put<std::uint8_t>(buf, res.ok ? 1 : 0);
+	if (!res.ok) {
+		put<std::uint32_t>(buf, res.error.size());
+		buf += res.error;
+	} else if (res.type == hlop::hlopd_msg_type::QUERY) {
+		put<std::uint32_t>(buf, res.results.size());
+		for (const auto &r : res.results) {
+			put<std::uint8_t>(buf, from_enum(r.algo));
+			put<std::uint8_t>(buf, from_enum(r.status));
+			put<double>(buf, r.time);
+		}
+	} else {
+		const auto &s = res.stats;
+		for (const auto v : {s.requests, s.errors, s.inline_responses, s.topology_hits, s.topology_misses,
+		                     s.result_hits, s.result_misses, s.latency_sum_ns, s.latency_max_ns})
+			put<std::uint64_t>(buf, v);
+		for (const auto v : s.latency_hist)
+			put<std::uint64_t>(buf, v);
+	}
+	finish(buf, start);
+}
+
+bool hlop::decode_response(const char *data, std::size_t size, std::size_t &used, hlop::hlopd_response_t &res) {
+	std::size_t len;
+	hlop::hlopd_msg_type_t type;
+	if (!frame(data, size, used, len, type))
+		return false;
+	reader r{data + used - len, len};
+	res = hlop::hlopd_response_t{};
+	res.type = type;
+	res.tag = r.get<std::uint32_t>();
+	res.ok = r.get<std::uint8_t>() != 0;
+	if (!res.ok) {
+		res.error = r.get_string(r.get<std::uint32_t>());
+	} else if (type == hlop::hlopd_msg_type::QUERY) {
+		const auto n = r.get<std::uint32_t>();
+		if (n > len / (2 + sizeof(double)))
+			HLOP_ERR("malformed hlopd message, truncated");
+		res.results.resize(n);
+		for (auto &x : res.results) {
+			x.algo = to_enum<hlop::algo_type_t>(r.get<std::uint8_t>());
+			x.status = to_enum<hlop::algo_status_t>(r.get<std::uint8_t>());
+			x.time = r.get<double>();
+		}
+	} else {
+		auto &s = res.stats;
+		for (auto *v : {&s.requests, &s.errors, &s.inline_responses, &s.topology_hits, &s.topology_misses,
+		                &s.result_hits, &s.result_misses, &s.latency_sum_ns, &s.latency_max_ns})
+			*v = r.get<std::uint64_t>();
+		for (auto &v : s.latency_hist)
+			v = r.get<std::uint64_t>();
+	}
+	r.end();
+	return true;
+}
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::hlopd_stats_t &s) {
+	const auto rate = [](std::uint64_t hits, std::uint64_t misses) {
+		return hits + misses == 0 ? 0.0 : 100.0 * hits / (hits + misses);
+	};
+	os << "requests: " << s.requests << " errors: " << s.errors << " inline: " << s.inline_responses
+	   << " topology hits: " << s.topology_hits << "/" << s.topology_hits + s.topology_misses << " ("
+	   << rate(s.topology_hits, s.topology_misses) << "%)"
+	   << " result hits: " << s.result_hits << "/" << s.result_hits + s.result_misses << " ("
+	   << rate(s.result_hits, s.result_misses) << "%)"
+	   << " latency avg: " << (s.requests == 0 ? 0.0 : s.latency_sum_ns / 1e3 / s.requests) << " us"
+	   << " max: " << s.latency_max_ns / 1e3 << " us";
+	return os;
+}
@@ -0,0 +1,520 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "collective.h"
+#include "err.h"
+#include "factory.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "node/hostlist.h"
+#include "prediction_cache.h"
+#include "protocol.h"
+#include "server.h"
+#include "struct/type.h"
+
+namespace {
+constexpr std::uint8_t AUTO_ALGO = 0xff;
+constexpr int MAX_EVENTS = 64;
+
+/// @brief the parameters of a query that make its node list, before the host list.
+std::string topology_prefix(const hlop::hlopd_request_t &req) {
+	return hlop::format("{}|{}|{}|{}|", static_cast<int>(req.pf), static_cast<int>(req.rule.node_arrange),
+	                    static_cast<int>(req.rule.core_arrange), req.ppn);
+}
+
+std::uint8_t algo_key(const hlop::hlopd_request_t &req) {
+	return req.algo.has_value() ? static_cast<std::uint8_t>(req.algo.value()) : AUTO_ALGO;
+}
+
+std::vector<hlop::algo_rank_t> best_of(const std::vector<std::vector<hlop::algo_rank_t>> &rankings) {
+	std::vector<hlop::algo_rank_t> res;
+	res.reserve(rankings.size());
+	for (const auto &ranking : rankings)
+		res.push_back(ranking.front());
+	return res;
+}
+
+void watch(int epoll_fd, int op, int fd, std::uint32_t events) {
+	epoll_event ev{};
+	ev.events = events;
+	ev.data.fd = fd;
+	if (::epoll_ctl(epoll_fd, op, fd, &ev) < 0)
+		HLOP_ERR(hlop::format("epoll_ctl on {} failed: {}", fd, std::strerror(errno)));
+}
+
+void notify(int fd) {
+	const std::uint64_t one = 1;
+	// the counter only overflows after 2^64 - 1 unread writes
+	[[maybe_unused]] const auto n = ::write(fd, &one, sizeof(one));
+}
+} // namespace
+
+bool hlop::hlopd_server::result_key::operator==(const result_key &other) const {
+	return topology.hi == other.topology.hi && topology.lo == other.topology.lo && op == other.op && algo == other.algo && msg_size == other.msg_size;
+}
+
+std::size_t hlop::hlopd_server::result_key_hash::operator()(const result_key &k) const {
+	std::uint64_t h = k.topology.hi ^ k.topology.lo;
+	h ^= (static_cast<std::uint64_t>(k.op) << 40) ^ (static_cast<std::uint64_t>(k.algo) << 32) ^
+	     static_cast<std::uint32_t>(k.msg_size);
+	h *= 0x9e3779b97f4a7c15ull;
+	return static_cast<std::size_t>(h ^ (h >> 32));
+}
+
+hlop::hlopd_server::hlopd_server(const hlop::hlopd_config_t &config) : config(config) {
+	// opened first, nothing is left to close if it fails
+	if (!config.cache_path.empty())
+		disk = std::make_unique<hlop::prediction_cache_t>(config.cache_path, config.cache_capacity);
+
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	if (config.socket_path.empty() || config.socket_path.size() >= sizeof(addr.sun_path))
+		HLOP_ERR(hlop::format("socket path \"{}\" must have 1 to {} characters", config.socket_path,
+		                      sizeof(addr.sun_path) - 1));
+	std::strcpy(addr.sun_path, config.socket_path.c_str());
+
+	listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listen_fd < 0)
+		HLOP_ERR(hlop::format("cannot create socket: {}", std::strerror(errno)));
+	if (::bind(listen_fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0) {
+		const int err = errno;
+		bool stale = false;
+		if (err == EADDRINUSE) {
+			// the socket file is left by a server that is gone if nobody accepts on it
+			const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			stale = probe >= 0 && ::connect(probe, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0 &&
+			        errno == ECONNREFUSED;
+			if (probe >= 0)
+				::close(probe);
+		}
+		if (!stale || ::unlink(addr.sun_path) < 0 ||
+		    ::bind(listen_fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0) {
+			::close(listen_fd);
+			if (err == EADDRINUSE && !stale)
+				HLOP_ERR(hlop::format("another hlopd is serving on {}", config.socket_path));
+			HLOP_ERR(hlop::format("cannot bind to {}: {}", config.socket_path, std::strerror(stale ? errno : err)));
+		}
+	}
+	if (::listen(listen_fd, SOMAXCONN) < 0) {
+		const int err = errno;
+		::close(listen_fd);
+		::unlink(addr.sun_path);
+		HLOP_ERR(hlop::format("cannot listen on {}: {}", config.socket_path, std::strerror(err)));
+	}
+
+	epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+	wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	stop_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (epoll_fd < 0 || wake_fd < 0 || stop_fd < 0) {
+		const int err = errno;
+		for (const int fd : {listen_fd, epoll_fd, wake_fd, stop_fd})
+			if (fd >= 0)
+				::close(fd);
+		::unlink(addr.sun_path);
+		HLOP_ERR(hlop::format("cannot create the event loop: {}", std::strerror(err)));
+	}
+	watch(epoll_fd, EPOLL_CTL_ADD, listen_fd, EPOLLIN);
+	watch(epoll_fd, EPOLL_CTL_ADD, wake_fd, EPOLLIN);
+	watch(epoll_fd, EPOLL_CTL_ADD, stop_fd, EPOLLIN);
+
+	for (const auto op : hlop::get_collective_ops())
+		predictors.emplace(op, hlop::make_collective(op));
+	pool = std::make_unique<hlop::thread_pool_t>(config.nthread);
+	INFO("hlopd serving on {} with {} workers", config.socket_path, pool->size());
+}
+
+hlop::hlopd_server::~hlopd_server() {
+	// the workers post to wake_fd, they are joined before it is closed
+	pool.reset();
+	for (const auto &[fd, c] : connections)
+		::close(fd);
+	for (const int fd : {listen_fd, epoll_fd, wake_fd, stop_fd})
+		::close(fd);
+	::unlink(config.socket_path.c_str());
+}
+
+void hlop::hlopd_server::stop() { notify(stop_fd); }
+
+const hlop::hlopd_stats_t hlop::hlopd_server::get_stats() const {
+	hlop::hlopd_stats_t s{};
+	s.requests = requests.load();
+	s.errors = errors.load();
+	s.inline_responses = inline_responses.load();
+	s.topology_hits = topology_hits.load();
+	s.topology_misses = topology_misses.load();
+	s.result_hits = result_hits.load();
+	s.result_misses = result_misses.load();
+	s.latency_sum_ns = latency_sum_ns.load();
+	s.latency_max_ns = latency_max_ns.load();
+	for (std::size_t i = 0; i < s.latency_hist.size(); ++i)
+		s.latency_hist[i] = latency_hist[i].load();
+	return s;
+}
+
+const std::optional<hlop::prediction_cache_stats_t> hlop::hlopd_server::get_cache_stats() const {
+	if (disk == nullptr)
+		return std::nullopt;
+	return disk->get_stats();
+}
+
+void hlop::hlopd_server::run() {
+	epoll_event events[MAX_EVENTS];
+	while (true) {
+		const int n = ::epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+			HLOP_ERR(hlop::format("epoll_wait failed: {}", std::strerror(errno)));
+		for (int i = 0; i < n; ++i) {
+			const int fd = events[i].data.fd;
+			if (fd == stop_fd) {
+				std::uint64_t v;
+				[[maybe_unused]] const auto r = ::read(stop_fd, &v, sizeof(v));
+#ifdef M_DEBUG
+				std::ostringstream oss;
+				oss << get_stats();
+				INFO("hlopd stopped, {}", oss.str());
+#endif // M_DEBUG
+				return;
+			}
+			if (fd == wake_fd) {
+				std::uint64_t v;
+				[[maybe_unused]] const auto r = ::read(wake_fd, &v, sizeof(v));
+				std::vector<completion> done;
+				{
+					std::lock_guard<std::mutex> lock{completion_mtx};
+					done.swap(completions);
+				}
+				for (auto &d : done) {
+					auto it = connections.find(d.fd);
+					// the connection is closed, or its descriptor is reused by a newer one
+					if (it == connections.end() || it->second.id != d.conn_id)
+						continue;
+					it->second.out += d.bytes;
+					if (!flush(d.fd, it->second))
+						close_connection(d.fd);
+				}
+				continue;
+			}
+			if (fd == listen_fd) {
+				int cfd;
+				while ((cfd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+					watch(epoll_fd, EPOLL_CTL_ADD, cfd, EPOLLIN);
+					connections[cfd] = connection{next_conn_id++, {}, {}, false};
+					DEBUG("hlopd accepted connection {}", cfd);
+				}
+				continue;
+			}
+
+			auto it = connections.find(fd);
+			if (it == connections.end())
+				continue;
+			auto &c = it->second;
+			bool alive = true;
+			if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+				char chunk[65536];
+				while (true) {
+					const ssize_t r = ::recv(fd, chunk, sizeof(chunk), 0);
+					if (r > 0) {
+						c.in.append(chunk, r);
+						continue;
+					}
+					if (r < 0 && errno == EINTR)
+						continue;
+					// a closed peer gets no more responses, its pending requests are dropped
+					alive = r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+					break;
+				}
+				alive = alive && handle_input(fd, c);
+			}
+			if (alive && (events[i].events & EPOLLOUT))
+				alive = flush(fd, c);
+			if (!alive)
+				close_connection(fd);
+		}
+	}
+}
+
+bool hlop::hlopd_server::handle_input(int fd, connection &c) {
+	std::size_t pos = 0;
+	while (pos < c.in.size()) {
+		hlop::hlopd_request_t req;
+		std::size_t used;
+		try {
+			if (!hlop::decode_request(c.in.data() + pos, c.in.size() - pos, used, req))
+				break;
+		} catch (const std::exception &e) {
+			// the stream cannot be resynchronized after a malformed message
+			INFO("hlopd closes connection {}: {}", fd, e.what());
+			++errors;
+			return false;
+		}
+		pos += used;
+		++requests;
+		const auto start = clock::now();
+
+		if (req.type == hlop::hlopd_msg_type::STATS) {
+			hlop::hlopd_response_t res{};
+			res.tag = req.tag;
+			res.type = req.type;
+			res.ok = true;
+			res.stats = get_stats();
+			hlop::encode_response(res, c.out);
+			record_latency(start);
+			continue;
+		}
+		if (answer_cached(req, c.out)) {
+			++inline_responses;
+			record_latency(start);
+			continue;
+		}
+		pool->submit([this, fd, id = c.id, req = std::move(req), start]() {
+			completion d{fd, id, {}};
+			hlop::encode_response(answer(req), d.bytes);
+			record_latency(start);
+			{
+				std::lock_guard<std::mutex> lock{completion_mtx};
+				completions.push_back(std::move(d));
+			}
+			notify(wake_fd);
+		});
+	}
+	c.in.erase(0, pos);
+	return flush(fd, c);
+}
+
+bool hlop::hlopd_server::answer_cached(const hlop::hlopd_request_t &req, std::string &out) {
+	hlop::disk_cache_key_t fp;
+	hlop::const_node_list_ptr_t nl;
+	if (!find_topology(topology_prefix(req) + req.nl, fp, nl))
+		return false;
+
+	hlop::hlopd_response_t res{};
+	res.tag = req.tag;
+	res.type = req.type;
+	res.ok = true;
+	res.results.reserve(req.msz.size());
+	{
+		std::lock_guard<std::mutex> lock{result_mtx};
+		std::vector<result_iter> hits;
+		hits.reserve(req.msz.size());
+		for (const int m : req.msz) {
+			auto it = by_key.find(result_key{fp, static_cast<std::uint8_t>(req.op), algo_key(req), m});
+			if (it == by_key.end())
+				return false;
+			hits.push_back(it->second);
+		}
+		for (const auto &it : hits) {
+			results.splice(results.begin(), results, it);
+			res.results.push_back(it->second);
+		}
+	}
+	++topology_hits;
+	result_hits += req.msz.size();
+	hlop::encode_response(res, out);
+	return true;
+}
+
+const hlop::hlopd_response_t hlop::hlopd_server::answer(const hlop::hlopd_request_t &req) {
+	hlop::hlopd_response_t res{};
+	res.tag = req.tag;
+	res.type = req.type;
+	try {
+		auto pit = predictors.find(req.op);
+		if (pit == predictors.end())
+			HLOP_ERR(hlop::format("unsupported operation type: {}", hlop::enum_name(req.op)));
+		const auto &predictor = *pit->second;
+
+		hlop::disk_cache_key_t fp;
+		const auto nl = get_topology(req, fp);
+		const std::uint8_t op = static_cast<std::uint8_t>(req.op), algo = algo_key(req);
+
+		// the cached sizes first, the others are predicted together
+		res.results.resize(req.msz.size());
+		std::vector<int> missing;
+		std::vector<std::size_t> missing_at;
+		{
+			std::lock_guard<std::mutex> lock{result_mtx};
+			for (std::size_t i = 0; i < req.msz.size(); ++i) {
+				auto it = by_key.find(result_key{fp, op, algo, req.msz[i]});
+				if (it != by_key.end()) {
+					results.splice(results.begin(), results, it->second);
+					res.results[i] = it->second->second;
+				} else {
+					missing.push_back(req.msz[i]);
+					missing_at.push_back(i);
+				}
+			}
+		}
+		result_hits += req.msz.size() - missing.size();
+		result_misses += missing.size();
+
+		if (!missing.empty()) {
+			std::vector<hlop::hlopd_result_t> predicted;
+			predicted.reserve(missing.size());
+			if (disk != nullptr && req.algo.has_value()) {
+				for (const double t : disk->predict(predictor, req.op, req.algo.value(), *nl, missing))
+					predicted.push_back(hlop::hlopd_result_t{req.algo.value(), hlop::algo_status::OK, t});
+			} else if (req.algo.has_value()) {
+				for (const double t : predictor.predict(req.algo.value(), *nl, missing, 0))
+					predicted.push_back(hlop::hlopd_result_t{req.algo.value(), hlop::algo_status::OK, t});
+			} else {
+				// predicted in this worker, select_best must not wait on the pool it runs on
+				const auto bests = disk != nullptr ? disk->select_best(predictor, req.op, *nl, missing, req.prune)
+				                                   : best_of(predictor.select_best(*nl, missing, 0, nullptr, req.prune));
+				for (const auto &best : bests)
+					predicted.push_back(best.status == hlop::algo_status::OK
+					                        ? hlop::hlopd_result_t{best.algo, best.status, best.time}
+					                        : hlop::hlopd_result_t{best.algo, hlop::algo_status::FAILED, 0.0});
+			}
+
+			std::lock_guard<std::mutex> lock{result_mtx};
+			for (std::size_t j = 0; j < missing.size(); ++j) {
+				res.results[missing_at[j]] = predicted[j];
+				if (config.result_capacity == 0)
+					continue;
+				const result_key key{fp, op, algo, missing[j]};
+				auto it = by_key.find(key);
+				if (it != by_key.end()) {
+					// predicted by another worker meanwhile, the same value
+					results.splice(results.begin(), results, it->second);
+					continue;
+				}
+				results.emplace_front(key, predicted[j]);
+				by_key.emplace(key, results.begin());
+				if (results.size() > config.result_capacity) {
+					by_key.erase(results.back().first);
+					results.pop_back();
+				}
+			}
+		}
+		res.ok = true;
+	} catch (const std::exception &e) {
+		++errors;
+		res.ok = false;
+		res.results.clear();
+		res.error = e.what();
+	}
+	return res;
+}
+
+bool hlop::hlopd_server::find_topology(const std::string &raw_key, hlop::disk_cache_key_t &fp,
+                                       hlop::const_node_list_ptr_t &nl) {
+	std::lock_guard<std::mutex> lock{topology_mtx};
+	auto it = by_raw.find(raw_key);
+	if (it == by_raw.end())
+		return false;
+	topologies.splice(topologies.begin(), topologies, it->second);
+	fp = it->second->fp;
+	nl = it->second->nl;
+	return true;
+}
+
+hlop::const_node_list_ptr_t hlop::hlopd_server::get_topology(const hlop::hlopd_request_t &req,
+                                                             hlop::disk_cache_key_t &fp) {
+	const std::string prefix = topology_prefix(req), raw_key = prefix + req.nl;
+	hlop::const_node_list_ptr_t nl;
+	if (find_topology(raw_key, fp, nl)) {
+		++topology_hits;
+		return nl;
+	}
+
+	// the same hosts written another way, e.g., "n[1-2]" and "n1,n2", are one topology
+	std::string norm_key = prefix;
+	for (const auto &name : hlop::expand_hostlist(req.nl))
+		norm_key += name + ",";
+	const auto add_alias = [&](topology_iter it) {
+		topologies.splice(topologies.begin(), topologies, it);
+		if (by_raw.emplace(raw_key, it).second)
+			it->raw_keys.push_back(raw_key);
+		fp = it->fp;
+		return it->nl;
+	};
+	{
+		std::lock_guard<std::mutex> lock{topology_mtx};
+		auto it = by_norm.find(norm_key);
+		if (it != by_norm.end()) {
+			++topology_hits;
+			return add_alias(it->second);
+		}
+	}
+
+	// parse outside of the lock, a list parsed by two workers at once is kept once
+	++topology_misses;
+	nl = std::make_shared<const hlop::node_list_t>(req.pf, req.nl, req.ppn, req.rule);
+	// the results are keyed by the 128-bit fingerprint, a collision is as unlikely as in the cache file
+	fp = hlop::prediction_cache_t::fingerprint(*nl);
+	if (config.topology_capacity == 0)
+		return nl;
+	std::lock_guard<std::mutex> lock{topology_mtx};
+	auto it = by_norm.find(norm_key);
+	if (it != by_norm.end())
+		return add_alias(it->second);
+	topologies.push_front(topology{norm_key, fp, nl, {raw_key}});
+	by_norm.emplace(norm_key, topologies.begin());
+	by_raw.emplace(raw_key, topologies.begin());
+	if (topologies.size() > config.topology_capacity) {
+		// the results of an evicted topology stay valid, they are keyed by its fingerprint
+		const auto &old = topologies.back();
+		for (const auto &k : old.raw_keys)
+			by_raw.erase(k);
+		by_norm.erase(old.norm_key);
+		topologies.pop_back();
+	}
+	return nl;
+}
+
+bool hlop::hlopd_server::flush(int fd, connection &c) {
+	std::size_t sent = 0;
+	while (sent < c.out.size()) {
+		const ssize_t n = ::send(fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n < 0)
+			return false;
+		sent += n;
+	}
+	c.out.erase(0, sent);
+	const bool want_out = !c.out.empty();
+	if (want_out != c.want_out) {
+		watch(epoll_fd, EPOLL_CTL_MOD, fd, want_out ? EPOLLIN | EPOLLOUT : EPOLLIN);
+		c.want_out = want_out;
+	}
+	return true;
+}
+
+void hlop::hlopd_server::close_connection(int fd) {
+	DEBUG("hlopd closed connection {}", fd);
+	::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	::close(fd);
+	connections.erase(fd);
+}
+
+void hlop::hlopd_server::record_latency(clock::time_point start) {
+	const auto ns = static_cast<std::uint64_t>(
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+	latency_sum_ns += ns;
+	auto max = latency_max_ns.load();
+	while (ns > max && !latency_max_ns.compare_exchange_weak(max, ns))
+		;
+	std::size_t bucket = 0;
+	for (std::uint64_t us = ns / 1000; us != 0; us >>= 1)
+		++bucket;
+	++latency_hist[std::min(bucket, latency_hist.size() - 1)];
+}
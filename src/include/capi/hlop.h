@@ -0,0 +1,157 @@
+#ifndef __HLOP_H__
+#define __HLOP_H__
+
+/*
+ * The C interface of hlop, built as the shared library libhlop.
+ * A topology is parsed once into a handle, the most recently used predictions of a handle are kept in it,
+ * so a repeated question is answered without predicting again and a long-lived handle stays bounded.
+ * No function throws, a failed call returns a status other than HLOP_SUCCESS
+ * and hlop_last_error tells why.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HLOP_API __attribute__((visibility("default")))
+#else
+#define HLOP_API
+#endif
+
+/**
+ * @brief status of a call, HLOP_SUCCESS is 0.
+ */
+typedef enum hlop_status {
+	HLOP_SUCCESS = 0,
+	HLOP_ERR_ARG,     // a pointer is null, or an enumerator or size is out of range
+	HLOP_ERR_FAILED,  // hlop could not parse the topology or predict the operation
+	HLOP_ERR_NOMEM,   // out of memory
+	HLOP_ERR_INTERNAL // an unexpected error, not derived from std::exception
+} hlop_status_t;
+
+/**
+ * @brief the platforms, the same as hlop::platform.
+ */
+typedef enum hlop_platform {
+	HLOP_PLATFORM_DF,
+	HLOP_PLATFORM_TH
+} hlop_platform_t;
+
+/**
+ * @brief the collective operations, the same as hlop::op_type.
+ */
+typedef enum hlop_op {
+	HLOP_OP_ALLGATHER,
+	HLOP_OP_ALLREDUCE,
+	HLOP_OP_ALLTOALL,
+	HLOP_OP_BCAST,
+	HLOP_OP_GATHER,
+	HLOP_OP_REDUCE,
+	HLOP_OP_SCATTER
+} hlop_op_t;
+
+/**
+ * @brief the algorithms, the same as hlop::algo_type.
+ */
+typedef enum hlop_algo {
+	HLOP_ALGO_BINOMIAL,
+	HLOP_ALGO_RING,
+	HLOP_ALGO_RECURSIVE_DOUBLING,
+	HLOP_ALGO_SMP,
+	HLOP_ALGO_SCATTER_RING_ALLGATHER,
+	HLOP_ALGO_SCATTER_RECURSIVE_DOUBLING_ALLGATHER,
+	HLOP_ALGO_REDUCE_SCATTER_ALLGATHER,
+	HLOP_ALGO_REDUCE_SCATTER_GATHER,
+	HLOP_ALGO_PAIRWISE,
+	HLOP_ALGO_BRUCKS,
+	HLOP_ALGO_K_BRUCKS
+} hlop_algo_t;
+
+/**
+ * @brief the regular rank arrangements, the same as hlop::rank_arrangement.
+ */
+typedef enum hlop_arrangement {
+	HLOP_ARRANGE_BLOCK,
+	HLOP_ARRANGE_CYCLIC
+} hlop_arrangement_t;
+
+/**
+ * @brief a parsed topology and its predictions, opaque.
+ * @note A topology is immutable but for its predictions, which are locked,
+ * so it may be shared by threads.
+ */
+typedef struct hlop_topology hlop_topology_t;
+
+/**
+ * @brief create a topology from hosts and the node and core of each rank.
+ * @param pf hlop_platform, the platform of the hosts.
+ * @param hosts const char *const *, the host names, e.g. {"i10r4n03", "i10r4n04"}.
+ * @param nhost int, the number of hosts.
+ * @param rank_nodes const int *, the index in hosts of the host of each rank.
+ * @param rank_cores const int *, the core each rank is bound to.
+ * @param nrank int, the number of ranks.
+ * @param topo hlop_topology **, output, the topology, to be freed by hlop_topology_free.
+ * @return hlop_status, HLOP_ERR_FAILED if a host is unknown to the platform, a rank is placed out of range
+ * or two ranks are bound to the same core.
+ */
+HLOP_API hlop_status_t hlop_topology_create(hlop_platform_t pf, const char *const *hosts, int nhost,
+                                            const int *rank_nodes, const int *rank_cores, int nrank,
+                                            hlop_topology_t **topo);
+/**
+ * @brief create a topology of a regular arrangement of ranks.
+ * @param pf hlop_platform, the platform of the hosts.
+ * @param host_list const char *, a compressed host list, e.g. "i10r4n[03-04,08]".
+ * @param ppn int, the number of processes per node.
+ * @param node_arrange hlop_arrangement, how the ranks are spread over the nodes.
+ * @param core_arrange hlop_arrangement, how the ranks of a node are spread over its cores.
+ * @param topo hlop_topology **, output, the topology, to be freed by hlop_topology_free.
+ * @return hlop_status, HLOP_ERR_FAILED if the host list is invalid or ppn is too large.
+ */
+HLOP_API hlop_status_t hlop_topology_create_regular(hlop_platform_t pf, const char *host_list, int ppn,
+                                                    hlop_arrangement_t node_arrange, hlop_arrangement_t core_arrange,
+                                                    hlop_topology_t **topo);
+/**
+ * @brief free a topology, nothing is done for a null pointer.
+ * @param topo hlop_topology *, the topology.
+ */
+HLOP_API void hlop_topology_free(hlop_topology_t *topo);
+/**
+ * @brief get the number of ranks of a topology.
+ * @param topo hlop_topology *, the topology.
+ * @return int, the number of ranks, 0 for a null pointer.
+ */
+HLOP_API int hlop_topology_ranks(const hlop_topology_t *topo);
+/**
+ * @brief predict the time of an algorithm of an operation.
+ * @param topo hlop_topology *, the topology.
+ * @param op hlop_op, the operation.
+ * @param algo hlop_algo, the algorithm.
+ * @param msg_size int, the message size in bytes, greater than 0.
+ * @param time double *, output, the predicted time in us.
+ * @return hlop_status, HLOP_ERR_FAILED if the algorithm is not implemented or cannot be predicted.
+ */
+HLOP_API hlop_status_t hlop_predict(const hlop_topology_t *topo, hlop_op_t op, hlop_algo_t algo, int msg_size,
+                                    double *time);
+/**
+ * @brief select the fastest algorithm of an operation.
+ * @param topo hlop_topology *, the topology.
+ * @param op hlop_op, the operation.
+ * @param msg_size int, the message size in bytes, greater than 0.
+ * @param algo hlop_algo *, output, the fastest algorithm.
+ * @param time double *, output, its predicted time in us, may be null.
+ * @return hlop_status, HLOP_ERR_FAILED if no algorithm of the operation can be predicted.
+ */
+HLOP_API hlop_status_t hlop_best_algo(const hlop_topology_t *topo, hlop_op_t op, int msg_size, hlop_algo_t *algo,
+                                      double *time);
+/**
+ * @brief get the error of the last failed call of this thread.
+ * @return const char *, the message, empty if no call failed, valid until the next failed call of this thread.
+ */
+HLOP_API const char *hlop_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HLOP_H__
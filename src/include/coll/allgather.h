@@ -1,6 +1,8 @@
 #ifndef __ALLGATHER_H__
 #define __ALLGATHER_H__
 
+#include <vector>
+
 #include "collective.h"
 #include "struct/node_list.h"
 
@@ -11,10 +13,12 @@ public:
 	~allgather() = default;
 
 private:
-	double brucks(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp);
-	double k_brucks(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp);
-	double recursive_doubling(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp);
-	double ring(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp);
+	double brucks(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) const;
+	double k_brucks(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) const;
+	double recursive_doubling(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) const;
+	hlop::plan_t plan_recursive_doubling(const hlop::node_list_t &nl, const hlop::algo_diff_param_t &dp,
+	                                     const hlop::plan_t::round_hook &hook) const;
+	double ring(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) const;
 
 private:
 	/**
@@ -1,8 +1,11 @@
 #ifndef __BCAST_H__
 #define __BCAST_H__
 
+#include <vector>
+
 #include "collective.h"
 #include "struct/node_list.h"
+#include "struct/plan.h"
 
 namespace hlop {
 /**
@@ -25,7 +28,16 @@ private:
 	 * @param dp algo_diff_param, the algorithm-specific parameters (e.g., root rank).
 	 * @return double, the predicted performance of the binomial algorithm.
 	 */
-	double binomial(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &);
+	double binomial(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &) const;
+	/**
+	 * @brief simulate the schedule of the binomial algorithm.
+	 * @param nl node_list, the node list to use for prediction.
+	 * @param dp algo_diff_param, the algorithm-specific parameters (e.g., root rank).
+	 * @param hook plan::round_hook, called after each round, may stop the simulation, empty for none.
+	 * @return plan, one round for each mask, every round sends the whole message.
+	 */
+	hlop::plan_t plan_binomial(const hlop::node_list_t &nl, const hlop::algo_diff_param_t &,
+	                           const hlop::plan_t::round_hook &hook) const;
 	/**
 	 * @brief predicts the performance of the scatter recursive doubling allgather algorithm.
 	 * @param nl node_list, the node list to use for prediction.
@@ -33,7 +45,7 @@ private:
 	 * @param dp algo_diff_param, the algorithm-specific parameters (e.g., root rank).
 	 * @return double, the predicted performance of the scatter recursive doubling allgather algorithm.
 	 */
-	double scatter_recursive_doubling_allgather(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &);
+	double scatter_recursive_doubling_allgather(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &) const;
 	/**
 	 * @brief predicts the performance of the scatter ring allgather algorithm.
 	 * @param nl node_list, the node list to use for prediction.
@@ -41,7 +53,7 @@ private:
 	 * @param dp algo_diff_param, the algorithm-specific parameters (e.g., root rank).
 	 * @return double, the predicted performance of the scatter ring allgather algorithm.
 	 */
-	double scatter_ring_allgather(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &);
+	double scatter_ring_allgather(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &) const;
 	/**
 	 * @brief predicts the performance of the SMP (shared memory parallelism) algorithm.
 	 * @param nl node_list, the node list to use for prediction.
@@ -49,7 +61,7 @@ private:
 	 * @param dp algo_diff_param, the algorithm-specific parameters (e.g., root rank).
 	 * @return double, the predicted performance of the SMP algorithm.
 	 */
-	double smp(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &);
+	double smp(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &) const;
 
 private:
 	/**
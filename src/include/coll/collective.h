@@ -1,37 +1,115 @@
 #ifndef __COLLECTIVE_H__
 #define __COLLECTIVE_H__
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <map>
+#include <iostream>
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
 #include "param/param.h"
-#include "struct/comm_pair.h"
+#include "struct/comm_round.h"
+#include "struct/cost_cache.h"
 #include "struct/node_list.h"
+#include "struct/plan.h"
 #include "struct/type.h"
+#include "thread_pool.h"
 
 namespace hlop {
 /// @brief this variant is used to pass algorithm-specific parameters to the collective operations.
 typedef std::variant<int, void *> algo_diff_param_t;
 
+/**
+ * @brief struct algorithm rank.
+ * An algorithm in a ranking of collective::select_best, time is the predicted time if status is OK,
+ * a lower bound of it if status is PRUNED, reason tells why the prediction failed if status is FAILED.
+ */
+struct algo_rank {
+	hlop::algo_type_t algo;
+	hlop::algo_status_t status;
+	double time;
+	std::string reason;
+};
+typedef algo_rank algo_rank_t;
+
+std::ostream &operator<<(std::ostream &os, const hlop::algo_rank_t &r);
+
 /**
  * @brief class collective.
  * This class is the base class for all collective operations.
  * It provides a common interface for predicting the performance of different algorithms
  * and checking the availability of algorithms.
  * Derived classes should implement the specific algorithms and their predictions.
+ * @note The predictors and planners are const and keep their state on the stack, the shared parameters,
+ * round cost cache and pool are immutable, locked or created once, so predict, select_best and make_plan
+ * are reentrant against a node list, see node_list. Only set_interp_mode must run before them.
  */
 class collective {
 public:
 	using predictor_handler = std::function<double(const hlop::node_list_t &, int, const hlop::algo_diff_param_t &)>;
+	using planner_handler = std::function<hlop::plan_t(const hlop::node_list_t &, const hlop::algo_diff_param_t &,
+	                                                   const hlop::plan_t::round_hook &)>;
+	using shape_handler = std::function<std::vector<int>(const hlop::node_list_t &)>;
 
 protected:
-	static const hlop::param_t hlop_param_lat;
-	static const hlop::param_t hlop_param_bw;
+	/**
+	 * @brief get the latency parameters, loaded on first use.
+	 * @return param, the latency parameters.
+	 * @note The precompiled binary parameter file is mapped if it exists, otherwise the csv is parsed.
+	 */
+	static const hlop::param_t &hlop_param_lat();
+	/**
+	 * @brief get the bandwidth parameters, loaded on first use.
+	 * @return param, the bandwidth parameters.
+	 * @note The precompiled binary parameter file is mapped if it exists, otherwise the csv is parsed.
+	 */
+	static const hlop::param_t &hlop_param_bw();
+	/**
+	 * @brief get the cache of round costs shared by all collectives, created on first use.
+	 * @return cost_cache, the cache.
+	 * @note calc_cost and evaluate look the cost of a round up by its contention histogram
+	 * and message size before pricing it.
+	 */
+	static hlop::cost_cache_t &round_cost_cache();
+	/**
+	 * @brief get the thread pool shared by all collectives, created on first use.
+	 * @return thread_pool, a pool of one thread per hardware thread.
+	 */
+	static hlop::thread_pool_t &shared_pool();
+
+public:
+	/// @brief the number of round costs kept until set_cost_cache_capacity is called.
+	static constexpr std::size_t DEFAULT_COST_CACHE_CAPACITY = 4096;
+	/**
+	 * @brief set the interpolation mode of the latency and bandwidth parameters.
+	 * @param mode interp_mode, the interpolation mode of off-grid message sizes.
+	 * @throws hlop_err, if the parameters are already loaded.
+	 * @note Without this call the mode saved in the binary parameter file is used, EXPONENTIAL for csv.
+	 * It must be called before the first prediction and is not thread-safe.
+	 */
+	static void set_interp_mode(hlop::interp_mode_t mode);
+	/**
+	 * @brief get the hit and miss counters of the round cost cache.
+	 * @return cost_cache_stats, the statistics of the cache.
+	 */
+	static const hlop::cost_cache_stats_t get_cost_cache_stats();
+	/**
+	 * @brief set the maximum number of round costs kept, DEFAULT_COST_CACHE_CAPACITY by default.
+	 * @param capacity size_t, the maximum number of entries, 0 disables the cache.
+	 */
+	static void set_cost_cache_capacity(std::size_t capacity);
+	/**
+	 * @brief get a fingerprint of the parameters the predictions are made with.
+	 * @return uint64_t, a hash of the contents of the latency and bandwidth parameter files,
+	 * of the fit files of those loaded from a csv, and of the interpolation mode.
+	 * @note The files are hashed once, set_interp_mode must be called before, as before a prediction.
+	 */
+	static const std::uint64_t get_param_fingerprint();
 
 public:
 	collective();
@@ -51,6 +129,12 @@ public:
 	 * @return vector<algo_type>, the list of available algorithms.
 	 */
 	const std::vector<hlop::algo_type> get_algos() const;
+	/**
+	 * @brief check if an algorithm is implemented, i.e. it is available and not a stub.
+	 * @param algo algo_type, the algorithm type to check.
+	 * @return bool, true if the algorithm can be predicted, false otherwise.
+	 */
+	bool is_implemented(hlop::algo_type algo) const;
 	/**
 	 * @brief predict the performance of an algorithm.
 	 * @param algo algo_type, the algorithm type to predict.
@@ -60,38 +144,175 @@ public:
 	 * @return double, the predicted performance of the algorithm.
 	 */
 	const double predict(hlop::algo_type algo, const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) const;
-
-protected:
 	/**
-	 * @fixme
-	 * @brief get the contention in a set of communication pairs.
-	 * @param pairs vector<comm_pair>, the communication pairs to check for contention.
-	 * @return map<comm_pair, int>, a map of communication pairs to contention counts.
+	 * @brief predict the performance of an algorithm for many message sizes.
+	 * @param algo algo_type, the algorithm type to predict.
+	 * @param nl node_list, the node list to use for prediction.
+	 * @param msg_sizes vector<int>, the message sizes to use for prediction.
+	 * @param dp algo_diff_param_t, the algorithm-specific parameters.
+	 * @return vector<double>, the predicted performance of the algorithm, one for each message size.
+	 * @note The plan of the algorithm is made once and evaluated for all message sizes if it has a planner,
+	 * otherwise each message size is predicted on its own.
+	 */
+	const std::vector<double> predict(hlop::algo_type algo, const hlop::node_list_t &nl,
+	                                  const std::vector<int> &msg_sizes, const hlop::algo_diff_param_t &dp) const;
+	/**
+	 * @brief predict the performance of an algorithm for many message sizes, giving up above a cost bound.
+	 * @param algo algo_type, the algorithm type to predict.
+	 * @param nl node_list, the node list to use for prediction.
+	 * @param msg_sizes vector<int>, the message sizes to use for prediction.
+	 * @param dp algo_diff_param_t, the algorithm-specific parameters.
+	 * @param bounds vector<double>, the cost bound of each message size.
+	 * @return vector<double>, the predicted performance of each message size if it is not above its bound,
+	 * otherwise the partial cost of the rounds simulated so far, greater than the bound.
+	 * @throws hlop_err, if bounds and msg_sizes differ in size.
+	 * @note The schedule of a planned algorithm stops as soon as every message size is above its bound,
+	 * an algorithm without a planner is predicted in full.
 	 */
-	const std::map<hlop::comm_pair, int> get_contentions(const std::vector<hlop::comm_pair> &pairs) const;
+	const std::vector<double> predict(hlop::algo_type algo, const hlop::node_list_t &nl,
+	                                  const std::vector<int> &msg_sizes, const hlop::algo_diff_param_t &dp,
+	                                  const std::vector<double> &bounds) const;
+	/**
+	 * @brief a cheap lower bound of the performance of an algorithm.
+	 * @param algo algo_type, the algorithm type.
+	 * @param nl node_list, the node list to use for prediction.
+	 * @param msg_sizes vector<int>, the message sizes to use for prediction.
+	 * @return vector<double>, one bound for each message size, 0 if the algorithm has no shape.
+	 * @note No pair is generated, each round of the shape of the algorithm costs at least
+	 * the cheapest latency of any category at the power of 2 below its message size.
+	 * The bound is only used to order the candidates of select_best.
+	 */
+	const std::vector<double> lower_bound(hlop::algo_type algo, const hlop::node_list_t &nl,
+	                                      const std::vector<int> &msg_sizes) const;
+	/**
+	 * @brief rank all algorithms of this operation for a message size.
+	 * @param nl node_list, the node list to use for prediction, shared by all algorithms.
+	 * @param msg_size int, the message size to use for prediction.
+	 * @param dp algo_diff_param_t, the algorithm-specific parameters.
+	 * @return vector<algo_rank>, every available algorithm, the predicted ones first from the fastest,
+	 * then the failed and the unimplemented ones.
+	 * @note The algorithms are predicted concurrently on the shared thread pool.
+	 */
+	const std::vector<hlop::algo_rank_t> select_best(const hlop::node_list_t &nl, int msg_size,
+	                                                 const hlop::algo_diff_param_t &dp) const;
+	/**
+	 * @brief rank all algorithms of this operation for many message sizes.
+	 * @param nl node_list, the node list to use for prediction, shared by all algorithms.
+	 * @param msg_sizes vector<int>, the message sizes to use for prediction.
+	 * @param dp algo_diff_param_t, the algorithm-specific parameters.
+	 * @param pool thread_pool *, the pool to predict the algorithms on, in the calling thread if nullptr.
+	 * @param prune bool, only the best algorithm of each message size has to be exact if true.
+	 * @return vector<vector<algo_rank>>, the ranking of each message size, see the overload of one message size,
+	 * the pruned algorithms are ranked after the predicted ones by their partial cost.
+	 * @note Each algorithm is one task that predicts all message sizes. An algorithm that throws is reported
+	 * as FAILED, a stub is reported as UNIMPLEMENTED without being called, neither aborts the ranking.
+	 * With prune, the algorithms start in the order of their lower bound and each one is bounded by
+	 * the best cost finished so far, a message size whose partial cost passes the bound is PRUNED.
+	 * Do not call it with pool from a task of the same pool.
+	 */
+	const std::vector<std::vector<hlop::algo_rank_t>> select_best(const hlop::node_list_t &nl,
+	                                                              const std::vector<int> &msg_sizes,
+	                                                              const hlop::algo_diff_param_t &dp,
+	                                                              hlop::thread_pool_t *pool,
+	                                                              bool prune = false) const;
+	/**
+	 * @brief check if an algorithm has a planner, i.e. its schedule does not depend on the message size.
+	 * @param algo algo_type, the algorithm type to check.
+	 * @return bool, true if make_plan supports the algorithm, false otherwise.
+	 */
+	bool has_plan(hlop::algo_type algo) const;
+	/**
+	 * @brief simulate the schedule of an algorithm once.
+	 * @param algo algo_type, the algorithm type to plan.
+	 * @param nl node_list, the node list to use for prediction.
+	 * @param dp algo_diff_param_t, the algorithm-specific parameters.
+	 * @return plan, the schedule of the algorithm, to be evaluated for any message size.
+	 * @throws hlop_err, if the operation does not have the algorithm or the algorithm has no planner.
+	 */
+	const hlop::plan_t make_plan(hlop::algo_type algo, const hlop::node_list_t &nl, const hlop::algo_diff_param_t &dp) const;
+	/**
+	 * @brief evaluate a plan for a message size.
+	 * @param p plan, the plan to evaluate.
+	 * @param msg_size int, the message size of the collective.
+	 * @return double, the predicted performance, the same as predict of the planned algorithm.
+	 */
+	const double evaluate(const hlop::plan_t &p, int msg_size) const;
+	/**
+	 * @brief evaluate a plan for many message sizes.
+	 * @param p plan, the plan to evaluate.
+	 * @param msg_sizes vector<int>, the message sizes of the collective.
+	 * @return vector<double>, the predicted performance, one for each message size.
+	 * @note It costs O(rounds x groups) batched parameter lookups, no communication pair is generated.
+	 */
+	const std::vector<double> evaluate(const hlop::plan_t &p, const std::vector<int> &msg_sizes) const;
 
+protected:
 	/**
 	 * @brief calculate the cost of this communication round.
 	 * @param nl node_list, where communication happens.
-	 * @param pairs vector<comm_pair>, the communication pairs involved in this round.
+	 * @param r comm_round, the communication pairs involved in this round, its contentions are counted here.
 	 * @param msg_size int, the size of the message being communicated.
 	 * @return double, the cost of this communication round.
+	 * @note The cost is looked up in round_cost_cache by the canonical contention histogram of the round,
+	 * the parameters are only looked up on a miss.
 	 */
 	virtual const double calc_cost(const hlop::node_list_t &nl,
-	                               const std::vector<hlop::comm_pair> &pairs,
+	                               hlop::comm_round_t &r,
 	                               int msg_size) const;
+	/**
+	 * @brief calculate the cost of a communication round from its contention histogram.
+	 * @param nl node_list, where communication happens.
+	 * @param groups vector<plan_group>, the canonical contention histogram of the round.
+	 * @param msg_size int, the size of the message being communicated.
+	 * @return double, the cost of this communication round.
+	 * @note For the predictors that build the histogram without the pairs, see append_symmetric_histogram.
+	 */
+	const double calc_cost(const hlop::node_list_t &nl,
+	                       const std::vector<hlop::plan_group_t> &groups,
+	                       int msg_size) const;
 	/**
 	 * @brief initialize the function table with predictor handlers.
 	 * @return void.
 	 * @note This function should populate the ftbl with the predictor handlers for each algorithm.
 	 * It is called in the constructor of the derived class to ensure that the function table is initialized
 	 * before any predictions are made.
-	 * Derived classes should implement this function to provide the specific predictors for each algorithm.
+	 * Derived classes should implement this function to provide the specific predictors for each algorithm,
+	 * the planners of the algorithms whose schedule does not depend on the message size with their shapes,
+	 * and the stubs, the algorithms whose predictor only throws.
 	 */
 	virtual void initialize_ftbl() = 0;
 
+private:
+	/**
+	 * @brief add the cost of a round of a plan to some message sizes.
+	 * @param p plan, the plan of the round.
+	 * @param r plan_round, the round to price.
+	 * @param msg_sizes vector<int>, the message sizes of the collective.
+	 * @param live vector<size_t>, the indices of the message sizes to price.
+	 * @param cost vector<double>, input and output, the cost of each message size.
+	 */
+	void accumulate(const hlop::plan_t &p, const hlop::plan_round_t &r, const std::vector<int> &msg_sizes,
+	                const std::vector<std::size_t> &live, std::vector<double> &cost) const;
+	/**
+	 * @brief predict an algorithm for many message sizes with bounds that may tighten meanwhile.
+	 * @param algo algo_type, the algorithm type to predict.
+	 * @param nl node_list, the node list to use for prediction.
+	 * @param msg_sizes vector<int>, the message sizes to use for prediction.
+	 * @param dp algo_diff_param_t, the algorithm-specific parameters.
+	 * @param bound function<double(size_t)>, the current cost bound of a message size.
+	 * @param pruned vector<bool>, output, whether each message size passed its bound.
+	 * @return vector<double>, the cost of each message size, partial if it is pruned.
+	 */
+	const std::vector<double> predict_bounded(hlop::algo_type algo, const hlop::node_list_t &nl,
+	                                          const std::vector<int> &msg_sizes, const hlop::algo_diff_param_t &dp,
+	                                          const std::function<double(std::size_t)> &bound,
+	                                          std::vector<bool> &pruned) const;
+
 protected:
 	std::unordered_map<hlop::algo_type, predictor_handler> ftbl;
+	std::unordered_map<hlop::algo_type, planner_handler> plan_ftbl; // optional, algorithms whose schedule does not depend on the message size
+	std::unordered_map<hlop::algo_type, shape_handler> shape_ftbl;  // optional, scales of the rounds of an algorithm, for lower_bound
+	std::unordered_set<hlop::algo_type> stubs;                      // algorithms in ftbl that are not implemented yet
 	std::optional<const hlop::param> small_scales_param;
 	std::optional<const hlop::param> other_param;
 };
@@ -0,0 +1,28 @@
+#ifndef __FACTORY_H__
+#define __FACTORY_H__
+
+#include <memory>
+#include <vector>
+
+#include "collective.h"
+#include "struct/type.h"
+
+namespace hlop {
+/**
+ * @brief get the operations that have a predictor.
+ * @return vector<op_type>, the operations of make_collective, in the order of op_type.
+ */
+const std::vector<hlop::op_type_t> &get_collective_ops();
+
+/**
+ * @brief create the predictor of an operation.
+ * @param op op_type, the operation type.
+ * @return unique_ptr<collective>, the predictor.
+ * @throws hlop_err, if the operation type is not supported, see get_collective_ops.
+ * @note This is the one place that maps an operation to its predictor, the cli, the tools, hlopd and libhlop
+ * create their predictors with it.
+ */
+std::unique_ptr<hlop::collective> make_collective(hlop::op_type_t op);
+} // namespace hlop
+
+#endif // __FACTORY_H__
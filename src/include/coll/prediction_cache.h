@@ -0,0 +1,134 @@
+#ifndef __PREDICTION_CACHE_H__
+#define __PREDICTION_CACHE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "collective.h"
+#include "disk_cache.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+namespace hlop {
+/**
+ * @brief struct prediction cache statistics.
+ */
+struct prediction_cache_stats {
+	std::uint64_t hits;
+	std::uint64_t misses;
+	std::size_t capacity;
+};
+typedef prediction_cache_stats prediction_cache_stats_t;
+
+std::ostream &operator<<(std::ostream &os, const hlop::prediction_cache_stats_t &s);
+
+/**
+ * @brief class prediction cache.
+ * This class keeps predictions in a disk_cache file across runs and processes.
+ * A prediction is keyed by the fingerprint of its topology, the expanded node names, the platform,
+ * the processes per node, the arrangement and the placement of an explicit rank set,
+ * with the operation, the algorithm (the best one for select_best), the root, the message size
+ * and collective::get_param_fingerprint, so an entry of other parameter files is never hit and ages out.
+ * Only the successful predictions are kept. All methods are thread-safe.
+ * @throws hlop_err, if the cache file cannot be opened.
+ */
+class prediction_cache {
+public:
+	using prediction_cache_t = hlop::prediction_cache;
+
+	/// @brief default number of predictions of a new cache file, 48 bytes each.
+	static constexpr std::size_t DEFAULT_CAPACITY = 1 << 20;
+
+public:
+	prediction_cache() = delete;
+	/**
+	 * @brief constructor of prediction_cache, open a cache file, it is created if it does not exist.
+	 * @param path string, the cache file.
+	 * @param capacity size_t, the number of predictions of a new file, an existing file keeps its own.
+	 * @throws hlop_err, if the file cannot be opened, or it is not a cache file of this version.
+	 */
+	explicit prediction_cache(const std::string &path, std::size_t capacity = DEFAULT_CAPACITY);
+
+public:
+	/**
+	 * @brief get the fingerprint of a node list.
+	 * @param nl node_list, the node list.
+	 * @return disk_cache_key, the fingerprint, the same for node lists of the same nodes and ranks
+	 * however their node list string is written.
+	 */
+	static const hlop::disk_cache_key_t fingerprint(const hlop::node_list_t &nl);
+	/**
+	 * @brief predict an algorithm for many message sizes, the cached ones are not predicted again.
+	 * @param c collective, the predictor of op.
+	 * @param op op_type, the operation of c.
+	 * @param algo algo_type, the algorithm.
+	 * @param nl node_list, the node list.
+	 * @param msg_sizes vector<int>, the message sizes.
+	 * @param root int, the root rank, passed to the predictor as algo_diff_param.
+	 * @return vector<double>, the predicted time of each message size.
+	 * @throws hlop_err, if the prediction fails.
+	 */
+	const std::vector<double> predict(const hlop::collective &c, hlop::op_type_t op, hlop::algo_type_t algo,
+	                                  const hlop::node_list_t &nl, const std::vector<int> &msg_sizes, int root = 0);
+	/**
+	 * @brief select the best algorithm for many message sizes, the cached ones are not ranked again.
+	 * @param c collective, the predictor of op.
+	 * @param op op_type, the operation of c.
+	 * @param nl node_list, the node list.
+	 * @param msg_sizes vector<int>, the message sizes.
+	 * @param prune bool, see collective::select_best.
+	 * @param root int, the root rank, passed to the predictor as algo_diff_param.
+	 * @return vector<algo_rank>, the best algorithm of each message size, the first of its ranking,
+	 * its status is not OK if no algorithm could be predicted.
+	 * @note The ranking is made in the calling thread.
+	 */
+	const std::vector<hlop::algo_rank_t> select_best(const hlop::collective &c, hlop::op_type_t op,
+	                                                 const hlop::node_list_t &nl, const std::vector<int> &msg_sizes,
+	                                                 bool prune, int root = 0);
+	/**
+	 * @brief look a prediction up.
+	 * @param topology disk_cache_key, the fingerprint of the node list.
+	 * @param op op_type, the operation.
+	 * @param algo optional<algo_type>, the algorithm, empty for the best one.
+	 * @param root int, the root rank.
+	 * @param msg_size int, the message size.
+	 * @param r algo_rank, output, the prediction if found, its status is OK.
+	 * @return bool, true on a hit.
+	 */
+	bool find(const hlop::disk_cache_key_t &topology, hlop::op_type_t op, std::optional<hlop::algo_type_t> algo,
+	          int root, int msg_size, hlop::algo_rank_t &r);
+	/**
+	 * @brief keep a prediction, nothing is kept if its status is not OK.
+	 * @param topology disk_cache_key, the fingerprint of the node list.
+	 * @param op op_type, the operation.
+	 * @param algo optional<algo_type>, the algorithm, empty for the best one.
+	 * @param root int, the root rank.
+	 * @param msg_size int, the message size.
+	 * @param r algo_rank, the prediction.
+	 */
+	void insert(const hlop::disk_cache_key_t &topology, hlop::op_type_t op, std::optional<hlop::algo_type_t> algo,
+	            int root, int msg_size, const hlop::algo_rank_t &r);
+	/**
+	 * @brief get the hit and miss counters of this process.
+	 * @return prediction_cache_stats, the statistics.
+	 */
+	const hlop::prediction_cache_stats_t get_stats() const;
+
+private:
+	const hlop::disk_cache_key_t key(const hlop::disk_cache_key_t &topology, hlop::op_type_t op,
+	                                 std::optional<hlop::algo_type_t> algo, int root, int msg_size) const;
+
+private:
+	hlop::disk_cache_t cache;
+	std::uint64_t param_fp;
+	std::atomic<std::uint64_t> hits{0}, misses{0};
+};
+typedef prediction_cache::prediction_cache_t prediction_cache_t;
+} // namespace hlop
+
+#endif // __PREDICTION_CACHE_H__
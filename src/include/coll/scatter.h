@@ -24,7 +24,7 @@ private:
 	 * @param dp algo_diff_param, the algorithm-specific parameters (e.g., root rank).
 	 * @return double, the predicted performance of the binomial algorithm.
 	 */
-	double binomial(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp);
+	double binomial(const hlop::node_list_t &nl, int msg_size, const hlop::algo_diff_param_t &dp) const;
 
 private:
 	/**
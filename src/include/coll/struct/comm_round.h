@@ -0,0 +1,80 @@
+#ifndef __COMM_ROUND_H__
+#define __COMM_ROUND_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "struct/flat_pair.h"
+#include "struct/node_list.h"
+
+namespace hlop {
+/**
+ * @brief struct contention.
+ * A contended link of a round, the first pair on the link and the number of pairs sharing it.
+ */
+struct contention {
+	hlop::flat_pair_t pair;
+	int count;
+};
+typedef contention contention_t;
+
+/**
+ * @brief class communication round.
+ * This class is a reusable flat buffer of the communication pairs of one round,
+ * together with the scratch used to count their contentions.
+ * An algorithm keeps one round for all of its rounds and clears it between them,
+ * so that simulating a round neither allocates nor follows pointers once the buffers have grown.
+ */
+class comm_round {
+public:
+	using comm_round_t = hlop::comm_round;
+
+public:
+	comm_round() = default;
+	~comm_round() = default;
+
+public:
+	/**
+	 * @brief remove all pairs, the buffers keep their capacity.
+	 */
+	void clear();
+	/**
+	 * @brief add a communication pair.
+	 * @param nl node_list, where communication happens.
+	 * @param src_rank int, source rank.
+	 * @param dst_rank int, destination rank.
+	 * @throws hlop_err, if a rank is not in the node list.
+	 */
+	void add(const hlop::node_list_t &nl, int src_rank, int dst_rank);
+	/**
+	 * @brief get the communication pairs of this round.
+	 * @return vector<flat_pair>, the pairs in the order they were added.
+	 */
+	const std::vector<hlop::flat_pair_t> &get_pairs() const;
+	/**
+	 * @brief count the contentions of this round.
+	 * @param nl node_list, where communication happens.
+	 * @return vector<contention>, each contended link with its first pair and contention count,
+	 * in the order of first appearance, valid until the next call.
+	 * @note The links are counted in one hashed pass:
+	 * - inter-node pairs that link the same two nodes in either direction share one link
+	 * - intra-node pairs share one link if they link the same units (the same unit for intra-unit pairs)
+	 *   as the first pair of their node, other intra-node pairs of that node are not counted
+	 * This is the equivalence of comm_pair::operator== as counted by the former std::map based version.
+	 */
+	const std::vector<hlop::contention_t> &count_contentions(const hlop::node_list_t &nl);
+
+private:
+	std::vector<hlop::flat_pair_t> pairs;
+	std::vector<hlop::contention_t> contentions;
+	std::vector<int> node_entry;            // per node, index of its intra-node contention, -1 if none
+	std::vector<std::uint64_t> link_keys;   // open addressing table of inter-node links, (min node, max node)
+	std::vector<int> link_entry;            // index of the contention of each table slot
+	std::vector<std::uint32_t> link_stamp;  // a table slot is used if it holds the current stamp
+	std::uint32_t stamp = 0;
+};
+typedef comm_round::comm_round_t comm_round_t;
+} // namespace hlop
+
+#endif // __COMM_ROUND_H__
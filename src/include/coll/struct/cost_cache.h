@@ -0,0 +1,148 @@
+#ifndef __COST_CACHE_H__
+#define __COST_CACHE_H__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "param/param.h"
+#include "struct/plan.h"
+
+namespace hlop {
+/**
+ * @brief struct cost cache statistics.
+ */
+struct cost_cache_stats {
+	std::uint64_t hits;
+	std::uint64_t misses;
+	std::size_t size;
+	std::size_t capacity;
+};
+typedef cost_cache_stats cost_cache_stats_t;
+
+std::ostream &operator<<(std::ostream &os, const hlop::cost_cache_stats_t &s);
+
+/**
+ * @brief class cost cache.
+ * This class is a bounded least recently used cache of the cost of a round,
+ * keyed by the canonical contention histogram of the round (see plan::append_histogram),
+ * the message size of the round, whether the bandwidth term always applies, and the parameter set.
+ * All methods are thread-safe. The entries are split into NSHARD shards by the hash of their key,
+ * each with its own lock and least recently used list, so concurrent predictions rarely wait on each other,
+ * the capacity is split evenly among the shards.
+ * @note The cost only depends on the distinct parameter keys of a round,
+ * so the link counts of the histogram are not part of the key.
+ */
+class cost_cache {
+public:
+	using cost_cache_t = hlop::cost_cache;
+
+	/// @brief number of shards of the cache.
+	static constexpr std::size_t NSHARD = 16;
+
+public:
+	cost_cache() = delete;
+	/**
+	 * @brief constructor of cost_cache.
+	 * @param capacity size_t, the maximum number of entries, 0 disables the cache.
+	 */
+	explicit cost_cache(std::size_t capacity);
+	~cost_cache() = default;
+
+public:
+	/**
+	 * @brief look up the cost of a round, the entry becomes the most recently used one.
+	 * @param groups const plan_group *, the canonical histogram of the round.
+	 * @param n size_t, the number of groups.
+	 * @param msg_size int, the message size of the round.
+	 * @param all_bw bool, whether the bandwidth term applies to every message size.
+	 * @param param_set const void *, the identity of the parameters the cost is computed with.
+	 * @param cost double, output, the cost of the round if found.
+	 * @return bool, true on a hit, false otherwise.
+	 */
+	bool find(const hlop::plan_group_t *groups, std::size_t n, int msg_size, bool all_bw, const void *param_set,
+	          double &cost);
+	/**
+	 * @brief insert the cost of a round, the least recently used entry is evicted if the cache is full.
+	 * @param groups const plan_group *, the canonical histogram of the round.
+	 * @param n size_t, the number of groups.
+	 * @param msg_size int, the message size of the round.
+	 * @param all_bw bool, whether the bandwidth term applies to every message size.
+	 * @param param_set const void *, the identity of the parameters the cost is computed with.
+	 * @param cost double, the cost of the round.
+	 */
+	void insert(const hlop::plan_group_t *groups, std::size_t n, int msg_size, bool all_bw, const void *param_set,
+	            double cost);
+	/**
+	 * @brief change the maximum number of entries, the least recently used entries are evicted.
+	 * @param capacity size_t, the maximum number of entries, 0 disables the cache.
+	 */
+	void set_capacity(std::size_t capacity);
+	/**
+	 * @brief remove all entries and reset the counters.
+	 */
+	void clear();
+	/**
+	 * @brief get the hit and miss counters and the size of the cache.
+	 * @return cost_cache_stats, the statistics.
+	 */
+	const hlop::cost_cache_stats_t get_stats() const;
+
+private:
+	struct entry {
+		std::uint64_t hash;
+		std::vector<hlop::param_key_t> keys;
+		int msg_size;
+		bool all_bw;
+		const void *param_set;
+		double cost;
+	};
+	using entry_iter = std::list<entry>::iterator;
+
+	/// @brief a shard of the cache, aligned to a cache line so that shards do not share one.
+	struct alignas(64) shard {
+		mutable std::mutex mtx;
+		std::list<entry> lru; // most recently used first
+		std::unordered_multimap<std::uint64_t, entry_iter> index;
+		std::size_t capacity = 0;
+	};
+
+	/**
+	 * @brief hash a key of the cache.
+	 * @return uint64_t, the hash of the key.
+	 */
+	static std::uint64_t hash(const hlop::plan_group_t *groups, std::size_t n, int msg_size, bool all_bw,
+	                          const void *param_set);
+	/**
+	 * @brief get the shard of a hash.
+	 * @return shard, the shard, chosen by the high bits of the hash, the index of a shard uses all of them.
+	 */
+	shard &shard_of(std::uint64_t h);
+	/**
+	 * @brief find the entry of a key in its shard, the caller holds the lock of the shard.
+	 * @return entry_iter, the entry, s.lru.end() if not found.
+	 */
+	static entry_iter lookup(shard &s, std::uint64_t h, const hlop::plan_group_t *groups, std::size_t n,
+	                         int msg_size, bool all_bw, const void *param_set);
+	/**
+	 * @brief evict the least recently used entries of a shard until its size fits its capacity,
+	 * the caller holds the lock of the shard.
+	 */
+	static void shrink(shard &s);
+
+private:
+	std::array<shard, NSHARD> shards;
+	std::atomic<std::size_t> capacity;
+	std::atomic<std::uint64_t> hits{0};
+	std::atomic<std::uint64_t> misses{0};
+};
+typedef cost_cache::cost_cache_t cost_cache_t;
+} // namespace hlop
+
+#endif // __COST_CACHE_H__
@@ -0,0 +1,48 @@
+#ifndef __FLAT_PAIR_H__
+#define __FLAT_PAIR_H__
+
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+
+namespace hlop {
+/**
+ * @brief struct flat communication pair.
+ * Trivially copyable form of a communication pair used by the round simulation.
+ * Node ids are indices in the node list, unit ids are core units in the node,
+ * so a pair is compared and hashed without touching any node object.
+ * @note A middle pair (sendrecv) has no flat form, use comm_pair for it.
+ */
+struct flat_pair {
+	std::int32_t src_rank;
+	std::int32_t dst_rank;
+	std::int32_t src_node;
+	std::int32_t dst_node;
+	std::int16_t src_unit;
+	std::int16_t dst_unit;
+
+	/**
+	 * @brief check whether this pair is in the same node.
+	 * @return bool, true if it is an intra-node pair, false otherwise.
+	 */
+	bool is_intra_node_pair() const { return src_node == dst_node; }
+	/**
+	 * @brief check whether this pair is in different node.
+	 * @return bool, true if it is an inter-node pair, false otherwise.
+	 */
+	bool is_inter_node_pair() const { return src_node != dst_node; }
+	/**
+	 * @brief check whether this pair is in the same node core unit.
+	 * @return bool, true if it is an intra-unit pair, false otherwise.
+	 */
+	bool is_intra_unit_pair() const { return src_node == dst_node && src_unit == dst_unit; }
+};
+typedef flat_pair flat_pair_t;
+
+static_assert(std::is_trivially_copyable<hlop::flat_pair_t>::value, "flat_pair must be trivially copyable");
+static_assert(sizeof(hlop::flat_pair_t) == 20, "flat_pair must stay compact");
+
+std::ostream &operator<<(std::ostream &os, const hlop::flat_pair_t &p);
+} // namespace hlop
+
+#endif // __FLAT_PAIR_H__
@@ -1,15 +1,17 @@
 #ifndef __NODE_LIST_H__
 #define __NODE_LIST_H__
 
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "node/node.h"
 #include "platform.h"
 #include "struct/comm_pair.h"
+#include "struct/flat_pair.h"
 #include "struct/type.h"
 
 namespace hlop {
@@ -20,11 +22,20 @@ namespace hlop {
  * such as the number of cores, the number of nodes, and the network level between nodes.
  * It also allows for the retrieval of node names by process ranks
  * and provides functionality to check if a node is part of the list.
+ * Ranks of a regular (BLOCK or CYCLIC) arrangement are mapped arithmetically and store nothing per rank,
+ * only an explicit rank set keeps dense per-rank arrays of node index, core and unit.
+ * Nodes are given packed integer coordinates of their network groups when the list is parsed,
+ * so the net level between two nodes is the highest group in which their coordinates differ.
  * @throws hlop_err, if the node list is not valid or if the number of processes per node exceeds the maximum allowed.
+ * @note A node list is a frozen snapshot of the topology, every member is computed by the constructors
+ * and never changes, its nodes are const. It may be shared between threads as const_node_list_ptr
+ * and the collectives predict against it concurrently.
  */
 class node_list {
 public:
 	using node_list_t = hlop::node_list;
+	using const_node_list_ptr = std::shared_ptr<const hlop::node_list>;
+	using const_node_list_ptr_t = const_node_list_ptr;
 
 private:
 	using rank_util_handler = std::function<int(int, hlop::rank_arrangement_t, const node_list_t &)>;
@@ -61,6 +72,19 @@ public:
 	 * @throws hlop_err, if the ranks are not in the range [0, ppn * nlist.size() - 1].
 	 */
 	node_list(hlop::platform_t pf, const std::string &node_list_str, int ppn, hlop::arrangement_t rule, std::vector<int> ranks);
+	/**
+	 * @brief constructor of node_list with an explicit placement of the ranks.
+	 * @param pf platform, the platform type of this node list.
+	 * @param node_list_str string, a string representation of the node list.
+	 * @param ppn int, the number of processes per node.
+	 * @param rank_nodes vector<int>, the index in the node list of the node of each rank.
+	 * @param rank_cores vector<int>, the core each rank is bound to.
+	 * @throws hlop_err, if the vectors are empty or differ in size, a node index or core is out of range,
+	 * a node holds more than ppn ranks or two ranks are bound to the same core.
+	 * @note The arrangement is ARBITRARY, rank i in [0, rank_nodes.size()) is placed by the i-th items.
+	 */
+	node_list(hlop::platform_t pf, const std::string &node_list_str, int ppn, const std::vector<int> &rank_nodes,
+	          const std::vector<int> &rank_cores);
 
 	~node_list() = default;
 
@@ -105,10 +129,29 @@ public:
 	 */
 	const int get_rank_num() const;
 	/**
-	 * @brief get process ranks in this node list.
-	 * @return unordered_map<int, node_cptr>, a map of process ranks with node in this node list.
+	 * @brief get the rank arrangement rule of this node list.
+	 * @return arrangement, the rank arrangement rule.
+	 */
+	const hlop::arrangement_t get_arrangement() const;
+	/**
+	 * @brief check if the ranks follow the arrangement, i.e. they are not an explicit rank set.
+	 * @return bool, true if every rank in [0, ppn * node_num) is mapped arithmetically.
 	 */
-	const std::unordered_map<int, hlop::const_node_ptr> &get_ranks() const;
+	const bool is_regular() const;
+	/**
+	 * @brief get the number of consecutive nodes of a group of each net level.
+	 * @return vector<int>, indexed by net level, 1 for level 0, 0 for a level whose group holds the whole list,
+	 * empty if the groups of a level are not all of the same power of 2 nodes (the last one may be partial).
+	 * @note With spans, the net level between node1 and node2 is the highest level l whose span is not 0
+	 * and node1 / span != node2 / span.
+	 */
+	const std::vector<int> &get_level_spans() const;
+	/**
+	 * @brief check if a process rank is in this node list.
+	 * @param rank int, process rank.
+	 * @return bool, true if the rank is in this list.
+	 */
+	const bool has_rank(int rank) const;
 	/**
 	 * @brief get level between rank1 and rank2.
 	 * @param rank1 int, rank bind to node1, core1.
@@ -123,6 +166,12 @@ public:
 	 * @return int, the core level between cores in the communication pair.
 	 */
 	const int get_level(const hlop::comm_pair_t &cp) const;
+	/**
+	 * @brief get level between nodes or units in this flat communication pair.
+	 * @param fp flat_pair, flat communication pair.
+	 * @return int, the core level for an intra-node pair, the net level otherwise.
+	 */
+	const int get_level(const hlop::flat_pair_t &fp) const;
 	/**
 	 * @brief get node name by process rank.
 	 * @param rank int, process rank.
@@ -135,6 +184,27 @@ public:
 	 * @return const_node_ptr, a pointer to the node corresponding to the process rank.
 	 */
 	hlop::const_node_ptr_t get_node_ptr_by_rank(int rank) const;
+	/**
+	 * @brief get the index of the node of a process rank in this node list.
+	 * @param rank int, process rank.
+	 * @return int, the index of the node in get_node_list().
+	 * @throws hlop_err, if the rank is not in this list.
+	 */
+	const int get_node_id_by_rank(int rank) const;
+	/**
+	 * @brief get the core a process rank is bound to.
+	 * @param rank int, process rank.
+	 * @return int, the core id in the node of the rank.
+	 * @throws hlop_err, if the rank is not in this list.
+	 */
+	const int get_core_id_by_rank(int rank) const;
+	/**
+	 * @brief get the core unit id of a process rank.
+	 * @param rank int, process rank.
+	 * @return int, the unit id of the core the rank is bound to.
+	 * @throws hlop_err, if the rank is not in this list.
+	 */
+	const int get_unit_id_by_rank(int rank) const;
 	/**
 	 * @brief get the first k node in this node list.
 	 * @param k int, the number of top nodes to retrieve.
@@ -143,13 +213,45 @@ public:
 	 */
 	const std::vector<hlop::const_node_ptr> get_top_k_nodes(int k) const;
 
+private:
+	/**
+	 * @brief map a rank of a regular arrangement to its node index and core.
+	 * @param rank int, process rank in range [0, ppn * node_num).
+	 * @param node_id int, output, the index of the node in get_node_list().
+	 * @param core_id int, output, the core id in the node.
+	 */
+	void map_rank(int rank, int &node_id, int &core_id) const;
+	/**
+	 * @brief get the net level between two nodes of this list by their coordinates.
+	 * @param node1 int, index of the first node.
+	 * @param node2 int, index of the second node.
+	 * @return int, the net level between the nodes.
+	 * @throws hlop_err, if the nodes are in the same bottom level group.
+	 */
+	const int get_net_level(int node1, int node2) const;
+
 private:
 	std::vector<hlop::const_node_ptr> nlist;
-	std::unordered_map<int, hlop::const_node_ptr> rmap;
 	int nproc_per_node;
 	hlop::platform_t platform;
+	hlop::arrangement_t rule;
+	int nrank;
+	int numa_num;
+	int ncore_per_numa;
+	int ncore_per_unit;
+	// coordinates of each node, one field of level_bits bits per level with the top level in the highest bits,
+	// a field is the index of the group the node belongs to at that level
+	std::vector<std::uint64_t> node_coord;
+	int level_bits;
+	std::vector<int> level_span; // nodes of a group of each net level, see get_level_spans
+	// per-rank arrays of an explicit rank set indexed by rank, empty for a regular arrangement
+	std::vector<std::int32_t> rank_node; // node index of each rank, -1 if the rank is not in this list
+	std::vector<std::int16_t> rank_core; // core id of each rank
+	std::vector<std::int16_t> rank_unit; // unit id of each rank
 };
 typedef node_list::node_list_t node_list_t;
+typedef node_list::const_node_list_ptr const_node_list_ptr;
+typedef node_list::const_node_list_ptr_t const_node_list_ptr_t;
 
 std::ostream &operator<<(std::ostream &os, const node_list_t &nl);
 } // namespace hlop
@@ -0,0 +1,131 @@
+#ifndef __PLAN_H__
+#define __PLAN_H__
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "param/param.h"
+#include "struct/comm_round.h"
+#include "struct/node_list.h"
+
+namespace hlop {
+/**
+ * @brief struct plan group.
+ * The contended links of a round that are priced with the same parameter key.
+ */
+struct plan_group {
+	hlop::param_key_t key;
+	int links;
+};
+typedef plan_group plan_group_t;
+
+/**
+ * @brief struct plan round.
+ * A round of a plan, its groups are [begin, end) of the plan groups,
+ * it sends scale times the message size of the collective.
+ */
+struct plan_round {
+	std::size_t begin;
+	std::size_t end;
+	int scale;
+};
+typedef plan_round plan_round_t;
+
+/**
+ * @brief struct mask pattern.
+ * The pairs of a round of a butterfly schedule relative to rank 0, (rank, rank + mask)
+ * for every rank below limit with rank % (2 * mask) < len and rank + mask < the number of ranks,
+ * e.g., a round of binomial bcast has len 1, a round of recursive doubling allgather has len mask,
+ * a round of binomial scatter is limited to the ranks that still hold a part of the message.
+ */
+struct mask_pattern {
+	int mask;
+	int len;
+	int limit = std::numeric_limits<int>::max();
+};
+typedef mask_pattern mask_pattern_t;
+
+/**
+ * @brief class plan.
+ * This class is the schedule of a collective algorithm on a node list, simulated once.
+ * Each round keeps its contention histogram, the distinct parameter keys of its contended links
+ * sorted by (class, level, contention), and the factor of its message size,
+ * so that the plan is evaluated for any message size without generating a communication pair again
+ * (see collective::evaluate). It is the counterpart of a persistent collective in MPI.
+ * @note A plan only holds values, it stays valid when the node list it was made of is gone.
+ * The round hook is the exception, it is meant for the plan being made and should not outlive what it refers to.
+ */
+class plan {
+public:
+	using plan_t = hlop::plan;
+	/// @brief called after each round is added, returns false to stop the simulation of the schedule.
+	using round_hook = std::function<bool(const plan_t &)>;
+
+public:
+	plan() = default;
+	plan(round_hook hook);
+	~plan() = default;
+
+public:
+	friend std::ostream &operator<<(std::ostream &os, const plan_t &p);
+
+public:
+	/**
+	 * @brief append the canonical contention histogram of a round.
+	 * @param nl node_list, where communication happens.
+	 * @param r comm_round, the communication pairs of the round, its contentions are counted here.
+	 * @param groups vector<plan_group>, output, one group for each distinct parameter key of the contended links
+	 * is appended, sorted by (class, level, contention).
+	 */
+	static void append_histogram(const hlop::node_list_t &nl, hlop::comm_round_t &r,
+	                             std::vector<hlop::plan_group_t> &groups);
+	/**
+	 * @brief append a round.
+	 * @param nl node_list, where communication happens.
+	 * @param r comm_round, the communication pairs of the round, its contentions are counted here.
+	 * @param scale int, the message size of the round divided by the message size of the collective.
+	 * @return bool, false if the round hook asks to stop, the planner should not add any further round.
+	 * @throws hlop_err, if the node list differs in size from the one of the previous rounds.
+	 */
+	bool add_round(const hlop::node_list_t &nl, hlop::comm_round_t &r, int scale);
+	/**
+	 * @brief append a round of a mask pattern, priced from the classes of its pairs.
+	 * @param nl node_list, where communication happens, is_symmetric (see symmetric.h) must hold.
+	 * @param mp mask_pattern, the pairs of the round.
+	 * @param scale int, the message size of the round divided by the message size of the collective.
+	 * @return bool, false if the round hook asks to stop, the planner should not add any further round.
+	 * @throws hlop_err, if the node list is not symmetric or differs in size from the one of the previous rounds.
+	 * @note The round is the same as the round of the enumerated pairs of the pattern, no pair is generated.
+	 */
+	bool add_round(const hlop::node_list_t &nl, const hlop::mask_pattern_t &mp, int scale);
+	/**
+	 * @brief get the rounds of this plan.
+	 * @return vector<plan_round>, the rounds in the order of the schedule.
+	 */
+	const std::vector<hlop::plan_round_t> &get_rounds() const;
+	/**
+	 * @brief get the groups of all rounds of this plan.
+	 * @return vector<plan_group>, the groups, a round refers to a range of them.
+	 */
+	const std::vector<hlop::plan_group_t> &get_groups() const;
+	/**
+	 * @brief get the number of nodes of the node list this plan is made of.
+	 * @return int, the number of nodes, 0 if the plan has no round.
+	 */
+	const int get_node_num() const;
+
+private:
+	std::vector<hlop::plan_round_t> rounds;
+	std::vector<hlop::plan_group_t> groups;
+	int node_num = 0;
+	round_hook hook;
+};
+typedef plan::plan_t plan_t;
+
+std::ostream &operator<<(std::ostream &os, const plan_t &p);
+} // namespace hlop
+
+#endif // __PLAN_H__
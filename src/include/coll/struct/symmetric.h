@@ -0,0 +1,35 @@
+#ifndef __SYMMETRIC_H__
+#define __SYMMETRIC_H__
+
+#include <vector>
+
+#include "struct/node_list.h"
+#include "struct/plan.h"
+
+namespace hlop {
+/**
+ * @brief check if the rounds of a node list can be priced from the classes of their pairs.
+ * @param nl node_list, where communication happens.
+ * @return bool, true if the ranks are a regular BLOCK arrangement of a power of 2 processes per node
+ * and the groups of every net level are uniform, see node_list::get_level_spans.
+ * @note Then all nodes hold the same local pairs of a mask pattern, and the pairs between nodes
+ * fall in one class of net level and contention, whatever the number of nodes is.
+ */
+bool is_symmetric(const hlop::node_list_t &nl);
+
+/**
+ * @brief append the canonical contention histogram of a mask pattern round without generating its pairs.
+ * @param nl node_list, where communication happens, is_symmetric must hold.
+ * @param mp mask_pattern, the pairs of the round.
+ * @param groups vector<plan_group>, output, the groups of the round are appended,
+ * the same as plan::append_histogram of the enumerated pairs.
+ * @throws hlop_err, if the node list is not symmetric, the mask and len are not powers of 2 with len <= mask,
+ * or the limit is negative.
+ * @note It costs O(ppn) for a round inside the nodes and O(levels) for a round between them,
+ * the limit splits at most one node or link off the others.
+ */
+void append_symmetric_histogram(const hlop::node_list_t &nl, const hlop::mask_pattern_t &mp,
+                                std::vector<hlop::plan_group_t> &groups);
+} // namespace hlop
+
+#endif // __SYMMETRIC_H__
@@ -78,6 +78,25 @@ typedef rank_arrangement rank_arrangement_t;
 
 std::ostream &operator<<(std::ostream &os, const rank_arrangement_t &ra);
 
+/**
+ * @brief enum class algorithm status.
+ * The status of an algorithm in a ranking of collective::select_best:
+ * - OK, the algorithm is predicted
+ * - PRUNED, the partial cost of the algorithm passed the cost bound, it is not the best
+ * - FAILED, the prediction failed, e.g., a parameter category is missing
+ * - UNIMPLEMENTED, the algorithm is registered but not implemented yet, it is skipped
+ * A ranking is ordered by status first.
+ */
+enum class algo_status {
+	OK,
+	PRUNED,
+	FAILED,
+	UNIMPLEMENTED
+};
+typedef algo_status algo_status_t;
+
+std::ostream &operator<<(std::ostream &os, const algo_status_t &status);
+
 struct arrangement {
 	rank_arrangement_t node_arrange;
 	rank_arrangement_t core_arrange;
@@ -0,0 +1,55 @@
+#ifndef __CLIENT_H__
+#define __CLIENT_H__
+
+#include <cstdint>
+#include <string>
+
+#include "protocol.h"
+
+namespace hlop {
+/**
+ * @brief class hlopd client.
+ * A blocking connection to hlopd over its Unix domain socket, one request at a time.
+ * @throws hlop_err, if the socket fails or the server closes the connection.
+ * @note It is not thread-safe, use a client for each thread.
+ */
+class hlopd_client {
+public:
+	using hlopd_client_t = hlop::hlopd_client;
+
+public:
+	hlopd_client() = delete;
+	/**
+	 * @brief constructor of hlopd_client, connect to the server.
+	 * @param socket_path string, the path of the socket of the server.
+	 * @throws hlop_err, if the connection fails.
+	 */
+	explicit hlopd_client(const std::string &socket_path);
+	hlopd_client(const hlopd_client_t &) = delete;
+	hlopd_client_t &operator=(const hlopd_client_t &) = delete;
+	~hlopd_client();
+
+public:
+	/**
+	 * @brief send a request and wait for its response.
+	 * @param req hlopd_request, the request, its tag is replaced by the next tag of this client.
+	 * @return hlopd_response, the response, ok is false if the server could not answer the query.
+	 * @throws hlop_err, if the connection fails.
+	 */
+	const hlop::hlopd_response_t request(hlop::hlopd_request_t req);
+	/**
+	 * @brief get the counters of the server.
+	 * @return hlopd_stats, the counters.
+	 * @throws hlop_err, if the connection fails.
+	 */
+	const hlop::hlopd_stats_t get_stats();
+
+private:
+	int fd;
+	std::uint32_t next_tag = 0;
+	std::string rbuf; // bytes received after the last response
+};
+typedef hlopd_client::hlopd_client_t hlopd_client_t;
+} // namespace hlop
+
+#endif // __CLIENT_H__
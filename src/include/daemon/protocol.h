@@ -0,0 +1,137 @@
+#ifndef __PROTOCOL_H__
+#define __PROTOCOL_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "platform.h"
+#include "struct/type.h"
+
+namespace hlop {
+/// @brief version of the hlopd protocol, a message of another version is rejected.
+constexpr std::uint8_t HLOPD_PROTOCOL_VERSION = 1;
+/// @brief the largest message, a connection sending a larger one is closed.
+constexpr std::uint32_t HLOPD_MAX_MESSAGE = 1 << 24;
+/// @brief the number of latency buckets of hlopd_stats, bucket i counts latencies in [2^(i-1), 2^i) us.
+constexpr std::size_t HLOPD_LATENCY_BUCKETS = 24;
+
+/**
+ * @brief enum class hlopd message type.
+ * The message types are:
+ * - QUERY, predict an operation on a node list.
+ * - STATS, get the counters of the server.
+ */
+enum class hlopd_msg_type : std::uint8_t {
+	QUERY,
+	STATS
+};
+typedef hlopd_msg_type hlopd_msg_type_t;
+
+/**
+ * @brief struct hlopd request.
+ * A request to hlopd, the fields other than tag and type are only used by a QUERY.
+ * The tag is chosen by the client and echoed in the response.
+ */
+struct hlopd_request {
+	std::uint32_t tag;
+	hlop::hlopd_msg_type_t type;
+	hlop::op_type_t op;
+	std::optional<hlop::algo_type_t> algo; // empty for the best algorithm, see collective::select_best
+	hlop::platform_t pf;
+	hlop::arrangement_t rule;
+	int ppn;
+	bool prune;
+	std::string nl;
+	std::vector<int> msz;
+};
+typedef hlopd_request hlopd_request_t;
+
+/**
+ * @brief struct hlopd result.
+ * The prediction of a message size, the best algorithm of a query without algorithm,
+ * status is FAILED if no algorithm could be predicted.
+ */
+struct hlopd_result {
+	hlop::algo_type_t algo;
+	hlop::algo_status_t status;
+	double time;
+};
+typedef hlopd_result hlopd_result_t;
+
+/**
+ * @brief struct hlopd stats.
+ * The counters of hlopd since it started, the latency is measured from a complete request
+ * to its queued response.
+ */
+struct hlopd_stats {
+	std::uint64_t requests;
+	std::uint64_t errors;
+	std::uint64_t inline_responses; // answered by the event loop from the caches
+	std::uint64_t topology_hits;
+	std::uint64_t topology_misses;
+	std::uint64_t result_hits;
+	std::uint64_t result_misses;
+	std::uint64_t latency_sum_ns;
+	std::uint64_t latency_max_ns;
+	std::array<std::uint64_t, hlop::HLOPD_LATENCY_BUCKETS> latency_hist;
+};
+typedef hlopd_stats hlopd_stats_t;
+
+std::ostream &operator<<(std::ostream &os, const hlop::hlopd_stats_t &s);
+
+/**
+ * @brief struct hlopd response.
+ * The response to a request, results has one item for each message size of a QUERY,
+ * error tells why the request failed if ok is false.
+ */
+struct hlopd_response {
+	std::uint32_t tag;
+	hlop::hlopd_msg_type_t type;
+	bool ok;
+	std::vector<hlop::hlopd_result_t> results;
+	std::string error;
+	hlop::hlopd_stats_t stats;
+};
+typedef hlopd_response hlopd_response_t;
+
+/**
+ * @brief append a request to a buffer, a 32-bit length followed by the message in host byte order.
+ * @param req hlopd_request, the request.
+ * @param buf string, output, the message is appended.
+ * @throws hlop_err, if the message is larger than HLOPD_MAX_MESSAGE.
+ */
+void encode_request(const hlop::hlopd_request_t &req, std::string &buf);
+/**
+ * @brief decode the first request of a buffer.
+ * @param data char *, the buffer.
+ * @param size size_t, the size of the buffer.
+ * @param used size_t, output, the bytes of the request if it is complete.
+ * @param req hlopd_request, output, the request.
+ * @return bool, false if the buffer does not hold a whole request yet.
+ * @throws hlop_err, if the message is malformed, of another version or larger than HLOPD_MAX_MESSAGE.
+ */
+bool decode_request(const char *data, std::size_t size, std::size_t &used, hlop::hlopd_request_t &req);
+/**
+ * @brief append a response to a buffer, see encode_request.
+ * @param res hlopd_response, the response.
+ * @param buf string, output, the message is appended.
+ */
+void encode_response(const hlop::hlopd_response_t &res, std::string &buf);
+/**
+ * @brief decode the first response of a buffer, see decode_request.
+ * @param data char *, the buffer.
+ * @param size size_t, the size of the buffer.
+ * @param used size_t, output, the bytes of the response if it is complete.
+ * @param res hlopd_response, output, the response.
+ * @return bool, false if the buffer does not hold a whole response yet.
+ * @throws hlop_err, if the message is malformed, of another version or larger than HLOPD_MAX_MESSAGE.
+ */
+bool decode_response(const char *data, std::size_t size, std::size_t &used, hlop::hlopd_response_t &res);
+} // namespace hlop
+
+#endif // __PROTOCOL_H__
@@ -0,0 +1,198 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "collective.h"
+#include "prediction_cache.h"
+#include "protocol.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+#include "thread_pool.h"
+
+namespace hlop {
+/**
+ * @brief struct hlopd config.
+ * The socket and the sizes of the pool and the caches of hlopd.
+ */
+struct hlopd_config {
+	std::string socket_path;
+	std::size_t nthread;            // workers answering the cache misses, the number of hardware threads if 0
+	std::size_t topology_capacity;  // node list snapshots kept
+	std::size_t result_capacity;    // predictions of a message size kept
+	std::string cache_path;         // prediction cache file shared with other processes, none if empty
+	std::size_t cache_capacity;     // predictions of a new cache file
+};
+typedef hlopd_config hlopd_config_t;
+
+/**
+ * @brief class hlopd server.
+ * This class answers the requests of hlopd clients on a Unix domain socket with an epoll event loop.
+ * The node lists are kept as snapshots in an LRU cache keyed by the host list as given and by its normalized form,
+ * the expanded host names, with the platform, processes per node and arrangement,
+ * and the predictions in an LRU cache keyed by the 128-bit fingerprint of the node list, the operation,
+ * the algorithm and the message size.
+ * A query whose topology and predictions are all cached is answered by the event loop itself,
+ * the other ones are answered by the worker pool and sent back to the loop.
+ * With a prediction cache file, a worker looks the predictions it misses up in the file before it predicts them,
+ * so the predictions outlive the server and are shared with the other processes of the file.
+ * @throws hlop_err, if the socket cannot be served.
+ * @note The responses of a connection may come out of order, the tag of a response is the tag of its request.
+ */
+class hlopd_server {
+public:
+	using hlopd_server_t = hlop::hlopd_server;
+
+public:
+	hlopd_server() = delete;
+	/**
+	 * @brief constructor of hlopd_server, create the socket and listen on it.
+	 * @param config hlopd_config, the socket and the sizes of the server.
+	 * @throws hlop_err, if the socket cannot be created, or another server listens on it.
+	 * @note A stale socket file of a server that is gone is replaced.
+	 */
+	explicit hlopd_server(const hlop::hlopd_config_t &config);
+	hlopd_server(const hlopd_server_t &) = delete;
+	hlopd_server_t &operator=(const hlopd_server_t &) = delete;
+	~hlopd_server();
+
+public:
+	/**
+	 * @brief serve until stop is called.
+	 * @throws hlop_err, if epoll fails.
+	 */
+	void run();
+	/**
+	 * @brief make run return, the queries still on the workers are not answered.
+	 * @note It is thread-safe and async-signal-safe.
+	 */
+	void stop();
+	/**
+	 * @brief get the counters of the server.
+	 * @return hlopd_stats, the counters.
+	 */
+	const hlop::hlopd_stats_t get_stats() const;
+	/**
+	 * @brief get the counters of the prediction cache file.
+	 * @return optional<prediction_cache_stats>, the counters, empty without a cache file.
+	 */
+	const std::optional<hlop::prediction_cache_stats_t> get_cache_stats() const;
+
+private:
+	/// @brief a node list snapshot and the host lists it was requested by.
+	struct topology {
+		std::string norm_key;
+		hlop::disk_cache_key_t fp; // prediction_cache::fingerprint of the node list
+		hlop::const_node_list_ptr_t nl;
+		std::vector<std::string> raw_keys;
+	};
+	/// @brief a connection and its buffers.
+	struct connection {
+		std::uint64_t id;
+		std::string in;
+		std::string out;
+		bool want_out; // EPOLLOUT is watched, out did not fit in the socket
+	};
+	/// @brief a response of a worker to send by the event loop.
+	struct completion {
+		int fd;
+		std::uint64_t conn_id;
+		std::string bytes;
+	};
+	/// @brief the key of a cached prediction.
+	struct result_key {
+		hlop::disk_cache_key_t topology;
+		std::uint8_t op;
+		std::uint8_t algo;
+		int msg_size;
+		bool operator==(const result_key &other) const;
+	};
+	struct result_key_hash {
+		std::size_t operator()(const result_key &k) const;
+	};
+	using topology_iter = std::list<topology>::iterator;
+	using result_entry = std::pair<result_key, hlop::hlopd_result_t>;
+	using result_iter = std::list<result_entry>::iterator;
+	using clock = std::chrono::steady_clock;
+
+private:
+	/**
+	 * @brief handle the requests received by a connection, the complete ones are answered or queued.
+	 * @return bool, false if the connection sent a malformed request and has to be closed.
+	 */
+	bool handle_input(int fd, connection &c);
+	/**
+	 * @brief answer a query from the caches.
+	 * @return bool, true if the response is appended to out.
+	 */
+	bool answer_cached(const hlop::hlopd_request_t &req, std::string &out);
+	/**
+	 * @brief answer a query, parsing its node list and predicting the message sizes that are not cached.
+	 * @return hlopd_response, the response, an error if the query fails.
+	 */
+	const hlop::hlopd_response_t answer(const hlop::hlopd_request_t &req);
+	/**
+	 * @brief get the snapshot of the node list of a query, parsed on a miss.
+	 * @param req hlopd_request, the query.
+	 * @param fp disk_cache_key, output, the fingerprint of the node list, see prediction_cache::fingerprint.
+	 * @return const_node_list_ptr, the snapshot.
+	 */
+	hlop::const_node_list_ptr_t get_topology(const hlop::hlopd_request_t &req, hlop::disk_cache_key_t &fp);
+	/**
+	 * @brief look a cached topology up by the host list of a query.
+	 * @return bool, true if it is cached.
+	 */
+	bool find_topology(const std::string &raw_key, hlop::disk_cache_key_t &fp, hlop::const_node_list_ptr_t &nl);
+	/**
+	 * @brief send the buffered output of a connection as far as the socket takes it.
+	 * @return bool, false if the connection is broken.
+	 */
+	bool flush(int fd, connection &c);
+	void close_connection(int fd);
+	void record_latency(clock::time_point start);
+
+private:
+	hlop::hlopd_config_t config;
+	int listen_fd = -1;
+	int epoll_fd = -1;
+	int wake_fd = -1; // eventfd, a worker finished a response
+	int stop_fd = -1; // eventfd, stop was called
+	std::map<hlop::op_type_t, std::unique_ptr<hlop::collective>> predictors;
+	std::unique_ptr<hlop::prediction_cache_t> disk;
+	std::unordered_map<int, connection> connections;
+	std::uint64_t next_conn_id = 0;
+
+	std::mutex topology_mtx;
+	std::list<topology> topologies; // the most recently used first
+	std::unordered_map<std::string, topology_iter> by_raw;
+	std::unordered_map<std::string, topology_iter> by_norm;
+
+	std::mutex result_mtx;
+	std::list<result_entry> results; // the most recently used first
+	std::unordered_map<result_key, result_iter, result_key_hash> by_key;
+
+	std::mutex completion_mtx;
+	std::vector<completion> completions;
+
+	std::atomic<std::uint64_t> requests{0}, errors{0}, inline_responses{0}, topology_hits{0}, topology_misses{0},
+	    result_hits{0}, result_misses{0}, latency_sum_ns{0}, latency_max_ns{0};
+	std::array<std::atomic<std::uint64_t>, hlop::HLOPD_LATENCY_BUCKETS> latency_hist{};
+
+	std::unique_ptr<hlop::thread_pool_t> pool; // last, destroyed first, its workers use the members above
+};
+typedef hlopd_server::hlopd_server_t hlopd_server_t;
+} // namespace hlop
+
+#endif // __SERVER_H__
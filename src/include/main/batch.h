@@ -0,0 +1,72 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "collective.h"
+#include "main.h"
+#include "prediction_cache.h"
+#include "struct/type.h"
+#include "thread_pool.h"
+
+namespace hlop {
+/**
+ * @brief class batch.
+ * This class answers prediction queries given one per line, in json or csv,
+ * with the predictors, the parameters and the node lists kept across the queries.
+ * A json query is an object with the fields of the command line flags, msz is a string or an array of numbers:
+ * {"op": "BCAST", "algo": "BINOMIAL", "pf": "DF", "nl": "i10r4n[03-04]", "ppn": 16, "msz": [1, 1024]},
+ * prune is optional, ranking is optional and true by default, and a field id is echoed in the result.
+ * A csv query is op,algo,pf,nl,ppn,msz[,prune], a field with commas is double quoted:
+ * BCAST,AUTO,DF,"i10r4n[03-04]",16,"1,1024".
+ * Blank lines and lines starting with # are skipped, a csv header starting with op, is answered with the result header.
+ * @note A json query is answered with a json line, a csv query with a csv row of query,msz,algo,time,error
+ * for each message size, the algorithm of --algo=AUTO is the best one, a message size without any predicted algorithm
+ * fails the query and its row reports why. A query is numbered by its line.
+ * With a prediction cache, the predictions of an algorithm and the best algorithms are looked up
+ * before they are predicted. A json query of --algo=AUTO also reports the whole ranking unless ranking is false,
+ * the ranking is not cached and is ranked again for each query that reports it.
+ */
+class batch {
+public:
+	using batch_t = hlop::batch;
+
+public:
+	/**
+	 * @brief constructor of batch, the predictors of all supported operations are created here.
+	 * @param cache prediction_cache *, the cache of the predictions, not used if nullptr, it must outlive the batch.
+	 */
+	explicit batch(hlop::prediction_cache_t *cache = nullptr);
+
+public:
+	/**
+	 * @brief answer a line of a batch.
+	 * @param line string, the line.
+	 * @param id long, the number of the line, reported in the result.
+	 * @param res string, output, the result lines each ended by a newline, empty for a skipped line.
+	 * @return bool, false if the query failed, its result reports the error then.
+	 * @note It is thread-safe, the queries are predicted in the calling thread.
+	 */
+	bool answer(const std::string &line, long id, std::string &res) const;
+	/**
+	 * @brief answer every line of the input.
+	 * @param in istream, the queries.
+	 * @param os ostream, the results, in the order of the queries, flushed after each query.
+	 * @param pool thread_pool, the queries are answered on it concurrently.
+	 * @return long, the number of failed queries.
+	 * @note A bounded number of queries is in flight, the results are written as soon as their predecessors are.
+	 */
+	long run(std::istream &in, std::ostream &os, hlop::thread_pool_t &pool) const;
+
+private:
+	std::map<hlop::op_type_t, std::unique_ptr<hlop::collective>> predictors;
+	mutable hlop::node_list_cache_t lists;
+	hlop::prediction_cache_t *cache;
+};
+typedef batch::batch_t batch_t;
+} // namespace hlop
+
+#endif // __BATCH_H__
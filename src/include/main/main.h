@@ -1,8 +1,17 @@
 #ifndef __MAIN_H__
 #define __MAIN_H__
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
 #include <vector>
 
+#include "collective.h"
+#include "prediction_cache.h"
 #include "struct/node_list.h"
 #include "struct/type.h"
 
@@ -11,23 +20,88 @@ namespace hlop {
  * @brief struct exec_args.
  * This struct is used to hold the arguments for the execution of a specific operation.
  * It contains the operation type, algorithm type, node list, and message sizes.
+ * The algorithm type is empty if the best algorithm is selected (--algo=AUTO),
+ * prune tells whether only the best algorithm has to be predicted exactly then (--prune).
  */
 struct exec_args {
 	hlop::op_type_t op;
-	hlop::algo_type_t algo;
-	hlop::node_list_t nl;
+	std::optional<hlop::algo_type_t> algo;
+	hlop::const_node_list_ptr_t nl;
 	std::vector<int> msz;
+	bool prune;
 };
 typedef exec_args exec_args_t;
 
 /**
- * @brief parse command line arguments.
- * @param argc int *, pointer to the argument count.
- * @param argv char ***, pointer to the argument vector.
+ * @brief struct query.
+ * The text of a prediction, given by the command line flags or by a line of a batch,
+ * ppn is 0 and msz is empty if they are not given.
+ */
+struct query {
+	std::string op;
+	std::string algo;
+	std::string pf;
+	std::string nl;
+	int ppn;
+	std::string msz;
+	bool prune;
+};
+typedef query query_t;
+
+/**
+ * @brief class node list cache.
+ * The node lists of the recent queries by platform, node list and processes per node,
+ * so a node list is parsed once for the queries that share it.
+ * @note It is thread-safe, the first inserted node list is evicted first once it is full.
+ */
+class node_list_cache {
+public:
+	using node_list_cache_t = hlop::node_list_cache;
+
+public:
+	/**
+	 * @brief constructor of node_list_cache.
+	 * @param capacity size_t, the maximum number of node lists kept, 0 disables the cache.
+	 */
+	explicit node_list_cache(std::size_t capacity = 1024);
+
+public:
+	/**
+	 * @brief get a node list of the BLOCK arrangement, parsed on a miss.
+	 * @param pf platform, the platform type.
+	 * @param nl string, the node list.
+	 * @param ppn int, the number of processes per node.
+	 * @return const_node_list_ptr, the node list.
+	 * @throws hlop_err, if the node list is invalid.
+	 */
+	hlop::const_node_list_ptr_t get(hlop::platform_t pf, const std::string &nl, int ppn);
+
+private:
+	using key_t = std::tuple<hlop::platform_t, std::string, int>;
+
+	std::mutex mtx;
+	std::size_t capacity;
+	std::map<key_t, hlop::const_node_list_ptr_t> lists;
+	std::deque<key_t> order; // keys in insertion order
+};
+typedef node_list_cache::node_list_cache_t node_list_cache_t;
+
+/**
+ * @brief check a query and convert it to the arguments of an execution.
+ * @param q query, the query.
+ * @param cache node_list_cache *, the cache to get the node list from, parsed for this query if nullptr.
+ * @return exec_args, struct containing parsed arguments.
+ * @throws hlop_err, if the query is invalid.
+ */
+hlop::exec_args_t parse_query(const hlop::query_t &q, hlop::node_list_cache_t *cache = nullptr);
+
+/**
+ * @brief check the command line flags of a single query and convert them, see parse_query.
  * @return exec_args, struct containing parsed arguments.
  * @throws hlop_err, if the arguments are invalid.
+ * @note The flags are parsed by gflags::ParseCommandLineFlags before.
  */
-hlop::exec_args_t parse_argument(int *argc, char ***argv);
+hlop::exec_args_t parse_argument();
 
 /**
  * @brief execute the operation with the given arguments.
@@ -38,7 +112,7 @@ hlop::exec_args_t parse_argument(int *argc, char ***argv);
  * @return double, the result of the execution.
  * @throws hlop_err, if the operation type is not supported.
  */
-double execute_with_arg(hlop::op_type_t op, hlop::algo_type_t algo, hlop::node_list_t nl, int msg_size);
+double execute_with_arg(hlop::op_type_t op, hlop::algo_type_t algo, const hlop::node_list_t &nl, int msg_size);
 
 /**
  * @brief execute the operation with multiple message sizes.
@@ -46,10 +120,42 @@ double execute_with_arg(hlop::op_type_t op, hlop::algo_type_t algo, hlop::node_l
  * @param algo algo_type, the algorithm type.
  * @param nl node_list, the node list.
  * @param msg_sizes vector<int>, the message sizes.
+ * @param cache prediction_cache *, the cache the message sizes are looked up in first, not used if nullptr.
  * @return vector<double>, the results of the execution for each message size.
+ * @throws hlop_err, if the operation type is not supported.
+ * @note One predictor evaluates all message sizes, the schedule is simulated once if the algorithm has a planner.
+ */
+std::vector<double> execute_with_args(hlop::op_type_t op, hlop::algo_type_t algo, const hlop::node_list_t &nl,
+                                      const std::vector<int> &msg_sizes, hlop::prediction_cache_t *cache = nullptr);
+
+/**
+ * @brief rank all algorithms of the operation with multiple message sizes.
+ * @param op op_type, the operation type.
+ * @param nl node_list, the node list.
+ * @param msg_sizes vector<int>, the message sizes.
+ * @param prune bool, whether the algorithms slower than the best one may be pruned.
+ * @return vector<vector<algo_rank>>, the ranking of each message size, the best algorithm first.
+ * @throws hlop_err, if the operation type is not supported.
  */
-std::vector<double> execute_with_args(hlop::op_type_t op, hlop::algo_type_t algo, hlop::node_list_t nl,
-                                      std::vector<int> msg_sizes);
+std::vector<std::vector<hlop::algo_rank_t>> select_with_args(hlop::op_type_t op, const hlop::node_list_t &nl,
+                                                             const std::vector<int> &msg_sizes, bool prune);
+
+/// @brief maximum number of sizes of a list parsed by parse_sizes.
+constexpr std::size_t MAX_SIZES = 1 << 20;
+
+/**
+ * @brief parse a list of sizes, e.g., message sizes or processes per node.
+ * An item is a size or a range, a size may end with K, M or G for 2^10, 2^20 or 2^30,
+ * a range start:end:xF multiplies start by F while it is not above end, start:end:+S adds S,
+ * start:end is start:end:x2, e.g., "1:4M:x2" or "1024:65536:+1024,100000".
+ * @param s string, the list.
+ * @param what string, the name of the sizes in the errors.
+ * @return vector<int>, the sizes in the order of the list.
+ * @throws hlop_err, if an item is invalid, a size is not positive or does not fit in an int,
+ * or the list has more than MAX_SIZES sizes.
+ */
+std::vector<int> parse_sizes(const std::string &s, const std::string &what);
+
 } // namespace hlop
 
 #endif // __MAIN_H__
\ No newline at end of file
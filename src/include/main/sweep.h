@@ -0,0 +1,94 @@
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "collective.h"
+#include "main.h"
+#include "platform.h"
+#include "prediction_cache.h"
+#include "struct/type.h"
+#include "thread_pool.h"
+
+namespace hlop {
+/**
+ * @brief enum class output format.
+ * The formats of the results of a sweep:
+ * - TEXT: a line of each result.
+ * - CSV: a header and a row of each result, nodes,ppn,msz,algo,time,error.
+ * - JSON: a json object of each result on its own line.
+ */
+enum class output_format {
+	TEXT,
+	CSV,
+	JSON
+};
+typedef output_format output_format_t;
+
+/**
+ * @brief class sweep.
+ * This class predicts an operation over the prefixes of a host list, processes per node and message sizes,
+ * e.g., --nodes=2:64:x2 --ppn=8,16 --msz=1:4M:x2, the sizes are lists of parse_sizes.
+ * Each node count and processes per node is a topology, its node list is parsed once on the pool,
+ * and its message sizes are split into parts predicted on the pool, so the pool is busy with one topology.
+ * One predictor serves the whole sweep. The results are written in the order of the sweep,
+ * the node counts first, then the processes per node, then the message sizes, as soon as their predecessors are.
+ * The algorithm of --algo=AUTO is the best one.
+ */
+class sweep {
+public:
+	using sweep_t = hlop::sweep;
+
+public:
+	sweep() = delete;
+	/**
+	 * @brief constructor of sweep, check the query.
+	 * @param q query, the query, its ppn is not used.
+	 * @param nodes string, the node counts, the first hosts of the node list, all of them if empty.
+	 * @param ppn string, the processes per node.
+	 * @param format output_format, the format of the results.
+	 * @param cache prediction_cache *, the cache of the predictions, not used if nullptr, it must outlive the sweep.
+	 * @throws hlop_err, if the query is invalid, or a node count is above the number of hosts.
+	 */
+	sweep(const hlop::query_t &q, const std::string &nodes, const std::string &ppn, hlop::output_format_t format,
+	      hlop::prediction_cache_t *cache = nullptr);
+
+public:
+	/**
+	 * @brief predict the sweep.
+	 * @param os ostream, the results.
+	 * @param pool thread_pool, the topologies and the parts of their message sizes are predicted on it.
+	 * @return long, the number of failed predictions, their results report the errors.
+	 * @note A bounded number of parts is in flight.
+	 */
+	long run(std::ostream &os, hlop::thread_pool_t &pool) const;
+
+private:
+	/**
+	 * @brief predict message sizes of a topology, a prediction that throws fails with its error.
+	 * @param nl node_list *, the node list, nullptr if it failed to parse with error.
+	 */
+	std::vector<hlop::algo_rank_t> predict_part(const hlop::node_list_t *nl, const std::vector<int> &sizes,
+	                                            const std::string &error) const;
+
+private:
+	hlop::op_type_t op;
+	std::optional<hlop::algo_type_t> algo;
+	hlop::platform_t pf;
+	std::vector<std::string> hosts;
+	std::vector<int> nodes;
+	std::vector<int> ppn;
+	std::vector<int> msz;
+	bool prune;
+	hlop::output_format_t format;
+	std::unique_ptr<hlop::collective> predictor;
+	hlop::prediction_cache_t *cache;
+};
+typedef sweep::sweep_t sweep_t;
+} // namespace hlop
+
+#endif // __SWEEP_H__
@@ -28,6 +28,7 @@ public:
 	static constexpr int TOP_LEVEL_IDX{3};
 	static constexpr int MID_LEVEL_IDX{5};
 	static constexpr int BOTTOM_LEVEL_IDX{8};
+	static constexpr int NAME_GROUP_NUM{3};
 	static const std::regex NODE_REGEX;
 	static const std::regex NODE_LIST_REGEX;
 
@@ -40,15 +41,6 @@ public:
 	 */
 	static const std::vector<hlop::const_node_ptr> parse_node_list(const std::string &node_list_str);
 
-private:
-	/**
-	 * @brief parse a node list string.
-	 * @param node_list_str string, e.g., "node1,node2,node3" or "node[1-5],node6,node7".
-	 * @return vector<string>, vector of node names.
-	 * @throws hlop_err, if node format is invalid.
-	 */
-	static const std::vector<std::string> parse_node_list_aux(const std::string &node_list_str);
-
 public:
 	/**
 	 * @brief default constructor of df_node.
@@ -87,6 +79,7 @@ public:
 	const int get_ncore_per_numa() const override;
 	const int get_ncore_per_unit() const override;
 	const std::regex &get_node_regex() const override;
+	const std::string_view get_level_name(int level) const override;
 
 private:
 	const std::array<std::string_view, hlop::df_node::MAX_NODE_LEVEL> node_levels;
@@ -0,0 +1,37 @@
+#ifndef __HOSTLIST_H__
+#define __HOSTLIST_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hlop {
+/**
+ * @brief expand a compressed host list.
+ * @param host_list string_view, e.g., "node1,node2,node3" or "node[1-5,07],node6,node7".
+ * @return vector<string>, the host names in the order of the list.
+ * @throws hlop_err, if a bracket is not closed or a range is not a pair of ascending decimal numbers.
+ * @note The list is expanded in one pass without regex. A range is padded with zeros to the width of its start,
+ * e.g., "n[08-10]" is "n08,n09,n10", a single number is kept as it is.
+ */
+std::vector<std::string> expand_hostlist(std::string_view host_list);
+
+/**
+ * @brief expand a compressed host list and check that no host appears twice.
+ * @param host_list string_view, a compressed host list, see expand_hostlist.
+ * @return vector<string>, the host names in the order of the list.
+ * @throws hlop_err, if the list is malformed or a host name is duplicated.
+ */
+std::vector<std::string> parse_hostlist(std::string_view host_list);
+
+/**
+ * @brief check a host name made of groups, each a letter followed by decimal digits, e.g., "i10r4n03".
+ * @param name string_view, the host name.
+ * @param ngroup int, the number of groups.
+ * @return bool, true if the name is exactly ngroup groups.
+ * @note This is the same as matching ([a-zA-Z]\d+){ngroup} without regex.
+ */
+bool match_grouped_name(std::string_view name, int ngroup);
+} // namespace hlop
+
+#endif // __HOSTLIST_H__
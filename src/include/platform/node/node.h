@@ -5,6 +5,7 @@
 #include <memory>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace hlop {
@@ -16,6 +17,8 @@ namespace hlop {
  * It also allows for binding cores to process ranks and retrieving core levels.
  * @throws hlop_err, if the core level is not valid or if the rank is not in the range of the node's cores.
  * @note This class is intended to be used as a base class for specific node implementations.
+ * Cores are only bound through a non-const node, a node shared as const_node_ptr is immutable
+ * and may be read by many threads.
  */
 class node {
 public:
@@ -75,6 +78,13 @@ public:
 	 * @return regex, the regex for matching node names.
 	 */
 	virtual const std::regex &get_node_regex() const = 0;
+	/**
+	 * @brief get the name of the network group the node belongs to at a level.
+	 * @param level int, the level index in range [0, max_node_level), 0 is the top level.
+	 * @return string_view, the group name, nodes of the same group have the same name.
+	 * @throws hlop_err, if the level is out of range.
+	 */
+	virtual const std::string_view get_level_name(int level) const = 0;
 
 public:
 	/**
@@ -87,8 +97,9 @@ public:
 	 * @param rank int, the process rank to bind.
 	 * @param core int, the core to bind the rank to.
 	 * @throws hlop_err, if the core is not in the range of [0, node_cores - 1] or the rank is already bound to a core.
+	 * @note This is not thread-safe, bind the cores before the node is shared.
 	 */
-	void bind_core(int rank, int core) const;
+	void bind_core(int rank, int core);
 	/**
 	 * @brief get the core of a process rank.
 	 * @param rank int, the process rank.
@@ -111,10 +122,18 @@ public:
 	 * @throws hlop_err, if rank1 or rank2 is not in the range of [0, node_cores - 1].
 	 */
 	const int get_core_level(int rank1, int rank2) const;
+	/**
+	 * @brief get the core level between two core units.
+	 * @param unit1 int, the first unit id.
+	 * @param unit2 int, the second unit id.
+	 * @return int, the core level between the two units.
+	 * @throws hlop_err, if the units are not in the same node.
+	 */
+	const int get_unit_level(int unit1, int unit2) const;
 
 protected:
 	const std::string node_name;
-	mutable std::unordered_map<int, int> rank_core_map;
+	std::unordered_map<int, int> rank_core_map;
 };
 typedef node::node_t node_t;
 typedef node::node_ptr node_ptr;
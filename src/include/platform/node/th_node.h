@@ -28,6 +28,7 @@ public:
 	static constexpr int TOP_LEVEL_IDX{0};
 	static constexpr int MID_LEVEL_IDX{0};
 	static constexpr int BOTTOM_LEVEL_IDX{0};
+	static constexpr int NAME_GROUP_NUM{3};
 	static const std::regex NODE_REGEX;
 	static const std::regex NODE_LIST_REGEX;
 
@@ -36,11 +37,6 @@ public:
 	 */
 	static const std::vector<hlop::const_node_ptr> parse_node_list(const std::string &node_list_str);
 
-private:
-	/**
-	 */
-	static const std::vector<std::string> parse_node_list_aux(const std::string &node_list_str);
-
 public:
 	th_node() = delete;
 	th_node(const std::string &node_str);
@@ -64,6 +60,7 @@ public:
 	const int get_ncore_per_numa() const override;
 	const int get_ncore_per_unit() const override;
 	const std::regex &get_node_regex() const override;
+	const std::string_view get_level_name(int level) const override;
 
 private:
 	const std::array<std::string_view, hlop::th_node::MAX_NODE_LEVEL> node_levels;
@@ -1,7 +1,11 @@
 #ifndef __PARAM_H__
 #define __PARAM_H__
 
+#include <cstdint>
 #include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -9,26 +13,69 @@
 #include <vector>
 
 #include "fit.h"
+#include "interp.h"
+#include "param/param_format.h"
 
 namespace hlop {
 /// @brief predefined exponential function 1.
 extern const std::function<double(double, hlop::exponential_params_t)> exp_fit_func_2;
 
+/**
+ * @brief enum class link class.
+ * The link classes are:
+ * - L0, intra-node link
+ * - L1, inter-node link
+ */
+enum class link_class {
+	L0,
+	L1
+};
+typedef link_class link_class_t;
+
+std::ostream &operator<<(std::ostream &os, const hlop::link_class_t &lc);
+
+/**
+ * @brief struct parameter key.
+ * Typed form of a parameter category such as "L1_2_17",
+ * which is (link class, level, contention).
+ */
+struct param_key {
+	hlop::link_class_t cls;
+	int level;
+	int contention;
+};
+typedef param_key param_key_t;
+
+std::ostream &operator<<(std::ostream &os, const hlop::param_key_t &key);
+
 /**
  * @brief class param.
  * This class loads parameters from a resources file and provides methods to access
  * parameters based on message size and category labels.
  * It supports checking for the existence of categories and retrieving parameters
  * based on message size and labels.
- * It also provides a fitting function for parameters that are not present in the parameter file.
+ * Parameters of message sizes that are not present in the parameter file are interpolated with an interp_mode:
+ * - EXPONENTIAL, the fitted curve of each category is computed once on its first off-grid lookup and cached
+ * - LOG_LINEAR / MONOTONE_CUBIC, piecewise over the measured grid in log-log space, the per-slot curves
+ *   and tangents are precomputed when loading, so that a lookup never allocates nor fits
  * The parameters are expected to be in the form of a vector where the index corresponds to the
  * logarithm base 2 of the message size.
+ * Categories named "L<class>_<level>_<contention>" are stored in one contiguous table indexed as
+ * [class][level][contention][msg-size bucket] and are looked up by param_key without any allocation,
+ * other category names are kept after the table and are only reachable through the string API.
+ * The resources file is either a csv table or a binary parameter file (see param_format.h) produced by save(),
+ * a binary file is mapped read-only, so processes on one node share its pages.
+ * The fitted curves of a csv are loaded from its sidecar fit file (see fit_file()) if it exists,
+ * which is written by hlop_param_fit, and only if it was fitted from the csv as it is now.
  * @throws hlop_err if the resources file cannot be opened, is empty, or has invalid format.
  */
 class param {
 public:
 	using param_t = hlop::param;
 
+	/// @brief prefix of the source line of a fit file, see fit_source_line.
+	static constexpr const char *FIT_SOURCE_TAG = "#source,";
+
 public:
 	/**
 	 * @brief default constructor.
@@ -42,6 +89,14 @@ public:
 	 * @throws hlop_err, if the resources file cannot be opened, is empty, or has invalid format.
 	 */
 	param(const std::string &resources_file);
+	/**
+	 * @brief constructor.
+	 * @param resources_file string, path to the resources file.
+	 * @param mode interp_mode, the interpolation mode of off-grid message sizes.
+	 * @throws hlop_err, if the resources file cannot be opened, is empty, or has invalid format.
+	 * @note The other constructor uses the mode saved in a binary file, EXPONENTIAL for csv.
+	 */
+	param(const std::string &resources_file, hlop::interp_mode_t mode);
 	~param() = default;
 
 private:
@@ -51,6 +106,89 @@ private:
 	 * @throws hlop_err, if the resources file cannot be opened or is empty or has invalid format.
 	 */
 	void load_params(const std::string &resources_file);
+	/**
+	 * @brief map parameters from a binary parameter file, auxiliary function.
+	 * @param resources_file string, path to the binary parameter file.
+	 * @throws hlop_err, if the file cannot be mapped or has invalid format or version.
+	 */
+	void load_binary(const std::string &resources_file);
+	/**
+	 * @brief load pre-fitted curves from a sidecar fit file, auxiliary function.
+	 * @param fit_file string, path to the fit file.
+	 * @param csv_hash uint64_t, hash_file of the csv the parameters are loaded from.
+	 * @throws hlop_err, if the fit file has invalid format.
+	 * @note Categories that are not in the table are ignored. A fit file whose source line is not the one of
+	 * csv_hash, see fit_source_line, is ignored with a warning on stderr, the curves are fitted when used.
+	 */
+	void load_fit(const std::string &fit_file, std::uint64_t csv_hash);
+	/**
+	 * @brief precompute the interpolation curves and tangents of every slot, auxiliary function.
+	 * @note Called after loading a csv, a binary file carries them.
+	 */
+	void build_interp_tables();
+	/**
+	 * @brief compute the spacing of the message size grid, auxiliary function.
+	 * @return double, the spacing of a uniform grid, 0 for a non-uniform grid.
+	 */
+	double calc_grid_step() const;
+
+public:
+	/**
+	 * @brief check whether a file is a binary parameter file.
+	 * @param resources_file string, path to the file.
+	 * @return bool, true if the file starts with the binary parameter magic, false otherwise.
+	 */
+	static bool is_binary(const std::string &resources_file);
+	/**
+	 * @brief check whether a binary parameter file is compiled from a csv as it is now.
+	 * @param bin_file string, path to the binary parameter file.
+	 * @param csv_file string, path to the csv resources file.
+	 * @return bool, true if bin_file is a binary parameter file of this version whose source hash is the one of
+	 * csv_file and its fit file, or if csv_file cannot be read, false otherwise.
+	 */
+	static bool is_compiled_from(const std::string &bin_file, const std::string &csv_file);
+	/**
+	 * @brief choose the parameter file to load.
+	 * @param bin_file string, path to the precompiled binary parameter file.
+	 * @param csv_file string, path to the csv resources file.
+	 * @return string, bin_file if it is a binary parameter file compiled from csv_file as it is now,
+	 * csv_file otherwise.
+	 * @note A stale binary file is reported on stderr, the param_bin target compiles it again.
+	 */
+	static const std::string choose_file(const std::string &bin_file, const std::string &csv_file);
+	/**
+	 * @brief hash the contents of a file.
+	 * @param path string, path to the file.
+	 * @return uint64_t, FNV-1a hash of the contents, 0 if the file cannot be read.
+	 */
+	static std::uint64_t hash_file(const std::string &path);
+	/**
+	 * @brief hash the sources of the parameters of a csv resources file.
+	 * @param resources_file string, path to the csv resources file.
+	 * @return uint64_t, a hash of the contents of the csv and of its fit file, which may be absent.
+	 * @note The source hash is saved in a binary parameter file, see is_compiled_from.
+	 */
+	static std::uint64_t source_hash(const std::string &resources_file);
+	/**
+	 * @brief save parameters as a binary parameter file.
+	 * @param bin_file string, path to the output file.
+	 * @return int, the number of categories whose curve can not be fitted, they are fitted again when used.
+	 * @throws hlop_err, if the file cannot be written.
+	 * @note The fitted curves of all categories are computed and saved as well.
+	 */
+	int save(const std::string &bin_file) const;
+	/**
+	 * @brief get the path of the sidecar fit file of a csv resources file.
+	 * @param resources_file string, path to the csv resources file.
+	 * @return string, path to the fit file, "<resources_file>.fit".
+	 */
+	static const std::string fit_file(const std::string &resources_file);
+	/**
+	 * @brief get the first line of the fit file of a csv resources file.
+	 * @param resources_file string, path to the csv resources file.
+	 * @return string, "#source,<hash_file of the csv>", a fit file is only loaded with the csv it names.
+	 */
+	static const std::string fit_source_line(const std::string &resources_file);
 
 public:
 	/**
@@ -63,35 +201,124 @@ public:
 	 * @return vector<double>, containing the message size range in powers of 2.
 	 */
 	const std::vector<double> &get_msg_size_range() const;
+	/**
+	 * @brief get the interpolation mode.
+	 * @return interp_mode, the interpolation mode of off-grid message sizes.
+	 */
+	hlop::interp_mode_t get_interp_mode() const;
+	/**
+	 * @brief get the measured parameters of a category.
+	 * @param param_category string, the category to get parameters for.
+	 * @return vector<double>, one value per message size bucket.
+	 * @throws hlop_err, if the category does not exist.
+	 */
+	const std::vector<double> get_category_params(const std::string &param_category) const;
 	/**
 	 * @brief check if a category exists, auxiliary function.
 	 * @param param_category string, the category to check.
 	 * @return bool, true if the category exists, false otherwise.
 	 */
 	bool has_category(const std::string &param_category) const;
+	/**
+	 * @brief check if a category exists.
+	 * @param key param_key, the typed category to check.
+	 * @return bool, true if the category exists, false otherwise.
+	 */
+	bool has_category(const hlop::param_key_t &key) const;
 	/**
 	 * @brief get parameter based on message size and category.
 	 * @param msg_size int, message size.
 	 * @param param_category string, the category to get parameters for.
 	 * @return double, the parameter value for the given message size and category.
-	 * @throws hlop_err, if the category does not exist or if the message size is not a power of 2.
+	 * @throws hlop_err, if the category does not exist or if the message size is not positive.
+	 * @note This is a compatibility wrapper, prefer the param_key overload.
 	 */
 	const double get_param(int msg_size, const std::string &param_category) const;
+	/**
+	 * @brief get parameter based on message size and typed category.
+	 * @param msg_size int, message size.
+	 * @param key param_key, the typed category to get parameters for.
+	 * @return double, the parameter value for the given message size and category.
+	 * @throws hlop_err, if the category does not exist or if the message size is not positive.
+	 */
+	const double get_param(int msg_size, const hlop::param_key_t &key) const;
+	/**
+	 * @brief get parameters of many message sizes of one category.
+	 * @param msg_sizes const int *, message sizes, all positive.
+	 * @param n size_t, number of message sizes.
+	 * @param param_category string, the category to get parameters for.
+	 * @param out double *, output, n parameter values, one for each message size.
+	 * @throws hlop_err, if the category does not exist or if a message size is not positive.
+	 * @note The values are identical to get_param of each message size.
+	 */
+	void get_param_batch(const int *msg_sizes, std::size_t n, const std::string &param_category, double *out) const;
+	/**
+	 * @brief get parameters of many message sizes of one typed category.
+	 * @param msg_sizes const int *, message sizes, all positive.
+	 * @param n size_t, number of message sizes.
+	 * @param key param_key, the typed category to get parameters for.
+	 * @param out double *, output, n parameter values, one for each message size.
+	 * @throws hlop_err, if the category does not exist or if a message size is not positive.
+	 * @note The values are identical to get_param of each message size.
+	 */
+	void get_param_batch(const int *msg_sizes, std::size_t n, const hlop::param_key_t &key, double *out) const;
 
 private:
 	/**
-	 * @brief get parameters for a specific category, auxiliary function.
-	 * @param param_category string, the category to get parameters for.
-	 * @return vector<double>, the parameters for the given category.
-	 * @throws hlop_err, if the category does not exist.
+	 * @brief get the table slot of a typed category, auxiliary function.
+	 * @param key param_key, the typed category.
+	 * @return int, the slot of the category, -1 if it is not in the table.
+	 */
+	int get_slot(const hlop::param_key_t &key) const;
+	/**
+	 * @brief get the table slot of a category name, auxiliary function.
+	 * @param param_category string, the category name.
+	 * @return int, the slot of the category, -1 if it does not exist.
+	 */
+	int get_slot(const std::string &param_category) const;
+	/**
+	 * @brief get parameter based on message size and slot, auxiliary function.
+	 * @param msg_size int, message size.
+	 * @param slot int, a valid slot of the table.
+	 * @return double, the parameter value for the given message size and slot.
+	 */
+	const double get_param_by_slot(int msg_size, int slot) const;
+	/**
+	 * @brief get parameters of many message sizes of a slot, auxiliary function.
+	 * @param msg_sizes const int *, message sizes.
+	 * @param n size_t, number of message sizes.
+	 * @param slot int, a valid slot of the table.
+	 * @param out double *, output, n parameter values.
+	 * @throws hlop_err, if a message size is not positive.
 	 */
-	const std::vector<double> &get_params(const std::string &param_category) const;
+	void get_param_batch_by_slot(const int *msg_sizes, std::size_t n, int slot, double *out) const;
+	/**
+	 * @brief get parameters for a specific slot, auxiliary function.
+	 * @param slot int, a valid slot of the table.
+	 * @return const double *, the row of parameters of the slot, one value per message size bucket.
+	 */
+	const double *get_params(int slot) const;
+	/**
+	 * @brief get the cached fitted curve for a specific slot, auxiliary function.
+	 * @param slot int, a valid slot of the table.
+	 * @return exponential_params_t, the fitted curve parameters of the slot.
+	 * @throws hlop_err, if the fitting fails.
+	 * @note The curve is fitted once on the first call for a slot, this method is thread-safe.
+	 */
+	const hlop::exponential_params_t &get_fitted(int slot) const;
+	/**
+	 * @brief interpolate a slot in the measured grid, auxiliary function.
+	 * @param e double, log2 of the message size.
+	 * @param slot int, a valid slot of the table.
+	 * @return double, the interpolated parameter value.
+	 */
+	const double interpolate(double e, int slot) const;
 	/**
 	 * @brief fit function for parameters that are not present in the parameter file, auxiliary function.
 	 * @param y vector<double>, the parameters to fit.
-	 * @return function<double(double)>, a function that fits the parameters.
+	 * @return exponential_params_t, the fitted curve parameters.
 	 */
-	std::function<double(double)> fit(const std::vector<double> &y) const;
+	hlop::exponential_params_t fit(const std::vector<double> &y) const;
 
 public:
 	/**
@@ -121,10 +348,42 @@ public:
 	 */
 	template <typename... Labels>
 	static const std::string get_category_with_labels(const Labels &...labels);
+	/**
+	 * @brief parse a category name to a typed category, auxiliary function.
+	 * @param param_category string, the category name like "L1_2_17".
+	 * @param key param_key, output, the typed category.
+	 * @return bool, true if the name is a "L<class>_<level>_<contention>" category, false otherwise.
+	 */
+	static bool parse_category(const std::string &param_category, hlop::param_key_t &key);
+
+private:
+	/// @brief fitted curve of a category, filled once by the first off-grid lookup.
+	struct fitted_curve {
+		mutable std::once_flag once;
+		mutable hlop::exponential_params_t coef;
+	};
 
 private:
 	std::vector<double> msg_size_pow; // length of param vector, 2 << i is the message size of this coloum
-	std::unordered_map<std::string, const std::vector<double>> params;
+	int nlevel;                       // number of levels of the table
+	int ncontention;                  // number of contentions of the table, contention starts from 1
+	int nslot;                        // number of slots, table slots followed by the other categories
+	hlop::interp_mode_t mode;         // interpolation mode of off-grid message sizes
+	double grid_step;                 // spacing of msg_size_pow, 0 if it is not uniform
+	std::uint64_t source;             // source_hash of the csv the parameters are loaded from
+	const double *values;             // [class][level][contention][msg-size bucket], then other categories
+	const double *curves;             // values in log space for SLOT_LOG slots, same layout as values
+	const double *tangents;           // monotone cubic tangents of curves, same layout as values
+	const char *present;              // SLOT_* flags of each slot
+	const hlop::param_bin_coef_t *coefs;        // pre-fitted curves, nullptr for csv without fit file
+	std::unordered_map<std::string, int> slots; // category name -> slot
+	std::unique_ptr<fitted_curve[]> fitted;     // one per slot
+	std::vector<double> owned_values;           // storage of values for csv
+	std::vector<double> owned_curves;           // storage of curves for csv
+	std::vector<double> owned_tangents;         // storage of tangents for csv
+	std::vector<char> owned_present;            // storage of present for csv
+	std::vector<hlop::param_bin_coef_t> owned_coefs; // storage of coefs for csv
+	std::shared_ptr<const void> mapping;        // storage of a binary file
 };
 typedef param::param_t param_t;
 
@@ -152,4 +411,4 @@ inline const std::string param::get_category_with_labels(const Labels &...labels
 }
 } // namespace hlop
 
-#endif // __PARAM_H__
\ No newline at end of file
+#endif // __PARAM_H__
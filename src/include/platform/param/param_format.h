@@ -0,0 +1,66 @@
+#ifndef __PARAM_FORMAT_H__
+#define __PARAM_FORMAT_H__
+
+#include <cstdint>
+
+#include "fit.h"
+
+namespace hlop {
+/**
+ * @brief binary parameter file layout.
+ * A binary parameter file is a read-only image of hlop::param that is mapped into memory as is:
+ * - header, param_bin_header
+ * - axes, double[nbucket], log2 of the message size of each bucket
+ * - present, uint8_t[nslot], SLOT_* flags of each slot, padded to 8 bytes
+ * - values, double[nslot][nbucket], the dense table followed by the other categories
+ * - curves, double[nslot][nbucket], log of values for SLOT_LOG slots, values otherwise
+ * - tangents, double[nslot][nbucket], monotone cubic tangents of curves
+ * - coefs, param_bin_coef[nslot], pre-fitted curve of each slot
+ * - names, for each present slot: int32_t slot, uint32_t length, char[length], padded to 8 bytes
+ * All offsets are in bytes from the beginning of the file, all values are in host byte order.
+ */
+namespace param_format {
+/// @brief magic of the binary parameter file.
+constexpr char MAGIC[8] = {'H', 'L', 'O', 'P', 'P', 'A', 'R', 'M'};
+/// @brief version of the binary parameter file, bump on any layout change.
+constexpr std::uint32_t VERSION{3};
+/// @brief endian mark, a file written on a host with another byte order is rejected.
+constexpr std::uint32_t ENDIAN_MARK{0x01020304};
+/// @brief the slot is loaded from the resources file.
+constexpr std::uint8_t SLOT_PRESENT{0x1};
+/// @brief all values of the slot are positive, the slot is interpolated in log space.
+constexpr std::uint8_t SLOT_LOG{0x2};
+} // namespace param_format
+
+/// @brief header of the binary parameter file.
+struct param_bin_header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t endian_mark;
+	std::int32_t nbucket;
+	std::int32_t nlevel;
+	std::int32_t ncontention;
+	std::int32_t nslot;
+	std::int32_t interp;
+	std::int32_t reserved;
+	std::uint64_t axes_offset;
+	std::uint64_t present_offset;
+	std::uint64_t values_offset;
+	std::uint64_t curves_offset;
+	std::uint64_t tangents_offset;
+	std::uint64_t coefs_offset;
+	std::uint64_t names_offset;
+	std::uint64_t file_size;
+	std::uint64_t source_hash; // param::source_hash of the csv compiled into the file, 0 if unknown
+};
+typedef param_bin_header param_bin_header_t;
+
+/// @brief pre-fitted curve of a slot, valid is 0 if the slot is absent or the fitting failed.
+struct param_bin_coef {
+	hlop::exponential_params_t coef;
+	std::uint64_t valid;
+};
+typedef param_bin_coef param_bin_coef_t;
+} // namespace hlop
+
+#endif // __PARAM_FORMAT_H__
@@ -37,6 +37,27 @@ int pof2_ceil(int x);
  */
 int pof2_floor(int x);
 
+/**
+ * @brief quote a string for json.
+ * @param s string, the string.
+ * @return string, the json string.
+ */
+std::string quote_json(const std::string &s);
+
+/**
+ * @brief quote a csv field if it holds a comma, a quote or a newline.
+ * @param s string, the field.
+ * @return string, the csv field.
+ */
+std::string quote_csv(const std::string &s);
+
+/**
+ * @brief write a time as a json number.
+ * @param t double, the time.
+ * @return string, the number, null if it is not finite.
+ */
+std::string json_number(double t);
+
 /**
  * @brief string to vector conversion.
  * @tparam T type of the vector item.
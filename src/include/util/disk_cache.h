@@ -0,0 +1,99 @@
+#ifndef __DISK_CACHE_H__
+#define __DISK_CACHE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hlop {
+/**
+ * @brief struct disk cache key.
+ * A 128-bit content hash, the all zero key is not used.
+ */
+struct disk_cache_key {
+	std::uint64_t hi;
+	std::uint64_t lo;
+};
+typedef disk_cache_key disk_cache_key_t;
+
+/**
+ * @brief struct disk cache value.
+ * The two words kept for a key.
+ */
+struct disk_cache_value {
+	std::uint64_t first;
+	std::uint64_t second;
+};
+typedef disk_cache_value disk_cache_value_t;
+
+/**
+ * @brief class disk cache.
+ * This class is a fixed-size hash table in a memory-mapped file shared by processes.
+ * A key lives in one of PROBE consecutive slots from its hash, a full window evicts its least recently used slot,
+ * so the file never grows beyond the capacity it is created with.
+ * Each slot is a seqlock, a writer claims it by a compare-and-swap of its sequence from even to odd
+ * and releases it even again, a reader retries a slot whose sequence changed while it read,
+ * so readers and writers of any number of threads and processes need no other lock.
+ * @throws hlop_err, if the file cannot be created or mapped, or it is not a cache of this version.
+ * @note A writer killed in a slot leaves the slot odd, it is skipped from then on.
+ * The slots are read and written with the __atomic builtins, the file is only locked while it is created.
+ */
+class disk_cache {
+public:
+	using disk_cache_t = hlop::disk_cache;
+
+	/// @brief number of slots a key may live in.
+	static constexpr std::size_t PROBE = 8;
+
+public:
+	disk_cache() = delete;
+	/**
+	 * @brief constructor of disk_cache, open a cache file, it is created if it does not exist.
+	 * @param path string, the cache file.
+	 * @param capacity size_t, the number of slots of a new file, an existing file keeps its own.
+	 * @throws hlop_err, if the file cannot be opened, or it is not a cache file of this version.
+	 */
+	disk_cache(const std::string &path, std::size_t capacity);
+	disk_cache(const disk_cache_t &) = delete;
+	disk_cache_t &operator=(const disk_cache_t &) = delete;
+	~disk_cache();
+
+public:
+	/**
+	 * @brief look up a key, its slot becomes the most recently used one of its window.
+	 * @param key disk_cache_key, the key.
+	 * @param value disk_cache_value, output, the value if found.
+	 * @return bool, true on a hit.
+	 */
+	bool find(const hlop::disk_cache_key_t &key, hlop::disk_cache_value_t &value) const;
+	/**
+	 * @brief insert or overwrite a key.
+	 * @param key disk_cache_key, the key.
+	 * @param value disk_cache_value, the value.
+	 * @return bool, false if every slot of the window is being written and the value is dropped.
+	 */
+	bool insert(const hlop::disk_cache_key_t &key, const hlop::disk_cache_value_t &value);
+	/**
+	 * @brief get the number of slots of the file.
+	 * @return size_t, the capacity.
+	 */
+	std::size_t capacity() const;
+
+private:
+	struct header;
+	struct slot;
+
+	slot *window(const hlop::disk_cache_key_t &key, std::size_t i) const;
+
+private:
+	std::string path;
+	void *map = nullptr;
+	std::size_t map_size = 0;
+	header *head = nullptr;
+	slot *slots = nullptr;
+	std::size_t nslot = 0;
+};
+typedef disk_cache::disk_cache_t disk_cache_t;
+} // namespace hlop
+
+#endif // __DISK_CACHE_H__
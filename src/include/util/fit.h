@@ -2,6 +2,7 @@
 #define __FIT_H__
 
 #include <functional>
+#include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
 #include <vector>
 
@@ -14,6 +15,14 @@ struct exponential_params {
 };
 typedef exponential_params exponential_params_t;
 
+/// @brief quality of a fitted curve.
+struct fit_report {
+	double rmse;        // root mean square of the residuals
+	double max_rel_err; // max |residual / y| over the data points with y != 0
+	int iterations;     // solver iterations
+};
+typedef fit_report fit_report_t;
+
 /// @brief predefined exponential function 1.
 extern const std::function<double(double, double, double, double)> exp_fit_func_1;
 /// @brief predefined exponential function 2.
@@ -28,6 +37,15 @@ extern const std::function<double(double, hlop::exponential_params_t)> exp_fit_f
  */
 int exponential_residual(const gsl_vector *params, void *data, gsl_vector *residuals);
 
+/**
+ * @brief analytic jacobian of the exponential residual function for GSL.
+ * @param params gsl_vector *, parameters of the exponential function.
+ * @param data void *, pointer to the data (x and y values).
+ * @param J gsl_matrix *, n x 3 matrix to store the jacobian.
+ * @return GSL_SUCCESS on success, error code otherwise.
+ */
+int exponential_jacobian(const gsl_vector *params, void *data, gsl_matrix *J);
+
 /**
  * @brief curve fitting for exponential function.
  * @param x_data vector<double>, x values of the data points.
@@ -38,6 +56,17 @@ int exponential_residual(const gsl_vector *params, void *data, gsl_vector *resid
  */
 hlop::exponential_params_t curve_fit_exponential(const std::vector<double> &x_data, const std::vector<double> &y_data,
                                                  const std::vector<double> &initial_guess);
+/**
+ * @brief curve fitting for exponential function with a quality report.
+ * @param x_data vector<double>, x values of the data points.
+ * @param y_data vector<double>, y values of the data points.
+ * @param initial_guess vector<double>, initial guess for the parameters [A, B, C].
+ * @param report fit_report, output, the quality of the fitted curve.
+ * @return parameters of the fitted exponential function.
+ * @throws hlop_err if the input data is invalid or the fitting fails.
+ */
+hlop::exponential_params_t curve_fit_exponential(const std::vector<double> &x_data, const std::vector<double> &y_data,
+                                                 const std::vector<double> &initial_guess, hlop::fit_report_t &report);
 } // namespace hlop
 
 #endif // __FIT_H__
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef __INTERP_H__
+#define __INTERP_H__
+
+#include <cstddef>
+#include <iostream>
+
+namespace hlop {
+/**
+ * @brief enum class interpolation mode.
+ * The interpolation modes of off-grid parameters are:
+ * - EXPONENTIAL, A * exp(-B * x) + C fitted over the whole range
+ * - LOG_LINEAR, piecewise linear in log2(size) / log(value)
+ * - MONOTONE_CUBIC, monotone piecewise cubic (Fritsch-Carlson) in log2(size) / log(value)
+ */
+enum class interp_mode {
+	EXPONENTIAL,
+	LOG_LINEAR,
+	MONOTONE_CUBIC
+};
+typedef interp_mode interp_mode_t;
+
+std::ostream &operator<<(std::ostream &os, const hlop::interp_mode_t &mode);
+
+/**
+ * @brief compute the tangents of a monotone cubic interpolation (Fritsch-Carlson).
+ * @param x const double *, ascending x values of the data points.
+ * @param y const double *, y values of the data points.
+ * @param n size_t, number of data points, at least 2.
+ * @param m double *, output, n tangents at the data points.
+ * @note The interpolation keeps the monotonicity of every segment of the data points.
+ */
+void monotone_tangents(const double *x, const double *y, std::size_t n, double *m);
+
+/**
+ * @brief find the segment of a data grid that contains a value.
+ * @param x const double *, ascending x values of the data points.
+ * @param n size_t, number of data points, at least 2.
+ * @param step double, the spacing of a uniform grid, 0 for a non-uniform grid.
+ * @param xv double, the value to locate.
+ * @return size_t, i in [0, n - 2], xv is in [x[i], x[i + 1]] unless it is out of the grid.
+ */
+std::size_t locate_segment(const double *x, std::size_t n, double step, double xv);
+
+/**
+ * @brief piecewise linear interpolation, linear extrapolation out of the grid.
+ * @param x const double *, ascending x values of the data points.
+ * @param y const double *, y values of the data points.
+ * @param n size_t, number of data points, at least 2.
+ * @param step double, the spacing of a uniform grid, 0 for a non-uniform grid.
+ * @param xv double, the value to interpolate at.
+ * @return double, the interpolated value.
+ */
+double interp_linear(const double *x, const double *y, std::size_t n, double step, double xv);
+
+/**
+ * @brief monotone cubic hermite interpolation, linear extrapolation with the end tangents out of the grid.
+ * @param x const double *, ascending x values of the data points.
+ * @param y const double *, y values of the data points.
+ * @param m const double *, tangents computed by monotone_tangents.
+ * @param n size_t, number of data points, at least 2.
+ * @param step double, the spacing of a uniform grid, 0 for a non-uniform grid.
+ * @param xv double, the value to interpolate at.
+ * @return double, the interpolated value.
+ */
+double interp_monotone_cubic(const double *x, const double *y, const double *m, std::size_t n, double step, double xv);
+
+/**
+ * @brief piecewise linear interpolation of many values.
+ * @param x const double *, ascending x values of the data points.
+ * @param y const double *, y values of the data points.
+ * @param n size_t, number of data points, at least 2.
+ * @param step double, the spacing of a uniform grid, 0 for a non-uniform grid.
+ * @param xv const double *, the values to interpolate at.
+ * @param out double *, output, the interpolated values, may be xv itself.
+ * @param count size_t, number of values.
+ */
+void interp_linear(const double *x, const double *y, std::size_t n, double step,
+                   const double *xv, double *out, std::size_t count);
+
+/**
+ * @brief monotone cubic hermite interpolation of many values.
+ * @param x const double *, ascending x values of the data points.
+ * @param y const double *, y values of the data points.
+ * @param m const double *, tangents computed by monotone_tangents.
+ * @param n size_t, number of data points, at least 2.
+ * @param step double, the spacing of a uniform grid, 0 for a non-uniform grid.
+ * @param xv const double *, the values to interpolate at.
+ * @param out double *, output, the interpolated values, may be xv itself.
+ * @param count size_t, number of values.
+ */
+void interp_monotone_cubic(const double *x, const double *y, const double *m, std::size_t n, double step,
+                           const double *xv, double *out, std::size_t count);
+} // namespace hlop
+
+#endif // __INTERP_H__
@@ -0,0 +1,78 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace hlop {
+/**
+ * @brief class thread pool.
+ * A fixed number of worker threads that run submitted tasks in submission order.
+ * The destructor waits for all submitted tasks to finish.
+ * @note A task must not wait for another task of the same pool, it may deadlock if all workers wait.
+ */
+class thread_pool {
+public:
+	using thread_pool_t = hlop::thread_pool;
+
+public:
+	/**
+	 * @brief constructor of thread_pool.
+	 * @param nthread size_t, the number of worker threads, the number of hardware threads if 0.
+	 */
+	explicit thread_pool(std::size_t nthread = 0);
+	thread_pool(const thread_pool_t &) = delete;
+	thread_pool_t &operator=(const thread_pool_t &) = delete;
+	~thread_pool();
+
+public:
+	/**
+	 * @brief submit a task.
+	 * @tparam F type of the task, callable without arguments.
+	 * @param f F, the task.
+	 * @return future, the result of the task, it rethrows the exception thrown by the task.
+	 */
+	template <typename F>
+	std::future<std::invoke_result_t<F>> submit(F &&f) {
+		using R = std::invoke_result_t<F>;
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+		std::future<R> res = task->get_future();
+		push([task]() { (*task)(); });
+		return res;
+	}
+	/**
+	 * @brief get the number of worker threads.
+	 * @return size_t, the number of worker threads.
+	 */
+	std::size_t size() const;
+
+private:
+	/**
+	 * @brief queue a task and wake up a worker.
+	 * @param task function<void()>, the task.
+	 */
+	void push(std::function<void()> task);
+	/**
+	 * @brief run tasks until the pool is destroyed.
+	 */
+	void work();
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool stopping = false;
+};
+typedef thread_pool::thread_pool_t thread_pool_t;
+} // namespace hlop
+
+#endif // __THREAD_POOL_H__
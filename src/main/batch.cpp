@@ -0,0 +1,372 @@
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "aux.h"
+#include "batch.h"
+#include "collective.h"
+#include "err.h"
+#include "factory.h"
+#include "main.h"
+#include "msg.h"
+#include "prediction_cache.h"
+#include "struct/type.h"
+#include "thread_pool.h"
+
+namespace {
+/// @brief a field of a json query, its value and its json text.
+struct json_field {
+	std::string value;
+	std::string raw;
+};
+
+void skip_space(const std::string &s, std::size_t &pos) {
+	while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos])))
+		++pos;
+}
+
+void expect(const std::string &s, std::size_t &pos, char c) {
+	skip_space(s, pos);
+	if (pos >= s.size() || s[pos] != c)
+		HLOP_ERR(hlop::format("invalid json at column {}, expect '{}'", pos + 1, c));
+	++pos;
+}
+
+std::string read_string(const std::string &s, std::size_t &pos) {
+	expect(s, pos, '"');
+	std::string res;
+	while (pos < s.size() && s[pos] != '"') {
+		char c = s[pos++];
+		if (c == '\\') {
+			if (pos >= s.size())
+				break;
+			switch (c = s[pos++]) {
+			case 'n': c = '\n'; break;
+			case 't': c = '\t'; break;
+			case 'r': c = '\r'; break;
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'u':
+				// only the ascii characters are expected in a query
+				if (pos + 4 > s.size())
+					HLOP_ERR("invalid json, truncated \\u escape");
+				c = static_cast<char>(std::stoi(s.substr(pos, 4), nullptr, 16));
+				pos += 4;
+				break;
+			default: break; // ", \ and /
+			}
+		}
+		res += c;
+	}
+	expect(s, pos, '"');
+	return res;
+}
+
+/**
+ * @brief read a number, true, false or null.
+ */
+std::string read_scalar(const std::string &s, std::size_t &pos) {
+	skip_space(s, pos);
+	const std::size_t begin = pos;
+	while (pos < s.size() && (std::isalnum(static_cast<unsigned char>(s[pos])) || s[pos] == '-' || s[pos] == '+' ||
+	                          s[pos] == '.'))
+		++pos;
+	if (pos == begin)
+		HLOP_ERR(hlop::format("invalid json at column {}, expect a value", pos + 1));
+	return s.substr(begin, pos - begin);
+}
+
+/**
+ * @brief read a value, an array is read as its items joined by commas.
+ */
+json_field read_value(const std::string &s, std::size_t &pos) {
+	skip_space(s, pos);
+	const std::size_t begin = pos;
+	json_field f;
+	if (pos < s.size() && s[pos] == '"') {
+		f.value = read_string(s, pos);
+	} else if (pos < s.size() && s[pos] == '[') {
+		++pos;
+		skip_space(s, pos);
+		while (pos < s.size() && s[pos] != ']') {
+			if (!f.value.empty())
+				expect(s, pos, ',');
+			skip_space(s, pos);
+			f.value += (f.value.empty() ? "" : ",") + (s[pos] == '"' ? read_string(s, pos) : read_scalar(s, pos));
+			skip_space(s, pos);
+		}
+		expect(s, pos, ']');
+	} else {
+		f.value = read_scalar(s, pos);
+	}
+	f.raw = s.substr(begin, pos - begin);
+	return f;
+}
+
+/**
+ * @brief parse a json object of scalars and arrays of scalars.
+ */
+std::map<std::string, json_field> parse_json(const std::string &s) {
+	std::map<std::string, json_field> res;
+	std::size_t pos = 0;
+	expect(s, pos, '{');
+	skip_space(s, pos);
+	while (pos < s.size() && s[pos] != '}') {
+		if (!res.empty())
+			expect(s, pos, ',');
+		const std::string key = read_string(s, pos);
+		expect(s, pos, ':');
+		res[key] = read_value(s, pos);
+		skip_space(s, pos);
+	}
+	expect(s, pos, '}');
+	skip_space(s, pos);
+	if (pos != s.size())
+		HLOP_ERR(hlop::format("invalid json at column {}, trailing characters", pos + 1));
+	return res;
+}
+
+/**
+ * @brief split a csv line, a double quoted field may hold commas and "" for a quote.
+ */
+std::vector<std::string> split_csv(const std::string &s) {
+	std::vector<std::string> res(1);
+	bool quoted = false;
+	for (std::size_t i = 0; i < s.size(); ++i) {
+		if (quoted && s[i] == '"' && i + 1 < s.size() && s[i + 1] == '"')
+			res.back() += s[++i];
+		else if (s[i] == '"')
+			quoted = !quoted;
+		else if (!quoted && s[i] == ',')
+			res.emplace_back();
+		else
+			res.back() += s[i];
+	}
+	if (quoted)
+		HLOP_ERR("invalid csv, unterminated quote");
+	return res;
+}
+
+int to_int(const std::string &field, const std::string &s) {
+	const auto v = hlop::stov<int>(s);
+	if (v.size() != 1)
+		HLOP_ERR(hlop::format("{} must be an integer, got '{}'", field, s));
+	return v[0];
+}
+
+bool to_bool(const std::string &field, const std::string &s) {
+	if (s == "true" || s == "1")
+		return true;
+	if (s == "false" || s == "0" || s.empty())
+		return false;
+	HLOP_ERR(hlop::format("{} must be true or false, got '{}'", field, s));
+	return false; // unreachable
+}
+
+hlop::query_t json_query(const std::map<std::string, json_field> &fields) {
+	hlop::query_t q{"", "", "", "", 0, "", false};
+	for (const auto &[key, f] : fields) {
+		if (key == "op")
+			q.op = f.value;
+		else if (key == "algo")
+			q.algo = f.value;
+		else if (key == "pf")
+			q.pf = f.value;
+		else if (key == "nl")
+			q.nl = f.value;
+		else if (key == "ppn")
+			q.ppn = to_int(key, f.value);
+		else if (key == "msz")
+			q.msz = f.value;
+		else if (key == "prune")
+			q.prune = to_bool(key, f.value);
+		else if (key != "id" && key != "ranking")
+			HLOP_ERR(hlop::format("unknown field {}", key));
+	}
+	return q;
+}
+
+hlop::query_t csv_query(const std::vector<std::string> &fields) {
+	if (fields.size() < 6 || fields.size() > 7)
+		HLOP_ERR(hlop::format("a csv query has 6 or 7 fields op,algo,pf,nl,ppn,msz[,prune], got {}", fields.size()));
+	return hlop::query_t{fields[0], fields[1], fields[2], fields[3], to_int("ppn", fields[4]), fields[5],
+	                     fields.size() == 7 && to_bool("prune", fields[6])};
+}
+
+template <typename T, typename F>
+std::string json_array(const std::vector<T> &v, F &&item) {
+	std::string res = "[";
+	for (std::size_t i = 0; i < v.size(); ++i)
+		res += (i == 0 ? "" : ",") + item(v[i]);
+	return res + "]";
+}
+} // namespace
+
+hlop::batch::batch(hlop::prediction_cache_t *cache) : cache(cache) {
+	for (const auto op : hlop::get_collective_ops())
+		predictors.emplace(op, hlop::make_collective(op));
+}
+
+bool hlop::batch::answer(const std::string &line, long id, std::string &res) const {
+	res.clear();
+	std::string text = line;
+	if (!text.empty() && text.back() == '\r')
+		text.pop_back();
+	const std::size_t first = text.find_first_not_of(" \t");
+	if (first == std::string::npos || text[first] == '#')
+		return true;
+	const bool json = text[first] == '{';
+
+	std::string head = hlop::format("{\"query\":{}", id);
+	try {
+		hlop::query_t q;
+		bool ranked = false;
+		if (json) {
+			const auto fields = parse_json(text);
+			const auto it = fields.find("id");
+			if (it != fields.end())
+				head += ",\"id\":" + it->second.raw;
+			const auto ranking = fields.find("ranking");
+			ranked = ranking == fields.end() || to_bool("ranking", ranking->second.value);
+			q = json_query(fields);
+		} else {
+			const auto fields = split_csv(text);
+			if (fields[0] == "op") {
+				res = "query,msz,algo,time,error\n";
+				return true;
+			}
+			q = csv_query(fields);
+		}
+		const auto args = hlop::parse_query(q, &lists);
+		const auto it = predictors.find(args.op);
+		if (it == predictors.end())
+			HLOP_ERR(hlop::format("unsupported operation type: {}", hlop::enum_name(args.op)));
+		const auto &c = *it->second;
+
+		// the algorithm and time of each message size, the best one of --algo=AUTO
+		std::vector<std::string> algos(args.msz.size());
+		std::vector<double> times(args.msz.size(), 0.0);
+		std::vector<std::vector<hlop::algo_rank_t>> rankings;
+		std::vector<hlop::algo_rank_t> bests;
+		if (args.algo.has_value()) {
+			times = cache != nullptr ? cache->predict(c, args.op, args.algo.value(), *args.nl, args.msz)
+			                         : c.predict(args.algo.value(), *args.nl, args.msz, 0);
+			algos.assign(args.msz.size(), std::string{hlop::enum_name(args.algo.value())});
+		} else {
+			// only the best algorithms are cached, a reported ranking is always ranked again
+			if (cache != nullptr)
+				bests = cache->select_best(c, args.op, *args.nl, args.msz, args.prune);
+			if (cache == nullptr || ranked)
+				rankings = c.select_best(*args.nl, args.msz, 0, nullptr, args.prune);
+			if (cache == nullptr)
+				for (const auto &ranking : rankings)
+					bests.push_back(ranking.empty() ? hlop::algo_rank_t{{}, hlop::algo_status::FAILED, 0.0, "no algorithm"}
+					                                : ranking.front());
+			for (std::size_t i = 0; i < bests.size(); ++i)
+				if (bests[i].status == hlop::algo_status::OK) {
+					algos[i] = hlop::enum_name(bests[i].algo);
+					times[i] = bests[i].time;
+				} else {
+					times[i] = std::nan("");
+				}
+		}
+
+		if (!json) {
+			// a message size no algorithm is predicted for fails the query, its row reports why
+			bool ok = true;
+			for (std::size_t i = 0; i < args.msz.size(); ++i) {
+				std::string error;
+				if (algos[i].empty()) {
+					ok = false;
+					error = hlop::format("no algorithm is predicted, the best one is {}", hlop::enum_name(bests[i].status));
+					if (!bests[i].reason.empty())
+						error += ", " + bests[i].reason;
+				}
+				res += hlop::format("{},{},{},{},{}\n", id, args.msz[i], algos[i],
+				                    algos[i].empty() ? std::string{} : hlop::json_number(times[i]), hlop::quote_csv(error));
+			}
+			return ok;
+		}
+		res = hlop::format("{},\"op\":\"{}\",\"algo\":\"{}\",\"msz\":{}", head, hlop::enum_name(args.op),
+		                   q.algo, json_array(args.msz, [](int m) { return std::to_string(m); }));
+		if (!args.algo.has_value())
+			res += ",\"best\":" + json_array(algos, [](const std::string &a) {
+				       return a.empty() ? std::string{"null"} : hlop::quote_json(a);
+			       });
+		res += ",\"time\":" + json_array(times, hlop::json_number);
+		if (ranked && !args.algo.has_value())
+			res += ",\"ranking\":" + json_array(rankings, [](const std::vector<hlop::algo_rank_t> &ranking) {
+				       return json_array(ranking, [](const hlop::algo_rank_t &r) {
+					       std::string item = hlop::format("{\"algo\":\"{}\",\"status\":\"{}\"", hlop::enum_name(r.algo),
+					                                       hlop::enum_name(r.status));
+					       if (r.status == hlop::algo_status::OK || r.status == hlop::algo_status::PRUNED)
+						       item += ",\"time\":" + hlop::json_number(r.time);
+					       if (!r.reason.empty())
+						       item += ",\"reason\":" + hlop::quote_json(r.reason);
+					       return item + "}";
+				       });
+			       });
+		res += "}\n";
+		return true;
+	} catch (const std::exception &e) {
+		res = json ? hlop::format("{},\"error\":{}}\n", head, hlop::quote_json(e.what()))
+		           : hlop::format("{},,,,{}\n", id, hlop::quote_csv(e.what()));
+		return false;
+	}
+}
+
+long hlop::batch::run(std::istream &in, std::ostream &os, hlop::thread_pool_t &pool) const {
+	// the reader submits the queries, the writer writes their results in order, so a result is written
+	// as soon as it is ready even if the next query has not arrived yet
+	using result_t = std::pair<bool, std::string>;
+	const std::size_t window = 4 * pool.size();
+	std::deque<std::future<result_t>> pending;
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool done = false;
+	long failed = 0;
+	std::thread writer([&]() {
+		for (;;) {
+			std::unique_lock<std::mutex> lock{mtx};
+			cv.wait(lock, [&]() { return !pending.empty() || done; });
+			if (pending.empty())
+				return;
+			auto f = std::move(pending.front());
+			pending.pop_front();
+			lock.unlock();
+			cv.notify_all();
+			const auto r = f.get();
+			if (!r.first)
+				++failed;
+			os << r.second << std::flush;
+		}
+	});
+
+	std::string line;
+	for (long id = 1; std::getline(in, line); ++id) {
+		auto f = pool.submit([this, line, id]() {
+			result_t r;
+			r.first = answer(line, id, r.second);
+			return r;
+		});
+		std::unique_lock<std::mutex> lock{mtx};
+		cv.wait(lock, [&]() { return pending.size() < window; });
+		pending.push_back(std::move(f));
+		cv.notify_all();
+	}
+	{
+		std::lock_guard<std::mutex> lock{mtx};
+		done = true;
+	}
+	cv.notify_all();
+	writer.join();
+	return failed;
+}
@@ -1,106 +1,261 @@
+#include <cctype>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "aux.h"
-#include "bcast.h"
+#include "batch.h"
+#include "collective.h"
 #include "err.h"
+#include "factory.h"
 #include "gflags/gflags.h"
 #include "main.h"
 #include "platform.h"
-#include "scatter.h"
+#include "prediction_cache.h"
+#include "struct/node_list.h"
 #include "struct/type.h"
+#include "sweep.h"
+#include "thread_pool.h"
 
 DEFINE_string(op, "", "collective operation type");
-DEFINE_string(algo, "", "collective operation algorithm type");
+DEFINE_string(algo, "", "collective operation algorithm type, AUTO to rank all algorithms");
 DEFINE_string(pf, "", "platform");
 DEFINE_string(nl, "", "node list");
-DEFINE_int32(ppn, 0, "process per node");
-DEFINE_string(msz, "", "message size");
+DEFINE_string(ppn, "", "process per node, a list of them is swept, see --msz");
+DEFINE_string(msz, "", "message sizes, a list of sizes with an optional K, M or G suffix and ranges start:end:xF "
+                       "or start:end:+S, e.g., 1:4M:x2 or 1024:65536:+1024");
+DEFINE_string(nodes, "", "node counts to sweep, the first hosts of --nl, a list like --msz, all hosts by default");
+DEFINE_int32(threads, 0, "number of threads of a sweep or a batch, the number of cores by default");
+DEFINE_string(format, "TEXT", "output format, TEXT, or CSV or JSON for a sweep, see sweep.h");
+DEFINE_bool(prune, false, "with --algo=AUTO, stop predicting an algorithm once it is slower than the best one");
+DEFINE_string(interp, "", "interpolation mode of off-grid message sizes, EXPONENTIAL, LOG_LINEAR or MONOTONE_CUBIC, "
+                          "the mode of the parameter file by default");
+DEFINE_string(batch, "", "file of queries, one json or csv query per line, - for stdin, see batch.h, "
+                         "the results are written to stdout in order");
+DEFINE_string(cache, "", "file of the prediction cache, shared by runs and processes, created if missing, "
+                         "no cache by default");
+DEFINE_uint64(cache_size, hlop::prediction_cache_t::DEFAULT_CAPACITY,
+              "number of predictions of a new --cache file, 48 bytes each");
 
-hlop::exec_args_t hlop::parse_argument(int *argc, char ***argv) {
-	gflags::ParseCommandLineFlags(argc, argv, true);
-	if (FLAGS_op == "")
+hlop::node_list_cache::node_list_cache(std::size_t capacity) : capacity(capacity) {}
+
+hlop::const_node_list_ptr_t hlop::node_list_cache::get(hlop::platform_t pf, const std::string &nl, int ppn) {
+	key_t key{pf, nl, ppn};
+	{
+		std::lock_guard<std::mutex> lock{mtx};
+		auto it = lists.find(key);
+		if (it != lists.end())
+			return it->second;
+	}
+	// parse outside of the lock, a list parsed by two threads at once is kept once
+	auto res = std::make_shared<const hlop::node_list_t>(
+	    pf, nl, ppn,
+	    hlop::arrangement_t{.node_arrange = hlop::rank_arrangement::BLOCK, .core_arrange = hlop::rank_arrangement::BLOCK});
+	std::lock_guard<std::mutex> lock{mtx};
+	if (capacity == 0)
+		return res;
+	auto [it, inserted] = lists.emplace(key, res);
+	if (!inserted)
+		return it->second;
+	order.push_back(std::move(key));
+	while (order.size() > capacity) {
+		lists.erase(order.front());
+		order.pop_front();
+	}
+	return res;
+}
+
+hlop::exec_args_t hlop::parse_query(const hlop::query_t &q, hlop::node_list_cache_t *cache) {
+	if (q.op == "")
 		HLOP_ERR("operation type must be specified with --op");
-	if (FLAGS_algo == "")
+	if (q.algo == "")
 		HLOP_ERR("algorithm type must be specified with --algo");
-	if (FLAGS_pf == "")
+	if (q.pf == "")
 		HLOP_ERR("platform must be specified with --pf");
-	if (FLAGS_nl == "")
+	if (q.nl == "")
 		HLOP_ERR("node list must be specified with --nl");
-	if (FLAGS_ppn < 1)
+	if (q.ppn < 1)
 		HLOP_ERR("processes per node must be greater than 0");
-	if (FLAGS_msz == "")
+	if (q.msz == "")
 		HLOP_ERR("message size must be specified with --msz");
 
-	hlop::op_type_t op = hlop::enum_cast<hlop::op_type>(FLAGS_op);
-	hlop::algo_type_t algo = hlop::enum_cast<hlop::algo_type>(FLAGS_algo);
-	hlop::node_list_t nl{hlop::enum_cast<hlop::platform>(FLAGS_pf),
-	                     FLAGS_nl,
-	                     FLAGS_ppn,
-	                     {.node_arrange = hlop::rank_arrangement::BLOCK,
-	                      .core_arrange = hlop::rank_arrangement::BLOCK}};
-	auto msz = hlop::stov<int>(FLAGS_msz);
+	hlop::op_type_t op = hlop::enum_cast<hlop::op_type>(q.op);
+	std::optional<hlop::algo_type_t> algo;
+	if (q.algo != "AUTO")
+		algo = hlop::enum_cast<hlop::algo_type>(q.algo);
+	const auto pf = hlop::enum_cast<hlop::platform>(q.pf);
+	auto nl = cache != nullptr
+	              ? cache->get(pf, q.nl, q.ppn)
+	              : std::make_shared<const hlop::node_list_t>(pf, q.nl, q.ppn,
+	                                                          hlop::arrangement_t{.node_arrange = hlop::rank_arrangement::BLOCK,
+	                                                                              .core_arrange = hlop::rank_arrangement::BLOCK});
+	auto msz = hlop::parse_sizes(q.msz, "message size");
 
-	return hlop::exec_args_t{.op = op, .algo = algo, .nl = std::move(nl), .msz = std::move(msz)};
+	return hlop::exec_args_t{.op = op, .algo = algo, .nl = std::move(nl), .msz = std::move(msz), .prune = q.prune};
 }
 
-double hlop::execute_with_arg(hlop::op_type_t op, hlop::algo_type_t algo, hlop::node_list_t nl, int msg_size) {
-	switch (op) {
-	case hlop::op_type::ALLGATHER: {
-		break;
-	}
-	case hlop::op_type::ALLREDUCE: {
-		break;
-	}
-	case hlop::op_type::ALLTOALL: {
-		break;
-	}
-	case hlop::op_type::BCAST: {
-		hlop::bcast predictor;
-		return predictor.predict(algo, nl, msg_size, 0);
-		break;
-	}
-	case hlop::op_type::GATHER: {
-		break;
-	}
-	case hlop::op_type::REDUCE: {
-		break;
-	}
-	case hlop::op_type::SCATTER: {
-		hlop::scatter predictor;
-		return predictor.predict(algo, nl, msg_size, 0);
-		break;
-	}
-	default: {
-		HLOP_ERR(hlop::format("unknown operation type: {}", hlop::enum_name(op)));
-		break;
-	}
-	}
-	return 0.0;
+hlop::exec_args_t hlop::parse_argument() {
+	if (FLAGS_interp != "")
+		hlop::collective::set_interp_mode(hlop::enum_cast<hlop::interp_mode>(FLAGS_interp));
+	const auto ppn = FLAGS_ppn != "" ? hlop::parse_sizes(FLAGS_ppn, "processes per node") : std::vector<int>{0};
+	if (ppn.size() != 1)
+		HLOP_ERR("a single query has one number of processes per node, a list of them is a sweep");
+	return hlop::parse_query(hlop::query_t{FLAGS_op, FLAGS_algo, FLAGS_pf, FLAGS_nl, ppn[0], FLAGS_msz, FLAGS_prune});
+}
+
+double hlop::execute_with_arg(hlop::op_type_t op, hlop::algo_type_t algo, const hlop::node_list_t &nl, int msg_size) {
+	return hlop::make_collective(op)->predict(algo, nl, msg_size, 0);
 }
 
 std::vector<double> hlop::execute_with_args(hlop::op_type_t op,
                                             hlop::algo_type_t algo,
-                                            hlop::node_list_t nl,
-                                            std::vector<int> msg_sizes) {
-	std::vector<double> res;
-	for (const auto &m : msg_sizes)
-		res.emplace_back(execute_with_arg(op, algo, nl, m));
-	return std::move(res);
+                                            const hlop::node_list_t &nl,
+                                            const std::vector<int> &msg_sizes,
+                                            hlop::prediction_cache_t *cache) {
+	// one predictor evaluates all message sizes, the schedule is simulated once if possible
+	const auto predictor = hlop::make_collective(op);
+	return cache != nullptr ? cache->predict(*predictor, op, algo, nl, msg_sizes)
+	                        : predictor->predict(algo, nl, msg_sizes, 0);
+}
+
+std::vector<std::vector<hlop::algo_rank_t>> hlop::select_with_args(hlop::op_type_t op, const hlop::node_list_t &nl,
+                                                                   const std::vector<int> &msg_sizes, bool prune) {
+	// all algorithms share the node list and the parameters, one task per algorithm
+	const auto predictor = hlop::make_collective(op);
+	hlop::thread_pool_t pool{predictor->get_algos().size()};
+	return predictor->select_best(nl, msg_sizes, 0, &pool, prune);
+}
+
+namespace {
+long long parse_size(const std::string &item, const std::string &what) {
+	std::size_t begin = item.find_first_not_of(" \t"), end = item.find_last_not_of(" \t");
+	if (begin == std::string::npos)
+		HLOP_ERR(hlop::format("empty {}", what));
+	std::size_t pos = begin;
+	while (pos <= end && std::isdigit(static_cast<unsigned char>(item[pos])))
+		++pos;
+	// 18 digits always fit in a long long
+	if (pos == begin || pos - begin > 18)
+		HLOP_ERR(hlop::format("cannot convert '{}' to a {}", item, what));
+	long long v = std::stoll(item.substr(begin, pos - begin));
+	if (pos <= end) {
+		const char unit = std::toupper(static_cast<unsigned char>(item[pos++]));
+		const int shift = unit == 'K' ? 10 : unit == 'M' ? 20 : unit == 'G' ? 30 : -1;
+		if (shift < 0 || pos <= end)
+			HLOP_ERR(hlop::format("cannot convert '{}' to a {}", item, what));
+		v = v > (LLONG_MAX >> shift) ? LLONG_MAX : v << shift;
+	}
+	if (v <= 0 || v > INT_MAX)
+		HLOP_ERR(hlop::format("{} {} must be in [1, {}]", what, item, INT_MAX));
+	return v;
+}
+} // namespace
+
+std::vector<int> hlop::parse_sizes(const std::string &s, const std::string &what) {
+	std::vector<int> res;
+	const auto add = [&](long long v) {
+		if (res.size() >= hlop::MAX_SIZES)
+			HLOP_ERR(hlop::format("more than {} {}s in {}", hlop::MAX_SIZES, what, s));
+		res.push_back(static_cast<int>(v));
+	};
+	std::stringstream ss{s};
+	std::string item;
+	while (std::getline(ss, item, ',')) {
+		std::vector<std::string> parts;
+		std::stringstream is{item};
+		for (std::string f; std::getline(is, f, ':');)
+			parts.push_back(f);
+		if (parts.size() == 1) {
+			add(parse_size(parts[0], what));
+			continue;
+		}
+		if (parts.size() > 3)
+			HLOP_ERR(hlop::format("a range of {}s is start:end:xF or start:end:+S, got '{}'", what, item));
+		const long long start = parse_size(parts[0], what), stop = parse_size(parts[1], what);
+		if (stop < start)
+			HLOP_ERR(hlop::format("the range '{}' ends before it starts", item));
+		std::string step = parts.size() == 3 ? parts[2] : "x2";
+		step.erase(0, step.find_first_not_of(" \t"));
+		if (step.empty() || (step[0] != 'x' && step[0] != '+'))
+			HLOP_ERR(hlop::format("the step of the range '{}' must be xF or +S", item));
+		const long long by = parse_size(step.substr(1), what + " step");
+		if (step[0] == 'x' && by < 2)
+			HLOP_ERR(hlop::format("the factor of the range '{}' must be at least 2", item));
+		for (long long v = start; v <= stop; v = step[0] == 'x' ? v * by : v + by)
+			add(v);
+	}
+	if (res.empty())
+		HLOP_ERR(hlop::format("no {} in '{}'", what, s));
+	return res;
 }
 
 // ./main --op=BCAST --algo=BINOMIAL --pf=DF
 // --nl="i10r4n[03-04,08-09,13-14,16,18-19]" --ppn=16 --msz="1,2,4"
+// ./main --op=BCAST --algo=AUTO --pf=DF --nl="i10r4n[03-04,08-09]" --ppn=16 --msz="1,1024"
+// ./main --op=ALLGATHER --algo=AUTO --prune --pf=DF --nl="i10r4n[03-04,08-09]" --ppn=16 --msz="1,1024"
+// ./main --batch=queries.ndjson, or --batch=- to read the queries from stdin
+// ./main --cache=$HOME/.hlop.cache ... to keep the predictions across runs
+// ./main --op=BCAST --algo=BINOMIAL --pf=DF --nl="i10r4n[03-04,08-09,13-14,16,18-19]"
+// --nodes=2:8:x2 --ppn=8,16 --msz=1:4M:x2 --threads=8 --format=CSV
 int main(int argc, char *argv[]) {
 	gflags::SetUsageMessage("");
-	hlop::exec_args_t args = hlop::parse_argument(&argc, &argv);
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (FLAGS_threads < 0)
+		HLOP_ERR("--threads must not be negative");
+	// the interpolation mode is set before, it is a part of the keys of the cache
+	const auto open_cache = []() {
+		return FLAGS_cache != "" ? std::make_unique<hlop::prediction_cache_t>(FLAGS_cache, FLAGS_cache_size) : nullptr;
+	};
+	if (FLAGS_batch != "") {
+		if (FLAGS_interp != "")
+			hlop::collective::set_interp_mode(hlop::enum_cast<hlop::interp_mode>(FLAGS_interp));
+		std::ifstream file;
+		if (FLAGS_batch != "-") {
+			file.open(FLAGS_batch);
+			if (!file)
+				HLOP_ERR(hlop::format("cannot open {}", FLAGS_batch));
+		}
+		// the parameters, the predictors and the node lists are kept across the queries
+		const auto cache = open_cache();
+		const hlop::batch_t b{cache.get()};
+		hlop::thread_pool_t pool{static_cast<std::size_t>(FLAGS_threads)};
+		const long failed = b.run(FLAGS_batch != "-" ? file : std::cin, std::cout, pool);
+		return failed > 0 ? 1 : 0;
+	}
+	const auto format = hlop::enum_cast<hlop::output_format>(FLAGS_format);
+	if (format != hlop::output_format::TEXT || FLAGS_nodes != "" ||
+	    (FLAGS_ppn != "" && hlop::parse_sizes(FLAGS_ppn, "processes per node").size() > 1)) {
+		if (FLAGS_interp != "")
+			hlop::collective::set_interp_mode(hlop::enum_cast<hlop::interp_mode>(FLAGS_interp));
+		// one predictor and one node list of each topology for the whole sweep
+		const auto cache = open_cache();
+		const hlop::sweep_t sw{hlop::query_t{FLAGS_op, FLAGS_algo, FLAGS_pf, FLAGS_nl, 0, FLAGS_msz, FLAGS_prune},
+		                       FLAGS_nodes, FLAGS_ppn, format, cache.get()};
+		hlop::thread_pool_t pool{static_cast<std::size_t>(FLAGS_threads)};
+		return sw.run(std::cout, pool) > 0 ? 1 : 0;
+	}
+	hlop::exec_args_t args = hlop::parse_argument();
 	std::cout << "Operation: " << args.op << std::endl
-	          << "Algorithm: " << args.algo << std::endl
-	          << "Platform: " << args.nl.get_platform() << std::endl
-	          << "Processes per node: " << args.nl.get_ppn() << std::endl
-	          << "Node list: " << args.nl << std::endl
+	          << "Algorithm: " << (args.algo.has_value() ? hlop::enum_name(args.algo.value()) : "AUTO") << std::endl
+	          << "Platform: " << args.nl->get_platform() << std::endl
+	          << "Processes per node: " << args.nl->get_ppn() << std::endl
+	          << "Node list: " << *args.nl << std::endl
 	          << "Message sizes: " << hlop::vtos(args.msz) << std::endl;
-	const auto res = hlop::execute_with_args(args.op, args.algo, args.nl, args.msz);
+	if (!args.algo.has_value()) {
+		const auto rankings = hlop::select_with_args(args.op, *args.nl, args.msz, args.prune);
+		for (std::size_t i = 0; i < args.msz.size(); ++i)
+			std::cout << "Predict ranking (" << args.msz[i] << "): " << hlop::vtos(rankings[i]) << std::endl;
+		return 0;
+	}
+	const auto cache = open_cache();
+	const auto res = hlop::execute_with_args(args.op, args.algo.value(), *args.nl, args.msz, cache.get());
 	std::cout << "Predict result: " << hlop::vtos(res) << std::endl;
 	return 0;
-}
\ No newline at end of file
+}
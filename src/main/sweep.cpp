@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "aux.h"
+#include "collective.h"
+#include "err.h"
+#include "factory.h"
+#include "main.h"
+#include "msg.h"
+#include "node/hostlist.h"
+#include "platform.h"
+#include "prediction_cache.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+#include "sweep.h"
+#include "thread_pool.h"
+
+namespace {
+/// @brief the message sizes of a topology predicted by a task.
+struct part {
+	int nodes;
+	int ppn;
+	std::vector<int> msz;
+	std::future<std::vector<hlop::algo_rank_t>> res;
+};
+
+std::string join(const std::vector<std::string> &hosts, int n) {
+	std::string res;
+	for (int i = 0; i < n; ++i)
+		res += (i == 0 ? "" : ",") + hosts[i];
+	return res;
+}
+} // namespace
+
+hlop::sweep::sweep(const hlop::query_t &q, const std::string &nodes, const std::string &ppn,
+                   hlop::output_format_t format, hlop::prediction_cache_t *cache)
+    : prune(q.prune), format(format), cache(cache) {
+	if (q.op == "")
+		HLOP_ERR("operation type must be specified with --op");
+	if (q.algo == "")
+		HLOP_ERR("algorithm type must be specified with --algo");
+	if (q.pf == "")
+		HLOP_ERR("platform must be specified with --pf");
+	if (q.nl == "")
+		HLOP_ERR("node list must be specified with --nl");
+	if (ppn == "")
+		HLOP_ERR("processes per node must be specified with --ppn");
+	if (q.msz == "")
+		HLOP_ERR("message size must be specified with --msz");
+
+	op = hlop::enum_cast<hlop::op_type>(q.op);
+	if (q.algo != "AUTO")
+		algo = hlop::enum_cast<hlop::algo_type>(q.algo);
+	pf = hlop::enum_cast<hlop::platform>(q.pf);
+	hosts = hlop::expand_hostlist(q.nl);
+	this->nodes = nodes == "" ? std::vector<int>{static_cast<int>(hosts.size())} : hlop::parse_sizes(nodes, "node count");
+	for (const int n : this->nodes)
+		if (n > static_cast<int>(hosts.size()))
+			HLOP_ERR(hlop::format("node count {} is above the {} hosts of the node list", n, hosts.size()));
+	this->ppn = hlop::parse_sizes(ppn, "processes per node");
+	msz = hlop::parse_sizes(q.msz, "message size");
+	predictor = hlop::make_collective(op);
+}
+
+std::vector<hlop::algo_rank_t> hlop::sweep::predict_part(const hlop::node_list_t *nl, const std::vector<int> &sizes,
+                                                         const std::string &error) const {
+	const hlop::algo_rank_t fail{algo.value_or(hlop::algo_type_t{}), hlop::algo_status::FAILED, 0.0, error};
+	if (nl == nullptr)
+		return std::vector<hlop::algo_rank_t>(sizes.size(), fail);
+	std::vector<hlop::algo_rank_t> res;
+	try {
+		if (algo.has_value()) {
+			const auto times = cache != nullptr ? cache->predict(*predictor, op, algo.value(), *nl, sizes)
+			                                    : predictor->predict(algo.value(), *nl, sizes, 0);
+			for (const double time : times)
+				res.push_back(hlop::algo_rank_t{algo.value(), hlop::algo_status::OK, time, ""});
+		} else if (cache != nullptr) {
+			res = cache->select_best(*predictor, op, *nl, sizes, prune);
+		} else {
+			// the algorithms are ranked in this task, not on the pool it runs on
+			for (const auto &ranking : predictor->select_best(*nl, sizes, 0, nullptr, prune))
+				res.push_back(ranking.empty() ? fail : ranking.front());
+		}
+	} catch (const std::exception &e) {
+		res.assign(sizes.size(), fail);
+		for (auto &r : res)
+			r.reason = e.what();
+	}
+	return res;
+}
+
+long hlop::sweep::run(std::ostream &os, hlop::thread_pool_t &pool) const {
+	// the node lists of all topologies are parsed concurrently, ahead of their predictions
+	std::vector<std::pair<int, int>> topologies;
+	std::vector<std::future<hlop::const_node_list_ptr_t>> lists;
+	for (const int n : nodes)
+		for (const int p : ppn) {
+			topologies.emplace_back(n, p);
+			lists.push_back(pool.submit([this, n, p]() {
+				return std::make_shared<const hlop::node_list_t>(
+				    pf, join(hosts, n), p,
+				    hlop::arrangement_t{.node_arrange = hlop::rank_arrangement::BLOCK,
+				                        .core_arrange = hlop::rank_arrangement::BLOCK});
+			}));
+		}
+
+	// a topology is split into enough parts to keep the pool busy, a part plans its algorithm once
+	const std::size_t nparts =
+	    std::clamp<std::size_t>((2 * pool.size() + topologies.size() - 1) / topologies.size(), 1, msz.size());
+	const std::size_t part_size = (msz.size() + nparts - 1) / nparts;
+	const std::size_t window = 4 * pool.size();
+
+	long failed = 0;
+	const auto write = [&](part &pt) {
+		const auto res = pt.res.get();
+		for (std::size_t i = 0; i < pt.msz.size(); ++i) {
+			const auto &r = res[i];
+			const bool ok = r.status == hlop::algo_status::OK;
+			const std::string name = ok || algo.has_value() ? std::string{hlop::enum_name(r.algo)} : "";
+			const std::string error =
+			    ok ? "" : (r.reason.empty() ? std::string{hlop::enum_name(r.status)} : r.reason);
+			failed += ok ? 0 : 1;
+			switch (format) {
+			case hlop::output_format::TEXT:
+				os << hlop::format("Predict (nodes {}, ppn {}, msz {}): ", pt.nodes, pt.ppn, pt.msz[i])
+				   << (ok ? hlop::format("{} {}", name, r.time) : hlop::format("{} failed: {}", name, error)) << "\n";
+				break;
+			case hlop::output_format::CSV:
+				os << hlop::format("{},{},{},{},{},{}\n", pt.nodes, pt.ppn, pt.msz[i], name,
+				                   ok ? hlop::json_number(r.time) : std::string{}, hlop::quote_csv(error));
+				break;
+			case hlop::output_format::JSON:
+				os << hlop::format("{\"nodes\":{},\"ppn\":{},\"msz\":{},\"algo\":{},", pt.nodes, pt.ppn, pt.msz[i],
+				                   name.empty() ? std::string{"null"} : hlop::quote_json(name))
+				   << (ok ? "\"time\":" + hlop::json_number(r.time) : "\"error\":" + hlop::quote_json(error)) << "}\n";
+				break;
+			}
+		}
+		os << std::flush;
+	};
+
+	if (format == hlop::output_format::CSV)
+		os << "nodes,ppn,msz,algo,time,error\n";
+	std::deque<part> pending;
+	const auto ready = [](part &pt) {
+		return pt.res.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	};
+	for (std::size_t t = 0; t < topologies.size(); ++t) {
+		const auto [n, p] = topologies[t];
+		hlop::const_node_list_ptr_t nl;
+		std::string error;
+		try {
+			nl = lists[t].get();
+		} catch (const std::exception &e) {
+			error = e.what();
+		}
+		for (std::size_t begin = 0; begin < msz.size(); begin += part_size) {
+			const std::vector<int> sizes(msz.begin() + begin, msz.begin() + std::min(begin + part_size, msz.size()));
+			while (pending.size() >= window || (!pending.empty() && ready(pending.front()))) {
+				write(pending.front());
+				pending.pop_front();
+			}
+			pending.push_back(part{n, p, sizes, pool.submit([this, nl, sizes, error]() {
+				                       return predict_part(nl.get(), sizes, error);
+			                       })});
+		}
+	}
+	for (auto &pt : pending)
+		write(pt);
+	return failed;
+}
@@ -0,0 +1,131 @@
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "err.h"
+#include "msg.h"
+#include "node/hostlist.h"
+
+namespace {
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+bool is_alpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+/**
+ * @brief parse a decimal number of a range.
+ * @param s string_view, the number, digits only.
+ * @param group string_view, the bracket group, for error messages.
+ * @return long long, the number.
+ * @throws hlop_err, if s is empty, not a number or too long.
+ */
+long long parse_number(std::string_view s, std::string_view group) {
+	if (s.empty() || s.size() > 18)
+		HLOP_ERR(hlop::format("invalid range number \"{}\" in [{}]", s, group));
+	long long v = 0;
+	for (char c : s) {
+		if (!is_digit(c))
+			HLOP_ERR(hlop::format("invalid range number \"{}\" in [{}]", s, group));
+		v = v * 10 + (c - '0');
+	}
+	return v;
+}
+
+/**
+ * @brief expand the ranges of a bracket group.
+ * @param prefix string_view, the host name prefix before the bracket.
+ * @param group string_view, the ranges inside the bracket, e.g., "03-04,06".
+ * @param names vector<string>, output, the expanded names are appended.
+ */
+void expand_group(std::string_view prefix, std::string_view group, std::vector<std::string> &names) {
+	std::string name{prefix};
+	std::size_t beg = 0;
+	while (beg <= group.size()) {
+		std::size_t end = group.find(',', beg);
+		if (end == std::string_view::npos)
+			end = group.size();
+		std::string_view token = group.substr(beg, end - beg);
+		beg = end + 1;
+
+		std::size_t dash = token.find('-');
+		if (dash == std::string_view::npos) {
+			parse_number(token, group);
+			name.resize(prefix.size());
+			name.append(token);
+			names.emplace_back(name);
+			continue;
+		}
+		std::string_view first = token.substr(0, dash);
+		long long lo = parse_number(first, group),
+		          hi = parse_number(token.substr(dash + 1), group);
+		if (lo > hi)
+			HLOP_ERR(hlop::format("invalid range \"{}\" in [{}]", token, group));
+		// write the digits in place, padded with zeros to the width of the start
+		char digits[24];
+		for (long long v = lo; v <= hi; ++v) {
+			int n = 0;
+			for (long long x = v; x > 0; x /= 10)
+				digits[n++] = '0' + x % 10;
+			name.resize(prefix.size());
+			if (n < static_cast<int>(first.size()))
+				name.append(first.size() - n, '0');
+			while (n > 0)
+				name.push_back(digits[--n]);
+			names.emplace_back(name);
+		}
+	}
+}
+} // namespace
+
+std::vector<std::string> hlop::expand_hostlist(std::string_view host_list) {
+	std::vector<std::string> names;
+	std::size_t i = 0;
+	const std::size_t n = host_list.size();
+	while (i < n) {
+		if (host_list[i] == ',') {
+			++i;
+			continue;
+		}
+		if (host_list[i] == '[' || host_list[i] == ']')
+			HLOP_ERR(hlop::format("unexpected '{}' at {} of host list", host_list[i], i));
+		std::size_t beg = i;
+		while (i < n && host_list[i] != ',' && host_list[i] != '[' && host_list[i] != ']')
+			++i;
+		std::string_view prefix = host_list.substr(beg, i - beg);
+		if (i == n || host_list[i] != '[') {
+			names.emplace_back(prefix);
+			continue;
+		}
+		std::size_t close = host_list.find(']', i);
+		if (close == std::string_view::npos)
+			HLOP_ERR(hlop::format("unclosed '[' at {} of host list", i));
+		expand_group(prefix, host_list.substr(i + 1, close - i - 1), names);
+		i = close + 1;
+	}
+	return names;
+}
+
+std::vector<std::string> hlop::parse_hostlist(std::string_view host_list) {
+	auto names = hlop::expand_hostlist(host_list);
+	std::unordered_set<std::string_view> seen;
+	seen.reserve(names.size());
+	for (const auto &name : names)
+		if (!seen.emplace(name).second)
+			HLOP_ERR(hlop::format("duplicate node name {}", name));
+	return names;
+}
+
+bool hlop::match_grouped_name(std::string_view name, int ngroup) {
+	std::size_t i = 0;
+	for (int g = 0; g < ngroup; ++g) {
+		if (i >= name.size() || !is_alpha(name[i]))
+			return false;
+		std::size_t digits = ++i;
+		while (i < name.size() && is_digit(name[i]))
+			++i;
+		if (i == digits)
+			return false;
+	}
+	return i == name.size();
+}
@@ -10,7 +10,7 @@ hlop::node::node(const std::string &node_str) : node_name(node_str) {}
 
 const std::string &hlop::node::name() const { return node_name; }
 
-void hlop::node::bind_core(int rank, int core) const {
+void hlop::node::bind_core(int rank, int core) {
 	if (core < 0 || core >= get_ncore_per_node())
 		HLOP_ERR(hlop::format("core {} is not in range [0, {}]", core, get_ncore_per_node() - 1));
 	if (rank_core_map.find(rank) != rank_core_map.end())
@@ -30,14 +30,15 @@ const int hlop::node::get_unit_id(int rank) const {
 }
 
 const int hlop::node::get_core_level(int rank1, int rank2) const {
-	int unit1 = get_unit_id(rank1),
-	    unit2 = get_unit_id(rank2);
-	for (int i = 1; i <= get_max_core_level(); ++i) {
-		if ((unit1 >> i) == (unit2 >> i))
-			return i - 1;
-	}
-	HLOP_ERR(hlop::format("undefined core level in node {} between {} and {}", name(), rank1, rank2));
-	return -1; // unreachable
+	return get_unit_level(get_unit_id(rank1), get_unit_id(rank2));
+}
+
+const int hlop::node::get_unit_level(int unit1, int unit2) const {
+	// the level is the highest bit in which the units differ, 0 for the same unit
+	int level = 31 - __builtin_clz(static_cast<unsigned>(unit1 ^ unit2) | 1u);
+	if (level >= get_max_core_level())
+		HLOP_ERR(hlop::format("undefined core level in node {} between unit {} and {}", name(), unit1, unit2));
+	return level;
 }
 
 std::ostream &hlop::operator<<(std::ostream &os, const node_t &n) {
@@ -1,14 +1,12 @@
-#include <algorithm>
 #include <cstddef>
-#include <iomanip>
 #include <memory>
 #include <regex>
-#include <sstream>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "err.h"
+#include "node/hostlist.h"
 #include "node/node.h"
 #include "node/th_node.h"
 
@@ -17,51 +15,10 @@ const std::regex hlop::th_node::NODE_REGEX{R"(([a-zA-Z]\d+)([a-zA-Z]\d+)([a-zA-Z
 
 const std::vector<hlop::const_node_ptr> hlop::th_node::parse_node_list(const std::string &node_list_str) {
 	std::vector<hlop::const_node_ptr> nodes;
-	auto node_names = parse_node_list_aux(node_list_str);
-	for (const auto &name : node_names) {
-		if (std::find_if(nodes.begin(), nodes.end(), [&](const auto &node) {
-			    return node->name() == name;
-		    }) != nodes.end())
-			HLOP_ERR(hlop::format("duplicate node name {}", name));
+	const auto node_names = hlop::parse_hostlist(node_list_str);
+	nodes.reserve(node_names.size());
+	for (const auto &name : node_names)
 		nodes.emplace_back(std::make_shared<const hlop::th_node>(name));
-	}
-	return nodes;
-}
-
-const std::vector<std::string> hlop::th_node::parse_node_list_aux(const std::string &node_list_str) {
-	std::vector<std::string> nodes;
-	auto beg = std::sregex_iterator(node_list_str.begin(), node_list_str.end(),
-	                                hlop::th_node::NODE_LIST_REGEX);
-	auto end = std::sregex_iterator();
-
-	for (auto it = beg; it != end; ++it) {
-		std::string group = it->str();
-		std::smatch match;
-		std::regex range_re(R"((.*)\[(.*)\])");
-		if (!std::regex_match(group, match, range_re)) {
-			nodes.emplace_back(group);
-			continue;
-		}
-		std::string prefix = match[1];
-		std::string ranges = match[2];
-		std::stringstream ss{ranges};
-		std::string token;
-		while (std::getline(ss, token, ',')) {
-			std::size_t dash = token.find('-');
-			if (dash == std::string::npos) {
-				nodes.emplace_back(prefix + token);
-				continue;
-			}
-			int start = std::stoi(token.substr(0, dash));
-			int end = std::stoi(token.substr(dash + 1));
-			int width = token.substr(0, dash).size();
-			for (int i = start; i <= end; ++i) {
-				std::ostringstream oss;
-				oss << prefix << std::setw(width) << std::setfill('0') << i;
-				nodes.emplace_back(oss.str());
-			}
-		}
-	}
 	return nodes;
 }
 
@@ -70,7 +27,7 @@ hlop::th_node::th_node(const std::string &node_str)
       node_levels{std::string_view{node_name.c_str(), hlop::th_node::TOP_LEVEL_IDX},
                   std::string_view{node_name.c_str(), hlop::th_node::MID_LEVEL_IDX},
                   std::string_view{node_name.c_str(), hlop::th_node::BOTTOM_LEVEL_IDX}} {
-	if (!std::regex_match(node_name, hlop::th_node::NODE_REGEX))
+	if (!hlop::match_grouped_name(node_name, NAME_GROUP_NUM))
 		HLOP_ERR(hlop::format("invalid node format {}", node_name));
 }
 
@@ -138,3 +95,9 @@ const int hlop::th_node::get_ncore_per_unit() const {
 const std::regex &hlop::th_node::get_node_regex() const {
 	return hlop::th_node::NODE_REGEX;
 }
+
+const std::string_view hlop::th_node::get_level_name(int level) const {
+	if (level < 0 || level >= get_max_node_level())
+		HLOP_ERR(hlop::format("level {} is not in range [0, {})", level, get_max_node_level()));
+	return node_levels[level];
+}
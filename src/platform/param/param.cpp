@@ -1,9 +1,22 @@
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -11,11 +24,42 @@
 #include "aux.h"
 #include "err.h"
 #include "fit.h"
+#include "interp.h"
 #include "m_debug.h"
 #include "msg.h"
 #include "param/param.h"
+#include "param/param_format.h"
 
-hlop::param::param(const std::string &resources_file) { load_params(resources_file); }
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::link_class_t &lc) {
+	os << hlop::enum_name(lc);
+	return os;
+}
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::param_key_t &key) {
+	os << key.cls << "_" << key.level << "_" << key.contention;
+	return os;
+}
+
+hlop::param::param(const std::string &resources_file)
+    : nlevel{0}, ncontention{0}, nslot{0}, mode{hlop::interp_mode::EXPONENTIAL}, grid_step{0.0}, source{0},
+      values{nullptr}, curves{nullptr}, tangents{nullptr}, present{nullptr}, coefs{nullptr} {
+	if (is_binary(resources_file)) {
+		load_binary(resources_file);
+	} else {
+		load_params(resources_file);
+		source = source_hash(resources_file);
+		build_interp_tables();
+		const auto &ff = fit_file(resources_file);
+		if (std::ifstream{ff}.is_open())
+			load_fit(ff, hash_file(resources_file));
+	}
+	grid_step = calc_grid_step();
+}
+
+hlop::param::param(const std::string &resources_file, hlop::interp_mode_t mode)
+    : param{resources_file} {
+	this->mode = mode;
+}
 
 void hlop::param::load_params(const std::string &resources_file) {
 	std::ifstream fin{resources_file};
@@ -32,18 +76,330 @@ void hlop::param::load_params(const std::string &resources_file) {
 	for (auto &m : msg_size_pow)
 		m = static_cast<int>(std::log2(m));
 
+	// read all categories first, the table shape depends on the largest level and contention
+	std::vector<std::pair<std::string, std::vector<double>>> rows;
 	while (std::getline(fin, line)) {
 		std::stringstream ss{line};
 		std::string param_category;
 		if (!std::getline(ss, param_category, ','))
 			HLOP_ERR(hlop::format("invalid line format in resources file: {}", resources_file));
-		params.emplace(param_category, hlop::stov<double>(line, 1));
+		auto ps = hlop::stov<double>(line, 1);
+		if (ps.size() != msg_size_pow.size())
+			HLOP_ERR(hlop::format("category {} has {} values, expect {} in resources file: {}",
+			                      param_category, ps.size(), msg_size_pow.size(), resources_file));
+		rows.emplace_back(std::move(param_category), std::move(ps));
+	}
+
+	nlevel = 0;
+	ncontention = 0;
+	int nother = 0;
+	hlop::param_key_t key;
+	for (const auto &r : rows) {
+		if (parse_category(r.first, key)) {
+			nlevel = std::max(nlevel, key.level + 1);
+			ncontention = std::max(ncontention, key.contention);
+		} else {
+			++nother;
+		}
+	}
+
+	const int ntable = 2 * nlevel * ncontention;
+	const std::size_t nbucket = msg_size_pow.size();
+	nslot = ntable + nother;
+	owned_values.assign(nslot * nbucket, 0.0);
+	owned_present.assign(nslot, 0);
+	fitted.reset(new fitted_curve[nslot]);
+
+	int next_other = ntable;
+	for (auto &r : rows) {
+		// the first line of a duplicated category wins
+		if (slots.find(r.first) != slots.end())
+			continue;
+		int slot = next_other;
+		if (parse_category(r.first, key))
+			slot = (static_cast<int>(key.cls) * nlevel + key.level) * ncontention + key.contention - 1;
+		else
+			++next_other;
+		owned_present[slot] = hlop::param_format::SLOT_PRESENT;
+		std::copy(r.second.begin(), r.second.end(), owned_values.begin() + slot * nbucket);
+		slots.emplace(std::move(r.first), slot);
+	}
+	values = owned_values.data();
+	present = owned_present.data();
+}
+
+void hlop::param::load_fit(const std::string &fit_file, std::uint64_t csv_hash) {
+	std::ifstream fin{fit_file};
+	if (!fin.is_open())
+		HLOP_ERR(hlop::format("failed to open fit file: {}", fit_file));
+
+	// first line, "#source,<hash_file of the csv>", a fit file of another csv is ignored
+	std::string line;
+	std::getline(fin, line);
+	const std::string tag = hlop::format("{}{}", FIT_SOURCE_TAG, csv_hash);
+	if (line != tag) {
+		std::cerr << hlop::format("[WARN] {} is not fitted from its csv as it is now, it is ignored, "
+		                          "run hlop_param_fit again",
+		                          fit_file)
+		          << std::endl;
+		return;
+	}
+	// skip second line, "category,A,B,C,rmse,max_rel_err,iterations"
+	std::getline(fin, line);
+	owned_coefs.assign(nslot, hlop::param_bin_coef_t{{0.0, 0.0, 0.0}, 0});
+	while (std::getline(fin, line)) {
+		std::stringstream ss{line};
+		std::string param_category;
+		if (!std::getline(ss, param_category, ','))
+			continue;
+		auto cs = hlop::stov<double>(line, 1);
+		if (cs.size() < 3)
+			HLOP_ERR(hlop::format("invalid line format in fit file {}: {}", fit_file, line));
+		int slot = get_slot(param_category);
+		if (slot < 0)
+			continue;
+		owned_coefs[slot] = hlop::param_bin_coef_t{{cs[0], cs[1], cs[2]}, 1};
+	}
+	coefs = owned_coefs.data();
+}
+
+void hlop::param::build_interp_tables() {
+	const std::size_t nbucket = msg_size_pow.size();
+	owned_curves.assign(nslot * nbucket, 0.0);
+	owned_tangents.assign(nslot * nbucket, 0.0);
+	for (int i = 0; i < nslot; ++i) {
+		if (!present[i])
+			continue;
+		const double *ps = values + i * nbucket;
+		double *cs = owned_curves.data() + i * nbucket;
+		// interpolate in log space when possible, a curve with non-positive values stays linear
+		bool positive = std::all_of(ps, ps + nbucket, [](double v) { return v > 0.0; });
+		if (positive) {
+			owned_present[i] |= hlop::param_format::SLOT_LOG;
+			std::transform(ps, ps + nbucket, cs, [](double v) { return std::log(v); });
+		} else {
+			std::copy(ps, ps + nbucket, cs);
+		}
+		if (nbucket >= 2)
+			hlop::monotone_tangents(msg_size_pow.data(), cs, nbucket, owned_tangents.data() + i * nbucket);
+	}
+	curves = owned_curves.data();
+	tangents = owned_tangents.data();
+}
+
+double hlop::param::calc_grid_step() const {
+	const std::size_t nbucket = msg_size_pow.size();
+	if (nbucket < 2)
+		return 0.0;
+	double step = msg_size_pow[1] - msg_size_pow[0];
+	for (std::size_t i = 1; i < nbucket; ++i)
+		if (msg_size_pow[i] - msg_size_pow[i - 1] != step)
+			return 0.0;
+	return step > 0.0 ? step : 0.0;
+}
+
+void hlop::param::load_binary(const std::string &resources_file) {
+	int fd = ::open(resources_file.c_str(), O_RDONLY);
+	if (fd < 0)
+		HLOP_ERR(hlop::format("failed to open resources file: {}", resources_file));
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(hlop::param_bin_header_t))) {
+		::close(fd);
+		HLOP_ERR(hlop::format("invalid binary resources file: {}", resources_file));
+	}
+	const std::size_t size = st.st_size;
+	void *addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED)
+		HLOP_ERR(hlop::format("failed to map resources file {}: {}", resources_file, std::strerror(errno)));
+	mapping = std::shared_ptr<const void>(addr, [size](const void *p) { ::munmap(const_cast<void *>(p), size); });
+
+	const char *base = static_cast<const char *>(addr);
+	const auto *h = reinterpret_cast<const hlop::param_bin_header_t *>(base);
+	if (std::memcmp(h->magic, hlop::param_format::MAGIC, sizeof(h->magic)) != 0)
+		HLOP_ERR(hlop::format("invalid binary resources file: {}", resources_file));
+	if (h->version != hlop::param_format::VERSION)
+		HLOP_ERR(hlop::format("unsupported binary resources version {} (expect {}): {}",
+		                      h->version, hlop::param_format::VERSION, resources_file));
+	if (h->endian_mark != hlop::param_format::ENDIAN_MARK)
+		HLOP_ERR(hlop::format("binary resources file written with another byte order: {}", resources_file));
+	if (h->interp < static_cast<std::int32_t>(hlop::interp_mode::EXPONENTIAL) ||
+	    h->interp > static_cast<std::int32_t>(hlop::interp_mode::MONOTONE_CUBIC))
+		HLOP_ERR(hlop::format("invalid interpolation mode {} in binary resources file: {}", h->interp, resources_file));
+	const std::size_t nbucket = h->nbucket;
+	if (h->file_size != size || h->nbucket <= 0 || h->nslot < 2 * h->nlevel * h->ncontention ||
+	    h->axes_offset + nbucket * sizeof(double) > size ||
+	    h->present_offset + h->nslot > size ||
+	    h->values_offset + h->nslot * nbucket * sizeof(double) > size ||
+	    h->curves_offset + h->nslot * nbucket * sizeof(double) > size ||
+	    h->tangents_offset + h->nslot * nbucket * sizeof(double) > size ||
+	    h->coefs_offset + h->nslot * sizeof(hlop::param_bin_coef_t) > size ||
+	    h->names_offset > size)
+		HLOP_ERR(hlop::format("truncated binary resources file: {}", resources_file));
+
+	nlevel = h->nlevel;
+	ncontention = h->ncontention;
+	nslot = h->nslot;
+	mode = static_cast<hlop::interp_mode_t>(h->interp);
+	source = h->source_hash;
+	const auto *axes = reinterpret_cast<const double *>(base + h->axes_offset);
+	msg_size_pow.assign(axes, axes + nbucket);
+	present = base + h->present_offset;
+	values = reinterpret_cast<const double *>(base + h->values_offset);
+	curves = reinterpret_cast<const double *>(base + h->curves_offset);
+	tangents = reinterpret_cast<const double *>(base + h->tangents_offset);
+	coefs = reinterpret_cast<const hlop::param_bin_coef_t *>(base + h->coefs_offset);
+	fitted.reset(new fitted_curve[nslot]);
+
+	const char *p = base + h->names_offset, *end = base + size;
+	while (p + 2 * sizeof(std::int32_t) <= end) {
+		std::int32_t slot;
+		std::uint32_t len;
+		std::memcpy(&slot, p, sizeof(slot));
+		std::memcpy(&len, p + sizeof(slot), sizeof(len));
+		p += sizeof(slot) + sizeof(len);
+		if (slot < 0 || slot >= nslot || p + len > end)
+			HLOP_ERR(hlop::format("invalid category name table in binary resources file: {}", resources_file));
+		slots.emplace(std::string{p, len}, slot);
+		p += (len + 7) / 8 * 8;
+	}
+}
+
+bool hlop::param::is_binary(const std::string &resources_file) {
+	std::ifstream fin{resources_file, std::ios::binary};
+	char magic[sizeof(hlop::param_format::MAGIC)];
+	if (!fin.read(magic, sizeof(magic)))
+		return false;
+	return std::memcmp(magic, hlop::param_format::MAGIC, sizeof(magic)) == 0;
+}
+
+bool hlop::param::is_compiled_from(const std::string &bin_file, const std::string &csv_file) {
+	std::ifstream fin{bin_file, std::ios::binary};
+	hlop::param_bin_header_t h;
+	if (!fin.read(reinterpret_cast<char *>(&h), sizeof(h)) ||
+	    std::memcmp(h.magic, hlop::param_format::MAGIC, sizeof(h.magic)) != 0 ||
+	    h.version != hlop::param_format::VERSION)
+		return false;
+	// a binary file installed without its csv has nothing to be stale against
+	if (!std::ifstream{csv_file}.is_open())
+		return true;
+	return h.source_hash == source_hash(csv_file);
+}
+
+const std::string hlop::param::choose_file(const std::string &bin_file, const std::string &csv_file) {
+	if (!is_binary(bin_file))
+		return csv_file;
+	if (is_compiled_from(bin_file, csv_file))
+		return bin_file;
+	std::cerr << hlop::format("[WARN] {} is not compiled from {} as it is now, the csv is loaded instead", bin_file,
+	                          csv_file)
+	          << std::endl;
+	return csv_file;
+}
+
+std::uint64_t hlop::param::hash_file(const std::string &path) {
+	std::ifstream fin{path, std::ios::binary};
+	if (!fin.is_open())
+		return 0;
+	std::uint64_t h = 14695981039346656037ull;
+	char buf[65536];
+	while (fin.read(buf, sizeof(buf)) || fin.gcount() > 0)
+		for (std::streamsize i = 0; i < fin.gcount(); ++i) {
+			h ^= static_cast<unsigned char>(buf[i]);
+			h *= 1099511628211ull;
+		}
+	return h;
+}
+
+std::uint64_t hlop::param::source_hash(const std::string &resources_file) {
+	// the fitted curves of the fit file are compiled in as well
+	const std::uint64_t h = hash_file(resources_file);
+	return (h ^ hash_file(fit_file(resources_file))) * 1099511628211ull + h;
+}
+
+int hlop::param::save(const std::string &bin_file) const {
+	const std::size_t nbucket = msg_size_pow.size();
+	auto align = [](std::uint64_t off) -> std::uint64_t { return (off + 7) / 8 * 8; };
+
+	// fit every category in advance, so that the runtime never fits anything
+	std::vector<hlop::param_bin_coef_t> cs(nslot, hlop::param_bin_coef_t{{0.0, 0.0, 0.0}, 0});
+	int nfailed = 0;
+	for (int i = 0; i < nslot; ++i) {
+		if (!present[i])
+			continue;
+		try {
+			cs[i].coef = get_fitted(i);
+			cs[i].valid = 1;
+		} catch (const std::exception &e) {
+			++nfailed;
+		}
+	}
+
+	hlop::param_bin_header_t h;
+	std::memset(&h, 0, sizeof(h));
+	std::memcpy(h.magic, hlop::param_format::MAGIC, sizeof(h.magic));
+	h.version = hlop::param_format::VERSION;
+	h.endian_mark = hlop::param_format::ENDIAN_MARK;
+	h.nbucket = nbucket;
+	h.nlevel = nlevel;
+	h.ncontention = ncontention;
+	h.nslot = nslot;
+	h.interp = static_cast<std::int32_t>(mode);
+	h.source_hash = source;
+	h.axes_offset = align(sizeof(h));
+	h.present_offset = align(h.axes_offset + nbucket * sizeof(double));
+	h.values_offset = align(h.present_offset + nslot);
+	h.curves_offset = align(h.values_offset + nslot * nbucket * sizeof(double));
+	h.tangents_offset = align(h.curves_offset + nslot * nbucket * sizeof(double));
+	h.coefs_offset = align(h.tangents_offset + nslot * nbucket * sizeof(double));
+	h.names_offset = align(h.coefs_offset + nslot * sizeof(hlop::param_bin_coef_t));
+
+	std::string names;
+	for (const auto &s : slots) {
+		std::int32_t slot = s.second;
+		std::uint32_t len = s.first.size();
+		names.append(reinterpret_cast<const char *>(&slot), sizeof(slot));
+		names.append(reinterpret_cast<const char *>(&len), sizeof(len));
+		names.append(s.first);
+		names.resize(align(names.size()), '\0');
 	}
+	h.file_size = h.names_offset + names.size();
+
+	std::string image(h.file_size, '\0');
+	std::memcpy(&image[0], &h, sizeof(h));
+	std::memcpy(&image[h.axes_offset], msg_size_pow.data(), nbucket * sizeof(double));
+	std::memcpy(&image[h.present_offset], present, nslot);
+	std::memcpy(&image[h.values_offset], values, nslot * nbucket * sizeof(double));
+	std::memcpy(&image[h.curves_offset], curves, nslot * nbucket * sizeof(double));
+	std::memcpy(&image[h.tangents_offset], tangents, nslot * nbucket * sizeof(double));
+	std::memcpy(&image[h.coefs_offset], cs.data(), nslot * sizeof(hlop::param_bin_coef_t));
+	std::memcpy(&image[h.names_offset], names.data(), names.size());
+
+	// write to a temporary file and rename it, readers never map a partially written file
+	const std::string tmp_file = bin_file + ".tmp";
+	std::ofstream fout{tmp_file, std::ios::binary | std::ios::trunc};
+	if (!fout.is_open())
+		HLOP_ERR(hlop::format("failed to open binary resources file: {}", tmp_file));
+	fout.write(image.data(), image.size());
+	fout.close();
+	if (!fout)
+		HLOP_ERR(hlop::format("failed to write binary resources file: {}", tmp_file));
+	if (std::rename(tmp_file.c_str(), bin_file.c_str()) != 0)
+		HLOP_ERR(hlop::format("failed to rename {} to {}", tmp_file, bin_file));
+	return nfailed;
+}
+
+const std::string hlop::param::fit_source_line(const std::string &resources_file) {
+	return hlop::format("{}{}", FIT_SOURCE_TAG, hash_file(resources_file));
+}
+
+const std::string hlop::param::fit_file(const std::string &resources_file) {
+	return resources_file + ".fit";
 }
 
 const std::vector<std::string_view> hlop::param::get_categorys() const {
 	std::vector<std::string_view> categories;
-	for (const auto &pair : params)
+	for (const auto &pair : slots)
 		categories.emplace_back(pair.first);
 
 	return categories;
@@ -51,39 +407,181 @@ const std::vector<std::string_view> hlop::param::get_categorys() const {
 
 const std::vector<double> &hlop::param::get_msg_size_range() const { return msg_size_pow; }
 
+hlop::interp_mode_t hlop::param::get_interp_mode() const { return mode; }
+
+const std::vector<double> hlop::param::get_category_params(const std::string &param_category) const {
+	int slot = get_slot(param_category);
+	if (slot < 0)
+		HLOP_ERR(hlop::format("parameter category not found: {}", param_category));
+	const double *ps = get_params(slot);
+	return {ps, ps + msg_size_pow.size()};
+}
+
 bool hlop::param::has_category(const std::string &param_category) const {
-	const auto &it = params.find(param_category);
-	if (it == params.end())
-		return false;
-	return true;
+	return get_slot(param_category) >= 0;
+}
+
+bool hlop::param::has_category(const hlop::param_key_t &key) const {
+	return get_slot(key) >= 0;
 }
 
 const double hlop::param::get_param(int msg_size, const std::string &param_category) const {
-	const auto &ps = get_params(param_category);
+	int slot = get_slot(param_category);
+	if (slot < 0)
+		HLOP_ERR(hlop::format("parameter category not found: {}", param_category));
+	double p = get_param_by_slot(msg_size, slot);
+	INFO("{}: {}", param_category, p);
+	return p;
+}
+
+const double hlop::param::get_param(int msg_size, const hlop::param_key_t &key) const {
+	int slot = get_slot(key);
+	if (slot < 0)
+		HLOP_ERR(hlop::format("parameter category not found: {}", key));
+	double p = get_param_by_slot(msg_size, slot);
+	INFO("{}: {}", key, p);
+	return p;
+}
+
+void hlop::param::get_param_batch(const int *msg_sizes, std::size_t n,
+                                  const std::string &param_category, double *out) const {
+	int slot = get_slot(param_category);
+	if (slot < 0)
+		HLOP_ERR(hlop::format("parameter category not found: {}", param_category));
+	get_param_batch_by_slot(msg_sizes, n, slot, out);
+	INFO("{}: {}", param_category, hlop::vtos(std::vector<double>(out, out + n)));
+}
+
+void hlop::param::get_param_batch(const int *msg_sizes, std::size_t n,
+                                  const hlop::param_key_t &key, double *out) const {
+	int slot = get_slot(key);
+	if (slot < 0)
+		HLOP_ERR(hlop::format("parameter category not found: {}", key));
+	get_param_batch_by_slot(msg_sizes, n, slot, out);
+	INFO("{}: {}", key, hlop::vtos(std::vector<double>(out, out + n)));
+}
+
+int hlop::param::get_slot(const hlop::param_key_t &key) const {
+	if (key.level < 0 || key.level >= nlevel || key.contention < 1 || key.contention > ncontention)
+		return -1;
+	int slot = (static_cast<int>(key.cls) * nlevel + key.level) * ncontention + key.contention - 1;
+	return present[slot] ? slot : -1;
+}
+
+int hlop::param::get_slot(const std::string &param_category) const {
+	const auto &it = slots.find(param_category);
+	if (it == slots.end())
+		return -1;
+	return it->second;
+}
+
+const double hlop::param::get_param_by_slot(int msg_size, int slot) const {
+	if (msg_size <= 0)
+		HLOP_ERR(hlop::format("require msg_size(={}) > 0", msg_size));
+	const auto *ps = get_params(slot);
 
 	double e = std::log2(msg_size);
 	int idx = static_cast<int>(e);
-	if (hlop::is_pof2(msg_size) && idx < msg_size_pow.size()) {
-		INFO("{}: {}", param_category, ps[idx]);
+	if (hlop::is_pof2(msg_size) && idx < msg_size_pow.size())
 		return ps[idx];
+	if (mode == hlop::interp_mode::EXPONENTIAL || msg_size_pow.size() < 2)
+		return hlop::exp_fit_func_2(e, get_fitted(slot));
+	return interpolate(e, slot);
+}
+
+void hlop::param::get_param_batch_by_slot(const int *msg_sizes, std::size_t n, int slot, double *out) const {
+	const std::size_t nbucket = msg_size_pow.size();
+	const double *ps = get_params(slot);
+
+	// out holds log2 of the message sizes first, then it is transformed in place
+	std::size_t noff_grid = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		const int m = msg_sizes[i];
+		if (m <= 0)
+			HLOP_ERR(hlop::format("require msg_size(={}) > 0", m));
+		out[i] = std::log2(m);
+		noff_grid += ((m & (m - 1)) != 0 || static_cast<std::size_t>(out[i]) >= nbucket);
+	}
+
+	if (noff_grid > 0) {
+		if (mode == hlop::interp_mode::EXPONENTIAL || nbucket < 2) {
+			const auto &c = get_fitted(slot);
+			const double A = c.A, B = c.B, C = c.C;
+			for (std::size_t i = 0; i < n; ++i)
+				out[i] = A * std::exp(-B * out[i]) + C;
+		} else {
+			const double *x = msg_size_pow.data(),
+			             *cs = curves + slot * nbucket;
+			if (mode == hlop::interp_mode::MONOTONE_CUBIC)
+				hlop::interp_monotone_cubic(x, cs, tangents + slot * nbucket, nbucket, grid_step, out, out, n);
+			else
+				hlop::interp_linear(x, cs, nbucket, grid_step, out, out, n);
+			if (present[slot] & hlop::param_format::SLOT_LOG)
+				for (std::size_t i = 0; i < n; ++i)
+					out[i] = std::exp(out[i]);
+		}
+	}
+
+	// measured values of the grid win over the curve
+	for (std::size_t i = 0; i < n; ++i) {
+		const int m = msg_sizes[i];
+		const std::size_t idx = std::ilogb(m);
+		if ((m & (m - 1)) == 0 && idx < nbucket)
+			out[i] = ps[idx];
 	}
-	double p = fit(ps)(e);
-	INFO("{}: {}", param_category, p);
-	return p;
 }
 
-const std::vector<double> &hlop::param::get_params(const std::string &param_category) const {
-	if (!has_category(param_category))
-		HLOP_ERR(hlop::format("parameter category not found: {}", param_category));
+const double hlop::param::interpolate(double e, int slot) const {
+	const std::size_t nbucket = msg_size_pow.size();
+	const double *x = msg_size_pow.data(),
+	             *cs = curves + slot * nbucket;
+	double v = mode == hlop::interp_mode::MONOTONE_CUBIC
+	               ? hlop::interp_monotone_cubic(x, cs, tangents + slot * nbucket, nbucket, grid_step, e)
+	               : hlop::interp_linear(x, cs, nbucket, grid_step, e);
+	return (present[slot] & hlop::param_format::SLOT_LOG) ? std::exp(v) : v;
+}
 
-	const auto &it = params.find(param_category);
-	DEBUG("{}: {}", it->first, hlop::vtos(it->second));
-	return it->second;
+const double *hlop::param::get_params(int slot) const {
+	const double *ps = values + slot * msg_size_pow.size();
+	DEBUG("slot {}: {}", slot, hlop::vtos(std::vector<double>(ps, ps + msg_size_pow.size())));
+	return ps;
 }
 
-std::function<double(double)> hlop::param::fit(const std::vector<double> &y) const {
-	auto p = hlop::curve_fit_exponential(msg_size_pow, y, {0, 0, y[0]});
-	return [=](double x) -> double {
-		return hlop::exp_fit_func_2(x, p);
-	};
-}
\ No newline at end of file
+const hlop::exponential_params_t &hlop::param::get_fitted(int slot) const {
+	if (coefs != nullptr && coefs[slot].valid)
+		return coefs[slot].coef;
+	const auto &f = fitted[slot];
+	// fit lazily, concurrent readers wait for the first one, a failed fit is retried by the next call
+	std::call_once(f.once, [&]() {
+		const auto *ps = get_params(slot);
+		f.coef = fit({ps, ps + msg_size_pow.size()});
+	});
+	return f.coef;
+}
+
+hlop::exponential_params_t hlop::param::fit(const std::vector<double> &y) const {
+	return hlop::curve_fit_exponential(msg_size_pow, y, {0, 0, y[0]});
+}
+
+bool hlop::param::parse_category(const std::string &param_category, hlop::param_key_t &key) {
+	// "L<class>_<level>_<contention>", e.g. "L1_2_17"
+	const char *p = param_category.c_str();
+	if (p[0] != 'L' || (p[1] != '0' && p[1] != '1') || p[2] != '_')
+		return false;
+	key.cls = p[1] == '0' ? hlop::link_class::L0 : hlop::link_class::L1;
+	p += 3;
+	int fields[2] = {0, 0};
+	for (int i = 0; i < 2; ++i) {
+		if (*p < '0' || *p > '9')
+			return false;
+		while (*p >= '0' && *p <= '9')
+			fields[i] = fields[i] * 10 + (*p++ - '0');
+		if (i == 0 && *p++ != '_')
+			return false;
+	}
+	if (*p != '\0' || fields[1] < 1)
+		return false;
+	key.level = fields[0];
+	key.contention = fields[1];
+	return true;
+}
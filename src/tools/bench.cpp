@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "aux.h"
+#include "bcast.h"
+#include "collective.h"
+#include "err.h"
+#include "factory.h"
+#include "gflags/gflags.h"
+#include "msg.h"
+#include "node/hostlist.h"
+#include "param/param.h"
+#include "platform.h"
+#include "struct/comm_round.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+DEFINE_string(filter, "", "regex of the benchmarks to run, all of them by default");
+DEFINE_double(min_time, 0.5, "minimum seconds of each benchmark, a slower operation runs once");
+DEFINE_string(out, "", "output json file, stdout by default");
+DEFINE_string(interp, "", "interpolation mode of off-grid message sizes, EXPONENTIAL, LOG_LINEAR or MONOTONE_CUBIC, "
+                          "the mode of the parameter file by default");
+DEFINE_bool(list, false, "list the benchmarks without running them");
+
+namespace {
+std::atomic<std::uint64_t> alloc_count{0};
+std::atomic<std::uint64_t> alloc_bytes{0};
+} // namespace
+
+// every allocation of the process is counted, the benchmarks run one at a time in the main thread
+void *operator new(std::size_t n) {
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+	if (void *p = std::malloc(n == 0 ? 1 : n))
+		return p;
+	throw std::bad_alloc();
+}
+void *operator new[](std::size_t n) { return ::operator new(n); }
+void *operator new(std::size_t n, std::align_val_t al) {
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+	const std::size_t a = static_cast<std::size_t>(al);
+	if (void *p = std::aligned_alloc(a, (std::max<std::size_t>(n, 1) + a - 1) / a * a))
+		return p;
+	throw std::bad_alloc();
+}
+void *operator new[](std::size_t n, std::align_val_t al) { return ::operator new(n, al); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+const hlop::arrangement_t arrange{.node_arrange = hlop::rank_arrangement::BLOCK,
+                                  .core_arrange = hlop::rank_arrangement::BLOCK};
+
+/// @brief nodes of a rack and racks of a group of the synthetic DF host lists.
+constexpr int RACK_NODES = 32;
+constexpr int GROUP_RACKS = 4;
+
+/**
+ * @brief a collective that exposes its round costing and parameters to the benchmarks.
+ */
+struct bench_bcast : public hlop::bcast {
+	using hlop::collective::calc_cost;
+	using hlop::collective::hlop_param_lat;
+};
+
+/**
+ * @brief struct benchmark result, the counters are per operation.
+ */
+struct result {
+	std::string name;
+	long long iterations;
+	double ns_per_op;
+	double allocs_per_op;
+	double bytes_per_op;
+	long peak_rss_kb;
+};
+
+/**
+ * @brief struct benchmark, setup runs once and returns the timed operation, which keeps its state.
+ */
+struct benchmark {
+	std::string name;
+	std::function<std::function<void()>()> setup;
+};
+
+/// @brief keep a value the optimizer could otherwise drop.
+template <typename T>
+void keep(const T &v) {
+	asm volatile("" : : "g"(&v) : "memory");
+}
+
+/**
+ * @brief a synthetic DF host list, the same for every run.
+ * @param nodes int, the number of nodes, in racks of RACK_NODES and groups of GROUP_RACKS racks from i10r1n01.
+ * @return string, the compressed host list, one range of each rack, e.g., "i10r1n[01-32],i10r2n[01-08]".
+ */
+std::string df_hostlist(int nodes) {
+	std::string res;
+	for (int first = 0; first < nodes; first += RACK_NODES) {
+		const int rack = first / RACK_NODES;
+		const int last = std::min(first + RACK_NODES, nodes) - first;
+		res += hlop::format("{}i{}r{}n[01-{}{}]", first == 0 ? "" : ",", 10 + rack / GROUP_RACKS,
+		                    1 + rack % GROUP_RACKS, last < 10 ? "0" : "", last);
+	}
+	return res;
+}
+
+/// @brief reset the peak resident set of the process to its current one, false if the kernel cannot.
+bool reset_peak_rss() {
+	std::ofstream f{"/proc/self/clear_refs"};
+	return static_cast<bool>(f << "5" << std::flush);
+}
+
+/// @brief get the peak resident set of the process in KiB.
+long peak_rss_kb() {
+	std::ifstream f{"/proc/self/status"};
+	std::string line;
+	while (std::getline(f, line))
+		if (line.rfind("VmHWM:", 0) == 0)
+			return std::atol(line.c_str() + 6);
+	struct rusage ru;
+	::getrusage(RUSAGE_SELF, &ru);
+	return ru.ru_maxrss;
+}
+
+/**
+ * @brief run a benchmark until it took FLAGS_min_time, in batches doubling from one operation.
+ * @note The first operation warms up, the parameters are loaded and the caches are filled before the clock starts.
+ * The peak resident set is the one of the process while the benchmark runs, including its setup,
+ * the process peak if the kernel cannot reset it.
+ */
+result run(const benchmark &b) {
+	reset_peak_rss();
+	const auto op = b.setup();
+	op();
+	const std::uint64_t count0 = alloc_count.load(), bytes0 = alloc_bytes.load();
+	const auto min_time = std::chrono::duration<double>(FLAGS_min_time);
+	std::chrono::steady_clock::duration elapsed{0};
+	long long iterations = 0;
+	for (long long batch = 1; iterations == 0 || elapsed < min_time; batch *= 2) {
+		const auto start = std::chrono::steady_clock::now();
+		for (long long i = 0; i < batch; ++i)
+			op();
+		elapsed += std::chrono::steady_clock::now() - start;
+		iterations += batch;
+	}
+	const double n = static_cast<double>(iterations);
+	return result{b.name,
+	              iterations,
+	              std::chrono::duration<double, std::nano>(elapsed).count() / n,
+	              (alloc_count.load() - count0) / n,
+	              (alloc_bytes.load() - bytes0) / n,
+	              peak_rss_kb()};
+}
+
+/**
+ * @brief the benchmarks of the predictor, in the order they run.
+ * The names are stable, results of two commits are compared by name.
+ */
+std::vector<benchmark> make_benchmarks() {
+	std::vector<benchmark> res;
+
+	// host lists, one range of each rack
+	for (const int nodes : {10, 100, 1000, 10000}) {
+		res.push_back({hlop::format("hostlist/expand/nodes:{}", nodes), [nodes]() {
+			               return [list = df_hostlist(nodes)]() { keep(hlop::expand_hostlist(list)); };
+		               }});
+		res.push_back({hlop::format("hostlist/parse/nodes:{}", nodes), [nodes]() {
+			               return [list = df_hostlist(nodes)]() { keep(hlop::parse_hostlist(list)); };
+		               }});
+	}
+
+	// node lists of 16 processes per node
+	for (const int nodes : {64, 1024, 16384, 65536})
+		res.push_back({hlop::format("node_list/construct/ranks:{}", nodes * 16), [nodes]() {
+			               return [list = df_hostlist(nodes)]() {
+				               const hlop::node_list_t nl{hlop::platform::DF, list, 16, arrange};
+				               keep(nl);
+			               };
+		               }});
+
+	// parameters of the first category of the latency file, on the message size grid and between its points
+	for (const bool on_grid : {true, false})
+		res.push_back({hlop::format("param/get_param/{}", on_grid ? "on_grid" : "off_grid"), [on_grid]() {
+			               const auto &p = bench_bcast::hlop_param_lat();
+			               hlop::param_key_t key;
+			               bool found = false;
+			               for (const auto category : p.get_categorys())
+				               if ((found = hlop::param::parse_category(std::string{category}, key)))
+					               break;
+			               if (!found)
+				               HLOP_ERR("no parameter category of the latency file can be parsed");
+			               std::vector<int> sizes;
+			               for (const double e : p.get_msg_size_range()) {
+				               const int size = 1 << static_cast<int>(e);
+				               sizes.push_back(on_grid ? size : size + size / 2);
+			               }
+			               if (!on_grid)
+				               sizes.pop_back();
+			               return [&p, key, sizes, i = std::size_t{0}]() mutable {
+				               keep(p.get_param(sizes[i], key));
+				               i = i + 1 == sizes.size() ? 0 : i + 1;
+			               };
+		               }});
+
+	// the widest round of a binomial tree over all ranks, its contentions and its cost
+	for (const int nodes : {64, 1024, 16384}) {
+		const auto round = [nodes]() {
+			auto nl = std::make_shared<const hlop::node_list_t>(hlop::platform::DF, df_hostlist(nodes), 16, arrange);
+			auto r = std::make_shared<hlop::comm_round_t>();
+			const int ranks = nl->get_rank_num();
+			for (int src = 0; src < ranks / 2; ++src)
+				r->add(*nl, src, src + ranks / 2);
+			return std::make_pair(nl, r);
+		};
+		res.push_back({hlop::format("round/count_contentions/ranks:{}", nodes * 16), [round]() {
+			               return [state = round()]() { keep(state.second->count_contentions(*state.first)); };
+		               }});
+		for (const bool cached : {true, false})
+			res.push_back({hlop::format("round/calc_cost{}/ranks:{}", cached ? "" : "_uncached", nodes * 16),
+			               [round, cached]() {
+				               if (!cached)
+					               hlop::collective::set_cost_cache_capacity(0);
+				               return [state = round(), b = std::make_shared<const bench_bcast>()]() {
+					               keep(b->calc_cost(*state.first, *state.second, 65536));
+				               };
+			               }});
+	}
+
+	// a full prediction of each implemented algorithm, one message size at a time from 1 byte to 64 KiB,
+	// the total size of an allgather of 4096 ranks is below INT_MAX
+	struct algo {
+		hlop::op_type_t op;
+		hlop::algo_type_t type;
+		int ppn;
+	};
+	// RECURSIVE_DOUBLING has no parameters of 8 or more processes per node
+	for (const auto &a : {algo{hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, 16},
+	                      algo{hlop::op_type::SCATTER, hlop::algo_type::BINOMIAL, 16},
+	                      algo{hlop::op_type::ALLGATHER, hlop::algo_type::RECURSIVE_DOUBLING, 4}})
+		for (const int nodes : {4, 64, 1024})
+			res.push_back({hlop::format("predict/{}/{}/ranks:{}", hlop::enum_name(a.op), hlop::enum_name(a.type),
+			                            nodes * a.ppn),
+			               [a, nodes]() {
+				               return [c = std::shared_ptr<const hlop::collective>{hlop::make_collective(a.op)},
+				                       nl = std::make_shared<const hlop::node_list_t>(
+				                           hlop::platform::DF, df_hostlist(nodes), a.ppn, arrange),
+				                       type = a.type, msz = 1]() mutable {
+					               keep(c->predict(type, *nl, msz, 0));
+					               msz = msz >= (1 << 16) ? 1 : msz * 2;
+				               };
+			               }});
+	return res;
+}
+
+std::string to_json(const std::vector<result> &results) {
+	char host[256] = {};
+	::gethostname(host, sizeof(host) - 1);
+	const std::time_t now = std::time(nullptr);
+	char date[32];
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	std::string res = hlop::format("{\n  \"context\": {\"date\": {}, \"host\": {}, \"min_time\": {}, \"interp\": {}},\n",
+	                               hlop::quote_json(date), hlop::quote_json(host), FLAGS_min_time,
+	                               hlop::quote_json(FLAGS_interp == "" ? "DEFAULT" : FLAGS_interp));
+	res += "  \"benchmarks\": [";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const auto &r = results[i];
+		res += hlop::format("{}\n    {\"name\": {}, \"iterations\": {}, \"ns_per_op\": {}, \"allocs_per_op\": {}, "
+		                    "\"bytes_per_op\": {}, \"peak_rss_kb\": {}}",
+		                    i == 0 ? "" : ",", hlop::quote_json(r.name), r.iterations, r.ns_per_op,
+		                    r.allocs_per_op, r.bytes_per_op, r.peak_rss_kb);
+	}
+	res += "\n  ]\n}\n";
+	return res;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+	gflags::SetUsageMessage("benchmark the predictor on synthetic DF host lists, the results are written as json");
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (FLAGS_min_time < 0)
+		HLOP_ERR(hlop::format("minimum time {} is negative", FLAGS_min_time));
+	if (FLAGS_interp != "")
+		hlop::collective::set_interp_mode(hlop::enum_cast<hlop::interp_mode>(FLAGS_interp));
+
+	const std::regex filter{FLAGS_filter};
+	std::vector<result> results;
+	int failed = 0;
+	for (const auto &b : make_benchmarks()) {
+		if (!std::regex_search(b.name, filter))
+			continue;
+		if (FLAGS_list) {
+			std::cout << b.name << "\n";
+			continue;
+		}
+		hlop::collective::set_cost_cache_capacity(hlop::collective::DEFAULT_COST_CACHE_CAPACITY);
+		std::cerr << b.name << std::flush;
+		try {
+			results.push_back(run(b));
+			std::cerr << hlop::format(" {} ns/op\n", results.back().ns_per_op);
+		} catch (const std::exception &e) {
+			// a failed benchmark is left out of the results, the others still run
+			std::cerr << " failed: " << e.what() << "\n";
+			++failed;
+		}
+	}
+	if (FLAGS_list)
+		return 0;
+
+	const std::string json = to_json(results);
+	if (FLAGS_out == "") {
+		std::cout << json;
+	} else {
+		std::ofstream f{FLAGS_out};
+		if (!(f << json))
+			HLOP_ERR(hlop::format("failed to write {}", FLAGS_out));
+	}
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+
+#include "aux.h"
+#include "err.h"
+#include "gflags/gflags.h"
+#include "interp.h"
+#include "msg.h"
+#include "param/param.h"
+
+DEFINE_string(in, "", "input parameter file, csv or binary");
+DEFINE_string(out, "", "output binary parameter file");
+DEFINE_string(interp, "", "interpolation mode saved in the output, EXPONENTIAL, LOG_LINEAR or MONOTONE_CUBIC, "
+                          "keep the mode of the input by default");
+
+// ./hlop_param_compile --in=resources/param_lat_all.csv --out=param_lat_all.bin
+int main(int argc, char *argv[]) {
+	gflags::SetUsageMessage("compile a csv parameter table into the binary parameter format");
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (FLAGS_in == "")
+		HLOP_ERR("input parameter file must be specified with --in");
+	if (FLAGS_out == "")
+		HLOP_ERR("output parameter file must be specified with --out");
+
+	const hlop::param_t p = FLAGS_interp == ""
+	                            ? hlop::param_t{FLAGS_in}
+	                            : hlop::param_t{FLAGS_in, hlop::enum_cast<hlop::interp_mode>(FLAGS_interp)};
+	int nfailed = p.save(FLAGS_out);
+	std::cout << hlop::format("{}: {} categories, {} buckets, {} -> {}",
+	                          FLAGS_in, p.get_categorys().size(), p.get_msg_size_range().size(),
+	                          hlop::enum_name(p.get_interp_mode()), FLAGS_out)
+	          << std::endl;
+	if (nfailed > 0)
+		std::cout << hlop::format("{} categories can not be fitted, they are fitted again when used", nfailed)
+		          << std::endl;
+	return 0;
+}
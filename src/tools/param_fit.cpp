@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "err.h"
+#include "fit.h"
+#include "gflags/gflags.h"
+#include "msg.h"
+#include "param/param.h"
+
+DEFINE_string(in, "", "input csv parameter file");
+DEFINE_string(out, "", "output fit file, <in>.fit by default, which is loaded with <in>");
+DEFINE_int32(threads, 0, "number of fitting threads, the number of cores by default");
+
+namespace {
+/// @brief fitting result of a category.
+struct fit_result {
+	std::string category;
+	hlop::exponential_params_t coef;
+	hlop::fit_report_t report;
+	bool ok;
+};
+
+/**
+ * @brief group categories into chains, the categories of a chain only differ in contention.
+ * @param categories vector<string>, all categories, sorted.
+ * @return vector<vector<int>>, indices of categories of each chain, sorted by contention.
+ * @note Neighbours in a chain have similar curves, so each fit warm starts from the previous one.
+ */
+std::vector<std::vector<int>> make_chains(const std::vector<std::string> &categories) {
+	std::map<std::pair<int, int>, std::vector<std::pair<int, int>>> tables;
+	std::vector<std::vector<int>> chains;
+	for (int i = 0; i < categories.size(); ++i) {
+		hlop::param_key_t key;
+		if (hlop::param::parse_category(categories[i], key))
+			tables[{static_cast<int>(key.cls), key.level}].emplace_back(key.contention, i);
+		else
+			chains.push_back({i});
+	}
+	for (auto &t : tables) {
+		std::sort(t.second.begin(), t.second.end());
+		std::vector<int> chain;
+		for (const auto &c : t.second)
+			chain.emplace_back(c.second);
+		chains.emplace_back(std::move(chain));
+	}
+	return chains;
+}
+
+/**
+ * @brief fit a chain of categories.
+ * @param p param, the parameters.
+ * @param chain vector<int>, indices of categories of the chain.
+ * @param results vector<fit_result>, output, the results of all categories.
+ */
+void fit_chain(const hlop::param_t &p, const std::vector<int> &chain, std::vector<fit_result> &results) {
+	const auto &x = p.get_msg_size_range();
+	const hlop::exponential_params_t *prev = nullptr;
+	for (int i : chain) {
+		auto &r = results[i];
+		const auto &y = p.get_category_params(r.category);
+		r.ok = false;
+		// warm start from the previous category of the chain, fall back to the cold start
+		if (prev != nullptr) {
+			try {
+				r.coef = hlop::curve_fit_exponential(x, y, {prev->A, prev->B, prev->C}, r.report);
+				r.ok = true;
+			} catch (const std::exception &e) {
+			}
+		}
+		if (!r.ok) {
+			try {
+				r.coef = hlop::curve_fit_exponential(x, y, {0, 0, y[0]}, r.report);
+				r.ok = true;
+			} catch (const std::exception &e) {
+			}
+		}
+		prev = r.ok ? &r.coef : nullptr;
+	}
+}
+} // namespace
+
+// ./hlop_param_fit --in=resources/param_lat_all.csv --threads=8
+int main(int argc, char *argv[]) {
+	gflags::SetUsageMessage("fit every category of a csv parameter table and write the curves to a sidecar fit file");
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (FLAGS_in == "")
+		HLOP_ERR("input parameter file must be specified with --in");
+	const std::string out = FLAGS_out == "" ? hlop::param::fit_file(FLAGS_in) : FLAGS_out;
+	int nthread = FLAGS_threads > 0 ? FLAGS_threads : std::max(1u, std::thread::hardware_concurrency());
+
+	const auto start = std::chrono::steady_clock::now();
+	const hlop::param_t p{FLAGS_in};
+	std::vector<std::string> categories;
+	for (const auto &c : p.get_categorys())
+		categories.emplace_back(c);
+	std::sort(categories.begin(), categories.end());
+
+	std::vector<fit_result> results(categories.size());
+	for (int i = 0; i < categories.size(); ++i)
+		results[i].category = categories[i];
+	const auto chains = make_chains(categories);
+
+	// chains are independent, each thread takes the next chain until none is left
+	std::atomic<std::size_t> next{0};
+	std::vector<std::thread> workers;
+	nthread = std::min<int>(nthread, std::max<std::size_t>(chains.size(), 1));
+	for (int t = 0; t < nthread; ++t)
+		workers.emplace_back([&]() {
+			for (std::size_t c = next++; c < chains.size(); c = next++)
+				fit_chain(p, chains[c], results);
+		});
+	for (auto &w : workers)
+		w.join();
+
+	// write to a temporary file and rename it, like the binary parameter files
+	const std::string tmp_file = out + ".tmp";
+	std::ofstream fout{tmp_file, std::ios::trunc};
+	if (!fout.is_open())
+		HLOP_ERR(hlop::format("failed to open fit file: {}", tmp_file));
+	fout << hlop::param::fit_source_line(FLAGS_in) << std::endl
+	     << "category,A,B,C,rmse,max_rel_err,iterations" << std::endl
+	     << std::setprecision(17);
+	int nfailed = 0;
+	double max_rmse = 0.0, max_rel_err = 0.0;
+	for (const auto &r : results) {
+		if (!r.ok) {
+			++nfailed;
+			std::cout << hlop::format("{}: fitting did not converge", r.category) << std::endl;
+			continue;
+		}
+		fout << r.category << "," << r.coef.A << "," << r.coef.B << "," << r.coef.C << ","
+		     << r.report.rmse << "," << r.report.max_rel_err << "," << r.report.iterations << std::endl;
+		max_rmse = std::max(max_rmse, r.report.rmse);
+		max_rel_err = std::max(max_rel_err, r.report.max_rel_err);
+	}
+	fout.close();
+	if (!fout)
+		HLOP_ERR(hlop::format("failed to write fit file: {}", tmp_file));
+	if (std::rename(tmp_file.c_str(), out.c_str()) != 0)
+		HLOP_ERR(hlop::format("failed to rename {} to {}", tmp_file, out));
+
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << hlop::format("{}: {} categories, {} failed, max rmse {}, max relative error {} -> {} ({} threads, {} ms)",
+	                          FLAGS_in, results.size(), nfailed, max_rmse, max_rel_err, out, nthread, elapsed)
+	          << std::endl;
+	return 0;
+}
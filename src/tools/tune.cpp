@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "aux.h"
+#include "collective.h"
+#include "err.h"
+#include "factory.h"
+#include "gflags/gflags.h"
+#include "msg.h"
+#include "node/hostlist.h"
+#include "platform.h"
+#include "struct/node_list.h"
+#include "struct/plan.h"
+#include "struct/type.h"
+#include "thread_pool.h"
+
+DEFINE_string(ops, "BCAST", "comma separated collective operations to tune");
+DEFINE_string(pf, "", "platform");
+DEFINE_string(nl, "", "node list of the allocation, each node count takes the first nodes of it");
+DEFINE_string(nodes, "", "comma separated node counts, the powers of 2 up to the size of the node list by default");
+DEFINE_string(ppn, "1", "comma separated processes per node");
+DEFINE_int32(msz_min, 1, "smallest message size");
+DEFINE_int32(msz_max, 1 << 20, "largest message size");
+DEFINE_int32(probe, 3, "message sizes are probed every 2^probe, the crossovers between probes are bisected, "
+                       "at most 20");
+DEFINE_int32(root, 0, "root rank of rooted operations");
+DEFINE_int32(threads, 0, "number of sweeping threads, the number of cores by default");
+DEFINE_string(out, "hlop_tune", "prefix of the output files, <out>.conf for Open MPI, <out>.json for MPICH and <out>.csv");
+
+namespace {
+/// @brief the largest --probe, probes 2^20 apart leave at most three of them in the range of int message sizes.
+constexpr int MAX_PROBE = 20;
+
+/// @brief a message size range won by an algorithm, from msg_size to the msg_size of the next segment.
+struct segment {
+	int msg_size;
+	hlop::algo_type_t algo;
+	double time;
+};
+
+/// @brief a point of the sweep and its decision table.
+struct point {
+	hlop::op_type_t op;
+	int nodes;
+	int ppn;
+	std::vector<segment> segments;
+	std::string error;
+};
+
+/**
+ * @brief the candidates of a point, the plans of the planned ones are made once and evaluated for every size.
+ */
+struct point_model {
+	const hlop::collective &c;
+	const hlop::node_list_t &nl;
+	int root;
+	std::vector<hlop::algo_type_t> algos;
+	std::vector<std::optional<hlop::plan_t>> plans;
+	std::map<int, std::pair<std::size_t, double>> memo; // message size -> (winner, time)
+
+	double cost(std::size_t i, int msg_size) const {
+		return plans[i].has_value() ? c.evaluate(plans[i].value(), msg_size)
+		                            : c.predict(algos[i], nl, msg_size, root);
+	}
+
+	const std::pair<std::size_t, double> &winner(int msg_size) {
+		auto it = memo.find(msg_size);
+		if (it != memo.end())
+			return it->second;
+		std::pair<std::size_t, double> best{0, cost(0, msg_size)};
+		for (std::size_t i = 1; i < algos.size(); ++i) {
+			const double t = cost(i, msg_size);
+			if (t < best.second)
+				best = {i, t};
+		}
+		return memo.emplace(msg_size, best).first->second;
+	}
+};
+
+/**
+ * @brief find the crossovers between two message sizes whose winners differ.
+ * @param m point_model, the candidates of the point.
+ * @param lo int, a message size.
+ * @param hi int, a larger message size.
+ * @param crossovers map<int, size_t>, output, the smallest message size won by each new winner.
+ * @note The range is bisected geometrically until the winner changes between neighbouring sizes,
+ * a winner in the middle that differs from both ends is bisected on each side.
+ */
+void bisect(point_model &m, int lo, int hi, std::map<int, std::size_t> &crossovers) {
+	const auto w_lo = m.winner(lo).first, w_hi = m.winner(hi).first;
+	if (w_lo == w_hi)
+		return;
+	if (hi - lo <= 1) {
+		crossovers[hi] = w_hi;
+		return;
+	}
+	int mid = static_cast<int>(std::sqrt(static_cast<double>(lo) * hi));
+	mid = std::min(std::max(mid, lo + 1), hi - 1);
+	bisect(m, lo, mid, crossovers);
+	bisect(m, mid, hi, crossovers);
+}
+
+/**
+ * @brief sweep the message sizes of a point.
+ * @param c collective, the predictor of the operation of the point.
+ * @param nl node_list, the node list of the point.
+ * @param p point, input and output, its segments are filled, or its error if the root is not a rank
+ * of the point or no algorithm predicts.
+ */
+void sweep(const hlop::collective &c, const hlop::node_list_t &nl, point &p) {
+	if (FLAGS_root < 0 || FLAGS_root >= nl.get_rank_num()) {
+		p.error = hlop::format("root {} is out of the {} ranks", FLAGS_root, nl.get_rank_num());
+		return;
+	}
+	point_model m{c, nl, FLAGS_root, {}, {}, {}};
+	auto algos = c.get_algos();
+	std::sort(algos.begin(), algos.end());
+	for (const auto a : algos) {
+		if (!c.is_implemented(a))
+			continue;
+		// an algorithm that can not be predicted, e.g. a parameter category is missing, is not a candidate
+		const auto skip = [&p, a](const std::exception &e) {
+			std::cout << hlop::format("{} {} x {}: {} is skipped, {}", p.op, p.nodes, p.ppn, a, e.what()) << std::endl;
+		};
+		std::optional<hlop::plan_t> plan;
+		try {
+			if (c.has_plan(a))
+				plan = c.make_plan(a, nl, FLAGS_root);
+		} catch (const std::exception &e) {
+			skip(e);
+			continue;
+		}
+		m.algos.push_back(a);
+		m.plans.push_back(std::move(plan));
+		try {
+			m.cost(m.algos.size() - 1, FLAGS_msz_min);
+		} catch (const std::exception &e) {
+			skip(e);
+			m.algos.pop_back();
+			m.plans.pop_back();
+		}
+	}
+	if (m.algos.empty()) {
+		p.error = "no algorithm can be predicted";
+		return;
+	}
+
+	// probe every 2^probe, bisect between probes of different winners
+	std::vector<int> probes;
+	// a probe beyond msz_max >> probe is the last one, its shift could overflow
+	for (long long s = FLAGS_msz_min; s < FLAGS_msz_max;
+	     s = s > (FLAGS_msz_max >> FLAGS_probe) ? FLAGS_msz_max : s << FLAGS_probe)
+		probes.push_back(static_cast<int>(s));
+	probes.push_back(FLAGS_msz_max);
+	std::map<int, std::size_t> crossovers;
+	for (std::size_t i = 0; i + 1 < probes.size(); ++i)
+		bisect(m, probes[i], probes[i + 1], crossovers);
+
+	const auto &first = m.winner(FLAGS_msz_min);
+	p.segments.push_back(segment{FLAGS_msz_min, m.algos[first.first], first.second});
+	for (const auto &x : crossovers)
+		if (m.algos[x.second] != p.segments.back().algo)
+			p.segments.push_back(segment{x.first, m.algos[x.second], m.winner(x.first).second});
+}
+
+/**
+ * @brief the collective id of an operation in Open MPI coll_tuned.
+ * @param op op_type, the operation type.
+ * @return int, the id of COLLTYPE_T, -1 if there is none.
+ */
+int ompi_coll_id(hlop::op_type_t op) {
+	switch (op) {
+	case hlop::op_type::ALLGATHER: return 0;
+	case hlop::op_type::ALLREDUCE: return 2;
+	case hlop::op_type::ALLTOALL: return 3;
+	case hlop::op_type::BCAST: return 7;
+	case hlop::op_type::GATHER: return 9;
+	case hlop::op_type::REDUCE: return 11;
+	case hlop::op_type::SCATTER: return 15;
+	default: return -1;
+	}
+}
+
+/**
+ * @brief the algorithm id of Open MPI coll_tuned.
+ * @param op op_type, the operation type.
+ * @param algo algo_type, the algorithm type.
+ * @return int, the id of the forced algorithm, 0 to let coll_tuned decide if it has no such algorithm.
+ */
+int ompi_algo_id(hlop::op_type_t op, hlop::algo_type_t algo) {
+	switch (op) {
+	case hlop::op_type::ALLGATHER:
+		switch (algo) {
+		case hlop::algo_type::BRUCKS: return 2;
+		case hlop::algo_type::RECURSIVE_DOUBLING: return 3;
+		case hlop::algo_type::RING: return 4;
+		default: return 0;
+		}
+	case hlop::op_type::BCAST:
+		switch (algo) {
+		case hlop::algo_type::BINOMIAL: return 6;
+		case hlop::algo_type::SCATTER_RECURSIVE_DOUBLING_ALLGATHER: return 8;
+		case hlop::algo_type::SCATTER_RING_ALLGATHER: return 9;
+		default: return 0;
+		}
+	case hlop::op_type::SCATTER:
+		return algo == hlop::algo_type::BINOMIAL ? 2 : 0;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief the algorithm name of the MPICH collective selection.
+ * @param op op_type, the operation type.
+ * @param algo algo_type, the algorithm type.
+ * @return string, e.g., MPIR_Bcast_intra_binomial.
+ */
+std::string mpich_algo_name(hlop::op_type_t op, hlop::algo_type_t algo) {
+	std::string o{hlop::enum_name(op)}, a{hlop::enum_name(algo)};
+	std::transform(o.begin() + 1, o.end(), o.begin() + 1, ::tolower);
+	std::transform(a.begin(), a.end(), a.begin(), ::tolower);
+	return "MPIR_" + o + "_intra_" + a;
+}
+
+/**
+ * @brief the points of an operation that have a decision table.
+ * @param points vector<point>, all points.
+ * @param op op_type, the operation type.
+ * @return vector<const point *>, sorted by (ppn, nodes).
+ */
+std::vector<const point *> points_of(const std::vector<point> &points, hlop::op_type_t op) {
+	std::vector<const point *> res;
+	for (const auto &p : points)
+		if (p.op == op && p.error.empty())
+			res.push_back(&p);
+	std::sort(res.begin(), res.end(), [](const auto *a, const auto *b) {
+		return std::make_pair(a->ppn, a->nodes) < std::make_pair(b->ppn, b->nodes);
+	});
+	return res;
+}
+
+/**
+ * @brief write a file through a temporary file and rename it, like the binary parameter files.
+ * @param file string, path to the file.
+ * @param write function<void(ostream &)>, writes the content.
+ * @throws hlop_err, if the file can not be written.
+ */
+void write_file(const std::string &file, const std::function<void(std::ostream &)> &write) {
+	const std::string tmp_file = file + ".tmp";
+	std::ofstream fout{tmp_file, std::ios::trunc};
+	if (!fout.is_open())
+		HLOP_ERR(hlop::format("failed to open output file: {}", tmp_file));
+	write(fout);
+	fout.close();
+	if (!fout)
+		HLOP_ERR(hlop::format("failed to write output file: {}", tmp_file));
+	if (std::rename(tmp_file.c_str(), file.c_str()) != 0)
+		HLOP_ERR(hlop::format("failed to rename {} to {}", tmp_file, file));
+}
+
+/**
+ * @brief write the Open MPI coll_tuned dynamic rules.
+ * @param os ostream, the output.
+ * @param ops vector<op_type>, the operations.
+ * @param points vector<point>, all points.
+ * @note The rules only know the communicator size, the point of the most processes per node is kept
+ * when several points have the same size. The first rule of a size starts at message size 0.
+ */
+void write_ompi_rules(std::ostream &os, const std::vector<hlop::op_type_t> &ops, const std::vector<point> &points) {
+	std::vector<std::pair<hlop::op_type_t, std::map<int, const point *>>> colls;
+	for (const auto op : ops) {
+		if (ompi_coll_id(op) < 0)
+			continue;
+		std::map<int, const point *> sizes;
+		for (const auto *p : points_of(points, op))
+			sizes[p->nodes * p->ppn] = p; // sorted by ppn, the last one has the most
+		if (!sizes.empty())
+			colls.emplace_back(op, std::move(sizes));
+	}
+	os << "# decision rules of hlop_tune, use with --mca coll_tuned_use_dynamic_rules 1"
+	   << " --mca coll_tuned_dynamic_rules_filename <file>" << std::endl
+	   << colls.size() << " # number of collectives" << std::endl;
+	for (const auto &c : colls) {
+		os << ompi_coll_id(c.first) << " # " << c.first << std::endl
+		   << c.second.size() << " # number of communicator sizes" << std::endl;
+		for (const auto &s : c.second) {
+			const auto &segments = s.second->segments;
+			os << s.first << " # communicator size, " << s.second->nodes << " nodes x " << s.second->ppn << " ppn" << std::endl
+			   << segments.size() << " # number of message sizes" << std::endl;
+			for (std::size_t i = 0; i < segments.size(); ++i)
+				os << (i == 0 ? 0 : segments[i].msg_size) << " " << ompi_algo_id(c.first, segments[i].algo)
+				   << " 0 0 # " << segments[i].algo << std::endl;
+		}
+	}
+}
+
+/**
+ * @brief write the MPICH collective selection json, see MPIR_CVAR_COLL_SELECTION_TUNING_JSON_FILE.
+ * @param os ostream, the output.
+ * @param ops vector<op_type>, the operations.
+ * @param points vector<point>, all points.
+ * @note The tree is collective, comm_avg_ppn, comm_size then avg_msg_size, the last branch of each level is "any".
+ */
+void write_mpich_json(std::ostream &os, const std::vector<hlop::op_type_t> &ops, const std::vector<point> &points) {
+	auto indent = [&](int n) -> std::ostream & { return os << std::string(n, '\t'); };
+	std::vector<std::pair<hlop::op_type_t, std::vector<const point *>>> colls;
+	for (const auto op : ops) {
+		auto ps = points_of(points, op);
+		if (!ps.empty())
+			colls.emplace_back(op, std::move(ps));
+	}
+	os << "{" << std::endl;
+	for (std::size_t c = 0; c < colls.size(); ++c) {
+		const auto op = colls[c].first;
+		const auto &ps = colls[c].second;
+		std::string name{hlop::enum_name(op)};
+		std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+		indent(1) << "\"collective=" << name << "\": {" << std::endl;
+		indent(2) << "\"comm_type=intra\": {" << std::endl;
+		for (std::size_t i = 0; i < ps.size();) {
+			// points are sorted by (ppn, nodes), [i, j) share a ppn
+			std::size_t j = i;
+			while (j < ps.size() && ps[j]->ppn == ps[i]->ppn)
+				++j;
+			const bool last_ppn = j == ps.size();
+			indent(3) << (last_ppn ? "\"comm_avg_ppn=any\"" : hlop::format("\"comm_avg_ppn<={}\"", ps[i]->ppn)) << ": {" << std::endl;
+			for (std::size_t k = i; k < j; ++k) {
+				const bool last_size = k + 1 == j;
+				indent(4) << (last_size ? "\"comm_size=any\"" : hlop::format("\"comm_size<={}\"", ps[k]->nodes * ps[k]->ppn))
+				          << ": {" << std::endl;
+				const auto &segments = ps[k]->segments;
+				for (std::size_t s = 0; s < segments.size(); ++s) {
+					const bool last_msg = s + 1 == segments.size();
+					indent(5) << (last_msg ? "\"avg_msg_size=any\"" : hlop::format("\"avg_msg_size<={}\"", segments[s + 1].msg_size - 1))
+					          << ": {\"algorithm=" << mpich_algo_name(op, segments[s].algo) << "\": {}}"
+					          << (last_msg ? "" : ",") << std::endl;
+				}
+				indent(4) << "}" << (last_size ? "" : ",") << std::endl;
+			}
+			indent(3) << "}" << (last_ppn ? "" : ",") << std::endl;
+			i = j;
+		}
+		indent(2) << "}" << std::endl;
+		indent(1) << "}" << (c + 1 == colls.size() ? "" : ",") << std::endl;
+	}
+	os << "}" << std::endl;
+}
+
+/**
+ * @brief write the decision tables as csv, one row for each segment.
+ * @param os ostream, the output.
+ * @param points vector<point>, all points.
+ */
+void write_csv(std::ostream &os, const std::vector<point> &points) {
+	os << "op,nodes,ppn,comm_size,msg_size_min,msg_size_max,algo,time" << std::endl;
+	for (const auto &p : points)
+		for (std::size_t i = 0; i < p.segments.size(); ++i) {
+			const auto &s = p.segments[i];
+			const int max = i + 1 < p.segments.size() ? p.segments[i + 1].msg_size - 1 : FLAGS_msz_max;
+			os << p.op << "," << p.nodes << "," << p.ppn << "," << p.nodes * p.ppn << ","
+			   << s.msg_size << "," << max << "," << s.algo << "," << s.time << std::endl;
+		}
+}
+} // namespace
+
+// ./hlop_tune --ops=BCAST,ALLGATHER --pf=DF --nl="i10r4n[00-63]" --ppn=1,8,16 --out=df
+int main(int argc, char *argv[]) {
+	gflags::SetUsageMessage("sweep the algorithms of collective operations over node counts, processes per node "
+	                        "and message sizes, and write the decision tables for MPI libraries");
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (FLAGS_pf == "")
+		HLOP_ERR("platform must be specified with --pf");
+	if (FLAGS_nl == "")
+		HLOP_ERR("node list must be specified with --nl");
+	if (FLAGS_msz_min < 1 || FLAGS_msz_max < FLAGS_msz_min)
+		HLOP_ERR("message sizes must satisfy 0 < --msz_min <= --msz_max");
+	if (FLAGS_probe < 1 || FLAGS_probe > MAX_PROBE)
+		HLOP_ERR(hlop::format("--probe must be in range [1, {}]", MAX_PROBE));
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto pf = hlop::enum_cast<hlop::platform>(FLAGS_pf);
+	std::vector<hlop::op_type_t> ops;
+	for (const auto &o : hlop::stov<std::string>(FLAGS_ops))
+		ops.push_back(hlop::enum_cast<hlop::op_type>(o));
+	const auto hosts = hlop::parse_hostlist(FLAGS_nl);
+	std::vector<int> nodes = hlop::stov<int>(FLAGS_nodes);
+	if (nodes.empty())
+		for (int n = 2; n <= static_cast<int>(hosts.size()); n <<= 1)
+			nodes.push_back(n);
+	const auto ppns = hlop::stov<int>(FLAGS_ppn);
+
+	// the parameters, the predictors and the node lists are shared by all points
+	std::vector<std::unique_ptr<hlop::collective>> predictors;
+	for (const auto op : ops)
+		predictors.push_back(hlop::make_collective(op));
+	std::map<std::pair<int, int>, std::unique_ptr<const hlop::node_list_t>> node_lists;
+	for (const auto n : nodes) {
+		if (n < 1 || n > static_cast<int>(hosts.size()))
+			HLOP_ERR(hlop::format("node count {} is out of the {} nodes of the node list", n, hosts.size()));
+		std::string host_list;
+		for (int i = 0; i < n; ++i)
+			host_list += (i == 0 ? "" : ",") + hosts[i];
+		for (const auto ppn : ppns)
+			node_lists[{n, ppn}] = std::make_unique<const hlop::node_list_t>(
+			    pf, host_list, ppn,
+			    hlop::arrangement_t{.node_arrange = hlop::rank_arrangement::BLOCK,
+			                        .core_arrange = hlop::rank_arrangement::BLOCK});
+	}
+
+	std::vector<point> points;
+	for (const auto op : ops)
+		for (const auto n : nodes)
+			for (const auto ppn : ppns)
+				points.push_back(point{op, n, ppn, {}, ""});
+
+	// every point is a task, a point predicts its algorithms in the task itself
+	hlop::thread_pool_t pool{static_cast<std::size_t>(std::max(FLAGS_threads, 0))};
+	std::vector<std::future<void>> futures;
+	for (auto &p : points) {
+		const auto &c = *predictors[std::find(ops.begin(), ops.end(), p.op) - ops.begin()];
+		const auto &nl = *node_lists.at({p.nodes, p.ppn});
+		futures.push_back(pool.submit([&c, &nl, &p]() {
+			try {
+				sweep(c, nl, p);
+			} catch (const std::exception &e) {
+				p.error = e.what();
+			}
+		}));
+	}
+	for (auto &f : futures)
+		f.get();
+
+	// a failed point has no decision table, the tables of the others are written
+	long failed = 0;
+	for (const auto &p : points) {
+		if (!p.error.empty()) {
+			std::cout << hlop::format("{} {} x {}: {}", p.op, p.nodes, p.ppn, p.error) << std::endl;
+			++failed;
+			continue;
+		}
+		std::string table;
+		for (const auto &s : p.segments)
+			table += hlop::format(" {}+: {}", s.msg_size, s.algo);
+		std::cout << hlop::format("{} {} x {}:{}", p.op, p.nodes, p.ppn, table) << std::endl;
+	}
+	write_file(FLAGS_out + ".conf", [&](std::ostream &os) { write_ompi_rules(os, ops, points); });
+	write_file(FLAGS_out + ".json", [&](std::ostream &os) { write_mpich_json(os, ops, points); });
+	write_file(FLAGS_out + ".csv", [&](std::ostream &os) { write_csv(os, points); });
+
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << hlop::format("{} points -> {}.conf, {}.json, {}.csv ({} threads, {} ms, round cost cache {})",
+	                          points.size(), FLAGS_out, FLAGS_out, FLAGS_out, pool.size(), elapsed,
+	                          hlop::collective::get_cost_cache_stats())
+	          << std::endl;
+	return failed > 0 ? 1 : 0;
+}
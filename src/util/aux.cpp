@@ -1,3 +1,7 @@
+#include <cmath>
+#include <sstream>
+#include <string>
+
 #include "aux.h"
 #include "err.h"
 #include "msg.h"
@@ -30,4 +34,36 @@ int hlop::pof2_floor(int x) {
 	x |= x >> 8;
 	x |= x >> 16;
 	return x - (x >> 1);
-}
\ No newline at end of file
+}
+
+std::string hlop::quote_json(const std::string &s) {
+	std::string res = "\"";
+	for (const char c : s) {
+		if (c == '"' || c == '\\')
+			res += '\\', res += c;
+		else if (c == '\n')
+			res += "\\n";
+		else if (static_cast<unsigned char>(c) < 0x20)
+			res += hlop::format("\\u00{}{}", "0123456789abcdef"[c >> 4], "0123456789abcdef"[c & 15]);
+		else
+			res += c;
+	}
+	return res + "\"";
+}
+
+std::string hlop::quote_csv(const std::string &s) {
+	if (s.find_first_of(",\"\n") == std::string::npos)
+		return s;
+	std::string res = "\"";
+	for (const char c : s)
+		res += c == '"' ? std::string{"\"\""} : std::string{c};
+	return res + "\"";
+}
+
+std::string hlop::json_number(double t) {
+	if (!std::isfinite(t))
+		return "null";
+	std::ostringstream oss;
+	oss << t;
+	return oss.str();
+}
@@ -0,0 +1,190 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "disk_cache.h"
+#include "err.h"
+#include "msg.h"
+
+namespace {
+constexpr std::uint64_t MAGIC = 0x31304344504f4c48ull; // "HLOPDC01"
+constexpr std::uint32_t VERSION = 1;
+
+template <typename T>
+T load(const T *p, int order = __ATOMIC_RELAXED) {
+	return __atomic_load_n(p, order);
+}
+
+template <typename T>
+void store(T *p, T v, int order = __ATOMIC_RELAXED) {
+	__atomic_store_n(p, v, order);
+}
+
+/**
+ * @brief the file descriptor of a cache file while it is opened, locked and closed on every path.
+ */
+class locked_file {
+public:
+	explicit locked_file(const std::string &path) {
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if (fd < 0)
+			HLOP_ERR(hlop::format("cannot open cache file {}: {}", path, std::strerror(errno)));
+		if (::flock(fd, LOCK_EX) < 0) {
+			const int err = errno;
+			::close(fd);
+			HLOP_ERR(hlop::format("cannot lock cache file {}: {}", path, std::strerror(err)));
+		}
+	}
+	~locked_file() {
+		::flock(fd, LOCK_UN);
+		::close(fd);
+	}
+
+	int fd;
+};
+} // namespace
+
+// the file is a header and the slots, the words of a slot are written under its sequence
+struct hlop::disk_cache::header {
+	std::uint64_t magic;
+	std::uint32_t version;
+	std::uint32_t slot_size;
+	std::uint64_t nslot;
+	std::uint64_t clock; // incremented by every insert, the stamp of a slot is the clock when it was last used
+	std::uint64_t reserved[4];
+};
+
+struct hlop::disk_cache::slot {
+	std::uint64_t seq; // 0 if empty, odd while written
+	std::uint64_t hi;
+	std::uint64_t lo;
+	std::uint64_t first;
+	std::uint64_t second;
+	std::uint64_t stamp;
+};
+
+hlop::disk_cache::disk_cache(const std::string &path, std::size_t capacity) : path(path) {
+	locked_file f{path};
+	struct stat st;
+	if (::fstat(f.fd, &st) < 0)
+		HLOP_ERR(hlop::format("cannot stat cache file {}: {}", path, std::strerror(errno)));
+	const bool create = st.st_size == 0;
+	if (create) {
+		if (capacity < PROBE)
+			HLOP_ERR(hlop::format("cache capacity {} must be at least {}", capacity, PROBE));
+		map_size = sizeof(header) + capacity * sizeof(slot);
+		if (::ftruncate(f.fd, map_size) < 0)
+			HLOP_ERR(hlop::format("cannot size cache file {}: {}", path, std::strerror(errno)));
+	} else {
+		map_size = st.st_size;
+		if (map_size < sizeof(header))
+			HLOP_ERR(hlop::format("{} is not an hlop cache file", path));
+	}
+	map = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, f.fd, 0);
+	if (map == MAP_FAILED) {
+		map = nullptr;
+		HLOP_ERR(hlop::format("cannot map cache file {}: {}", path, std::strerror(errno)));
+	}
+	head = static_cast<header *>(map);
+	slots = reinterpret_cast<slot *>(static_cast<char *>(map) + sizeof(header));
+
+	if (create) {
+		// the file is zero filled, every slot is empty
+		head->version = VERSION;
+		head->slot_size = sizeof(slot);
+		head->nslot = capacity;
+		store(&head->magic, MAGIC, __ATOMIC_RELEASE);
+	} else if (head->magic != MAGIC || head->version != VERSION || head->slot_size != sizeof(slot) ||
+	           head->nslot < PROBE || map_size != sizeof(header) + head->nslot * sizeof(slot)) {
+		::munmap(map, map_size);
+		map = nullptr;
+		HLOP_ERR(hlop::format("{} is not an hlop cache file of version {}, remove it to start a new one", path,
+		                      VERSION));
+	}
+	nslot = head->nslot;
+}
+
+hlop::disk_cache::~disk_cache() {
+	if (map != nullptr)
+		::munmap(map, map_size);
+}
+
+std::size_t hlop::disk_cache::capacity() const { return nslot; }
+
+hlop::disk_cache::slot *hlop::disk_cache::window(const hlop::disk_cache_key_t &key, std::size_t i) const {
+	return &slots[(key.lo + i) % nslot];
+}
+
+bool hlop::disk_cache::find(const hlop::disk_cache_key_t &key, hlop::disk_cache_value_t &value) const {
+	for (std::size_t i = 0; i < PROBE; ++i) {
+		slot *s = window(key, i);
+		const std::uint64_t seq = load(&s->seq, __ATOMIC_ACQUIRE);
+		if (seq == 0 || (seq & 1))
+			continue;
+		// acquire loads keep the check of the sequence after them, thread sanitizer does not model fences
+		const std::uint64_t hi = load(&s->hi, __ATOMIC_ACQUIRE), lo = load(&s->lo, __ATOMIC_ACQUIRE);
+		const hlop::disk_cache_value_t v{load(&s->first, __ATOMIC_ACQUIRE), load(&s->second, __ATOMIC_ACQUIRE)};
+		// a writer took the slot while it was read
+		if (load(&s->seq) != seq || hi != key.hi || lo != key.lo)
+			continue;
+		value = v;
+		store(&s->stamp, load(&head->clock));
+		return true;
+	}
+	return false;
+}
+
+bool hlop::disk_cache::insert(const hlop::disk_cache_key_t &key, const hlop::disk_cache_value_t &value) {
+	const std::uint64_t now = __atomic_add_fetch(&head->clock, 1, __ATOMIC_RELAXED);
+	// a slot taken by another writer between the scan and the claim is scanned again
+	for (std::size_t attempt = 0; attempt < PROBE; ++attempt) {
+		slot *target = nullptr, *empty = nullptr, *oldest = nullptr;
+		std::uint64_t target_seq = 0, empty_seq = 0, oldest_seq = 0;
+		std::uint64_t oldest_stamp = std::numeric_limits<std::uint64_t>::max();
+		for (std::size_t i = 0; i < PROBE && target == nullptr; ++i) {
+			slot *s = window(key, i);
+			const std::uint64_t seq = load(&s->seq, __ATOMIC_ACQUIRE);
+			if (seq & 1)
+				continue;
+			if (seq == 0) {
+				if (empty == nullptr)
+					empty = s, empty_seq = seq;
+				continue;
+			}
+			if (load(&s->hi) == key.hi && load(&s->lo) == key.lo)
+				target = s, target_seq = seq;
+			else if (const auto stamp = load(&s->stamp); stamp < oldest_stamp)
+				oldest = s, oldest_seq = seq, oldest_stamp = stamp;
+		}
+		// the key itself, then an empty slot, then the least recently used one
+		if (target == nullptr && empty != nullptr) {
+			target = empty;
+			target_seq = empty_seq;
+		} else if (target == nullptr) {
+			target = oldest;
+			target_seq = oldest_seq;
+		}
+		if (target == nullptr)
+			return false;
+		if (!__atomic_compare_exchange_n(&target->seq, &target_seq, target_seq + 1, false, __ATOMIC_ACQUIRE,
+		                                 __ATOMIC_RELAXED))
+			continue;
+		// a reader that loads one of the words also sees the odd sequence
+		store(&target->hi, key.hi, __ATOMIC_RELEASE);
+		store(&target->lo, key.lo, __ATOMIC_RELEASE);
+		store(&target->first, value.first, __ATOMIC_RELEASE);
+		store(&target->second, value.second, __ATOMIC_RELEASE);
+		store(&target->stamp, now);
+		store(&target->seq, target_seq + 2, __ATOMIC_RELEASE);
+		return true;
+	}
+	return false;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <functional>
@@ -37,9 +38,36 @@ int hlop::exponential_residual(const gsl_vector *params, void *data, gsl_vector
 	return GSL_SUCCESS;
 }
 
+int hlop::exponential_jacobian(const gsl_vector *params, void *data, gsl_matrix *J) {
+	double A = gsl_vector_get(params, 0);
+	double B = gsl_vector_get(params, 1);
+
+	const std::vector<double> *data_ptr = static_cast<const std::vector<double> *>(data);
+	const auto &x = data_ptr->data();
+	std::size_t n = data_ptr->size() / 2;
+
+	// r = y - (A * exp(-B * x) + C)
+	for (std::size_t i = 0; i < n; ++i) {
+		double e = std::exp(-B * x[i]);
+		gsl_matrix_set(J, i, 0, -e);
+		gsl_matrix_set(J, i, 1, A * x[i] * e);
+		gsl_matrix_set(J, i, 2, -1.0);
+	}
+
+	return GSL_SUCCESS;
+}
+
 hlop::exponential_params_t hlop::curve_fit_exponential(const std::vector<double> &x_data,
                                                        const std::vector<double> &y_data,
                                                        const std::vector<double> &initial_guess) {
+	hlop::fit_report_t report;
+	return hlop::curve_fit_exponential(x_data, y_data, initial_guess, report);
+}
+
+hlop::exponential_params_t hlop::curve_fit_exponential(const std::vector<double> &x_data,
+                                                       const std::vector<double> &y_data,
+                                                       const std::vector<double> &initial_guess,
+                                                       hlop::fit_report_t &report) {
 	// 验证输入数据
 	if (x_data.size() != y_data.size())
 		HLOP_ERR("x_data and y_data must have the same size");
@@ -69,7 +97,7 @@ hlop::exponential_params_t hlop::curve_fit_exponential(const std::vector<double>
 	// 定义残差函数
 	gsl_multifit_nlinear_fdf fdf;
 	fdf.f = hlop::exponential_residual;
-	fdf.df = nullptr;  // 不提供解析雅可比（使用数值差分）
+	fdf.df = hlop::exponential_jacobian; // 解析雅可比
 	fdf.fvv = nullptr; // 不提供二阶导
 	fdf.n = n;
 	fdf.p = p;
@@ -91,8 +119,11 @@ hlop::exponential_params_t hlop::curve_fit_exponential(const std::vector<double>
 	status = gsl_multifit_nlinear_driver(max_iter, xtol, gtol, ftol, NULL, NULL, &iter, workspace);
 
 	// 检查收敛状态
-	if (status != GSL_SUCCESS)
+	if (status != GSL_SUCCESS) {
+		gsl_vector_free(params);
+		gsl_multifit_nlinear_free(workspace);
 		HLOP_ERR("fitting did not converge");
+	}
 
 	// 获取优化后的参数
 	hlop::exponential_params_t results;
@@ -100,16 +131,15 @@ hlop::exponential_params_t hlop::curve_fit_exponential(const std::vector<double>
 	results.B = gsl_vector_get(workspace->x, 1);
 	results.C = gsl_vector_get(workspace->x, 2);
 
-	// 输出优化信息
-	gsl_matrix *J = gsl_matrix_alloc(p, p);
-	gsl_multifit_nlinear_covar(workspace->J, 0.0, J);
-
-	double chi = gsl_blas_dnrm2(workspace->f);
-	double dof = n - p;
-	double c = GSL_MAX_DBL(1, chi / sqrt(dof));
+	// 拟合质量
+	report.rmse = gsl_blas_dnrm2(workspace->f) / std::sqrt(static_cast<double>(n));
+	report.max_rel_err = 0.0;
+	for (std::size_t i = 0; i < n; ++i)
+		if (y_data[i] != 0.0)
+			report.max_rel_err = std::max(report.max_rel_err, std::fabs(gsl_vector_get(workspace->f, i) / y_data[i]));
+	report.iterations = gsl_multifit_nlinear_niter(workspace);
 
 	// 清理资源
-	gsl_matrix_free(J);
 	gsl_vector_free(params);
 	gsl_multifit_nlinear_free(workspace);
 
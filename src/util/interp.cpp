@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+#include "aux.h"
+#include "interp.h"
+
+std::ostream &hlop::operator<<(std::ostream &os, const hlop::interp_mode_t &mode) {
+	os << hlop::enum_name(mode);
+	return os;
+}
+
+void hlop::monotone_tangents(const double *x, const double *y, std::size_t n, double *m) {
+	if (n < 2) {
+		std::fill(m, m + n, 0.0);
+		return;
+	}
+	// secants as the initial tangents, zero at local extrema
+	m[0] = (y[1] - y[0]) / (x[1] - x[0]);
+	m[n - 1] = (y[n - 1] - y[n - 2]) / (x[n - 1] - x[n - 2]);
+	for (std::size_t i = 1; i + 1 < n; ++i) {
+		double d0 = (y[i] - y[i - 1]) / (x[i] - x[i - 1]),
+		       d1 = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+		m[i] = (d0 * d1 <= 0.0) ? 0.0 : (d0 + d1) / 2;
+	}
+	// limit the tangents so that every segment stays monotone
+	for (std::size_t i = 0; i + 1 < n; ++i) {
+		double d = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+		if (d == 0.0) {
+			m[i] = 0.0;
+			m[i + 1] = 0.0;
+			continue;
+		}
+		double a = m[i] / d, b = m[i + 1] / d;
+		if (a < 0.0)
+			m[i] = 0.0, a = 0.0;
+		if (b < 0.0)
+			m[i + 1] = 0.0, b = 0.0;
+		double r = a * a + b * b;
+		if (r > 9.0) {
+			double tau = 3.0 / std::sqrt(r);
+			m[i] = tau * a * d;
+			m[i + 1] = tau * b * d;
+		}
+	}
+}
+
+std::size_t hlop::locate_segment(const double *x, std::size_t n, double step, double xv) {
+	double i;
+	if (step > 0.0)
+		i = std::floor((xv - x[0]) / step);
+	else
+		i = static_cast<double>(std::upper_bound(x, x + n, xv) - x) - 1;
+	return static_cast<std::size_t>(std::min(std::max(i, 0.0), static_cast<double>(n - 2)));
+}
+
+double hlop::interp_linear(const double *x, const double *y, std::size_t n, double step, double xv) {
+	std::size_t i = hlop::locate_segment(x, n, step, xv);
+	double t = (xv - x[i]) / (x[i + 1] - x[i]);
+	return y[i] + t * (y[i + 1] - y[i]);
+}
+
+double hlop::interp_monotone_cubic(const double *x, const double *y, const double *m,
+                                   std::size_t n, double step, double xv) {
+	if (xv <= x[0])
+		return y[0] + m[0] * (xv - x[0]);
+	if (xv >= x[n - 1])
+		return y[n - 1] + m[n - 1] * (xv - x[n - 1]);
+	std::size_t i = hlop::locate_segment(x, n, step, xv);
+	double h = x[i + 1] - x[i],
+	       t = (xv - x[i]) / h,
+	       t2 = t * t,
+	       t3 = t2 * t;
+	return (2 * t3 - 3 * t2 + 1) * y[i] + (t3 - 2 * t2 + t) * h * m[i] +
+	       (-2 * t3 + 3 * t2) * y[i + 1] + (t3 - t2) * h * m[i + 1];
+}
+
+void hlop::interp_linear(const double *x, const double *y, std::size_t n, double step,
+                         const double *xv, double *out, std::size_t count) {
+	for (std::size_t k = 0; k < count; ++k)
+		out[k] = hlop::interp_linear(x, y, n, step, xv[k]);
+}
+
+void hlop::interp_monotone_cubic(const double *x, const double *y, const double *m, std::size_t n, double step,
+                                 const double *xv, double *out, std::size_t count) {
+	for (std::size_t k = 0; k < count; ++k)
+		out[k] = hlop::interp_monotone_cubic(x, y, m, n, step, xv[k]);
+}
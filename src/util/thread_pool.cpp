@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "thread_pool.h"
+
+hlop::thread_pool::thread_pool(std::size_t nthread) {
+	if (nthread == 0)
+		nthread = std::max(1u, std::thread::hardware_concurrency());
+	workers.reserve(nthread);
+	for (std::size_t i = 0; i < nthread; ++i)
+		workers.emplace_back([this]() { work(); });
+}
+
+hlop::thread_pool::~thread_pool() {
+	{
+		std::lock_guard<std::mutex> lock{mtx};
+		stopping = true;
+	}
+	cv.notify_all();
+	for (auto &w : workers)
+		w.join();
+}
+
+std::size_t hlop::thread_pool::size() const { return workers.size(); }
+
+void hlop::thread_pool::push(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock{mtx};
+		tasks.push(std::move(task));
+	}
+	cv.notify_one();
+}
+
+void hlop::thread_pool::work() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock{mtx};
+			cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			// the queue is drained before the workers stop
+			if (tasks.empty())
+				return;
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+		task();
+	}
+}
@@ -2,7 +2,9 @@
 #include <vector>
 
 #include "bcast.h"
+#include "err.h"
 #include "m_debug.h"
+#include "msg.h"
 #include "platform.h"
 #include "struct/node_list.h"
 #include "struct/type.h"
@@ -21,5 +23,28 @@ int main(int argc, char const *argv[]) {
 	for (const auto &i : res)
 		std::cout << i << std::endl;
 
+	// the schedule is simulated once and evaluated for every message size
+	const auto p = b.make_plan(hlop::algo_type::BINOMIAL, l, 0);
+	INFO("plan: {}", p);
+	INFO_VEC("plan costs", b.evaluate(p, std::vector<int>{4, 1024, 65536}));
+	INFO("round cost cache: {}", hlop::collective::get_cost_cache_stats());
+	INFO_VEC("ranking", b.select_best(l, 1024, 0));
+	// the simulation stops once the partial cost passes the bound, the partial cost is returned
+	INFO_VEC("lower bound", b.lower_bound(hlop::algo_type::BINOMIAL, l, std::vector<int>{1024}));
+	INFO_VEC("bounded", b.predict(hlop::algo_type::BINOMIAL, l, std::vector<int>{1024}, 0, std::vector<double>{1.0}));
+
+	// a root that is not a rank of the node list is rejected before anything is simulated
+	for (const int root : {-1, l.get_rank_num()}) {
+		bool thrown = false;
+		try {
+			b.make_plan(hlop::algo_type::BINOMIAL, l, root);
+		} catch (const std::exception &e) {
+			thrown = true;
+			INFO("root {}: {}", root, e.what());
+		}
+		if (!thrown)
+			HLOP_ERR(hlop::format("root {} of {} ranks was planned", root, l.get_rank_num()));
+	}
+
 	return 0;
 }
\ No newline at end of file
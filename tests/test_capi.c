@@ -0,0 +1,91 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hlop.h"
+
+// the test is C, so hlop.h is checked to be a C header
+#define CHECK(cond, ...)                                   \
+	do {                                                   \
+		if (!(cond)) {                                     \
+			fprintf(stderr, "[ERROR] " __VA_ARGS__);       \
+			fprintf(stderr, ": %s\n", hlop_last_error()); \
+			exit(1);                                       \
+		}                                                  \
+	} while (0)
+
+static double now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(void) {
+	const char *hosts[] = {"i10r4n03", "i10r4n04", "i10r4n08", "i10r4n09",
+	                       "i10r4n13", "i10r4n14", "i10r4n16", "i10r4n18"};
+	const int nhost = 8, ppn = 16, nrank = nhost * ppn;
+	const int msg_sizes[] = {1, 100, 1024, 65536, 1 << 20};
+	const int nmsz = sizeof(msg_sizes) / sizeof(msg_sizes[0]);
+
+	// the block placement given rank by rank is the regular block arrangement
+	int rank_nodes[128], rank_cores[128];
+	for (int r = 0; r < nrank; ++r) {
+		rank_nodes[r] = r / ppn;
+		rank_cores[r] = r % ppn;
+	}
+	hlop_topology_t *placed, *regular;
+	CHECK(hlop_topology_create(HLOP_PLATFORM_DF, hosts, nhost, rank_nodes, rank_cores, nrank, &placed) == HLOP_SUCCESS,
+	      "cannot create a placed topology");
+	CHECK(hlop_topology_create_regular(HLOP_PLATFORM_DF, "i10r4n[03-04,08-09,13-14,16,18]", ppn, HLOP_ARRANGE_BLOCK,
+	                                   HLOP_ARRANGE_BLOCK, &regular) == HLOP_SUCCESS,
+	      "cannot create a regular topology");
+	CHECK(hlop_topology_ranks(placed) == nrank && hlop_topology_ranks(regular) == nrank, "wrong number of ranks");
+	const hlop_op_t ops[] = {HLOP_OP_BCAST, HLOP_OP_SCATTER};
+	for (int o = 0; o < 2; ++o)
+		for (int i = 0; i < nmsz; ++i) {
+			double t1, t2;
+			CHECK(hlop_predict(placed, ops[o], HLOP_ALGO_BINOMIAL, msg_sizes[i], &t1) == HLOP_SUCCESS, "predict failed");
+			CHECK(hlop_predict(regular, ops[o], HLOP_ALGO_BINOMIAL, msg_sizes[i], &t2) == HLOP_SUCCESS, "predict failed");
+			CHECK(fabs(t1 - t2) <= 1e-9 * t2, "op %d size %d: %g placed, %g regular", ops[o], msg_sizes[i], t1, t2);
+		}
+	printf("[INFO] a block placement predicts as the block arrangement\n");
+
+	hlop_algo_t algo;
+	double t;
+	for (int i = 0; i < nmsz; ++i) {
+		CHECK(hlop_best_algo(regular, HLOP_OP_BCAST, msg_sizes[i], &algo, &t) == HLOP_SUCCESS, "best algo failed");
+		printf("[INFO] BCAST %d: algo %d, %g us\n", msg_sizes[i], algo, t);
+	}
+
+	// a repeated question is answered from the topology
+	const int nrepeat = 100000;
+	double start = now_us();
+	for (int i = 0; i < nrepeat; ++i)
+		hlop_predict(placed, HLOP_OP_SCATTER, HLOP_ALGO_BINOMIAL, msg_sizes[i % nmsz], &t);
+	printf("[INFO] hlop_predict: %g us\n", (now_us() - start) / nrepeat);
+	start = now_us();
+	for (int i = 0; i < nrepeat; ++i)
+		hlop_best_algo(regular, HLOP_OP_BCAST, msg_sizes[i % nmsz], &algo, NULL);
+	printf("[INFO] hlop_best_algo: %g us\n", (now_us() - start) / nrepeat);
+
+	// the errors are returned, not thrown
+	hlop_topology_t *bad = NULL;
+	CHECK(hlop_topology_create_regular(HLOP_PLATFORM_DF, "i10r4n[03-", ppn, HLOP_ARRANGE_BLOCK, HLOP_ARRANGE_BLOCK,
+	                                   &bad) == HLOP_ERR_FAILED && bad == NULL,
+	      "an invalid host list is accepted");
+	printf("[INFO] invalid host list: %s\n", hlop_last_error());
+	rank_cores[1] = 0;
+	CHECK(hlop_topology_create(HLOP_PLATFORM_DF, hosts, nhost, rank_nodes, rank_cores, nrank, &bad) == HLOP_ERR_FAILED,
+	      "two ranks on a core are accepted");
+	printf("[INFO] two ranks on a core: %s\n", hlop_last_error());
+	CHECK(hlop_predict(regular, HLOP_OP_BCAST, HLOP_ALGO_BINOMIAL, 0, &t) == HLOP_ERR_ARG, "size 0 is accepted");
+	CHECK(hlop_predict(NULL, HLOP_OP_BCAST, HLOP_ALGO_BINOMIAL, 1, &t) == HLOP_ERR_ARG, "null is accepted");
+	CHECK(hlop_predict(regular, HLOP_OP_ALLTOALL, HLOP_ALGO_BINOMIAL, 1, &t) == HLOP_ERR_ARG, "ALLTOALL is accepted");
+	printf("[INFO] unsupported operation: %s\n", hlop_last_error());
+
+	hlop_topology_free(placed);
+	hlop_topology_free(regular);
+	hlop_topology_free(NULL);
+	return 0;
+}
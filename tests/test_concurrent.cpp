@@ -0,0 +1,86 @@
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allgather.h"
+#include "bcast.h"
+#include "err.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "platform.h"
+#include "scatter.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+namespace {
+const std::vector<std::string> host_lists{"i10r4n[03-04,08-09,13-14,16,18-19]", "i02r1n[00-31]",
+                                          "i10r4n[03-04],i11r2n[05-06],j01r1n[01-04]"};
+const std::vector<int> msg_sizes{4, 100, 1024, 8192, 65536, 1 << 20};
+const hlop::arrangement_t arrange{.node_arrange = hlop::rank_arrangement::BLOCK,
+                                  .core_arrange = hlop::rank_arrangement::CYCLIC};
+
+/**
+ * @brief predict every message size of the implemented algorithms of the collectives on a node list.
+ */
+std::vector<double> predict_all(const hlop::bcast &b, const hlop::scatter &s, const hlop::allgather &ag,
+                                const hlop::node_list_t &nl) {
+	std::vector<double> res;
+	for (const int msg_size : msg_sizes) {
+		res.push_back(b.predict(hlop::algo_type::BINOMIAL, nl, msg_size, 0));
+		res.push_back(s.predict(hlop::algo_type::BINOMIAL, nl, msg_size, 0));
+		res.push_back(ag.predict(hlop::algo_type::RECURSIVE_DOUBLING, nl, msg_size, 0));
+	}
+	for (const auto &r : b.select_best(nl, msg_sizes, 0, nullptr, true))
+		res.push_back(r.front().time);
+	// on the shared pool
+	res.push_back(s.select_best(nl, 1024, 0).front().time);
+	const auto p = ag.make_plan(hlop::algo_type::RECURSIVE_DOUBLING, nl, 0);
+	for (const double c : ag.evaluate(p, msg_sizes))
+		res.push_back(c);
+	return res;
+}
+} // namespace
+
+int main(int argc, char const *argv[]) {
+	const hlop::bcast b{};
+	const hlop::scatter s{};
+	const hlop::allgather ag{};
+
+	// the results of one thread, with an empty round cost cache
+	std::vector<hlop::const_node_list_ptr> snapshots;
+	std::vector<std::vector<double>> expected;
+	for (const auto &hl : host_lists) {
+		snapshots.push_back(std::make_shared<const hlop::node_list_t>(hlop::platform::DF, hl, 4, arrange));
+		expected.push_back(predict_all(b, s, ag, *snapshots.back()));
+	}
+	// empty the round cost cache and make it too small, so it is filled and evicted by all threads
+	hlop::collective::set_cost_cache_capacity(0);
+	hlop::collective::set_cost_cache_capacity(64);
+
+	// the odd threads parse their own node lists, the even ones share the snapshots, all share the collectives
+	const int nthread = 8, niter = 4;
+	std::vector<int> mismatches(nthread, 0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nthread; ++t)
+		threads.emplace_back([&, t] {
+			for (int it = 0; it < niter; ++it)
+				for (int i = 0; i < host_lists.size(); ++i) {
+					const int j = (i + t) % host_lists.size();
+					hlop::node_list_t own{hlop::platform::DF, host_lists[j], 4, arrange};
+					const auto &nl = t % 2 ? own : *snapshots[j];
+					if (predict_all(b, s, ag, nl) != expected[j])
+						++mismatches[t];
+				}
+		});
+	for (auto &t : threads)
+		t.join();
+	int nmismatch = 0;
+	for (const int m : mismatches)
+		nmismatch += m;
+	if (nmismatch > 0)
+		HLOP_ERR(hlop::format("{} concurrent predictions differ from the serial ones", nmismatch));
+	INFO("{} threads x {} node lists x {} iterations predicted the same as one thread", nthread, host_lists.size(), niter);
+	INFO("round cost cache: {}", hlop::collective::get_cost_cache_stats());
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "err.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "node/df_node.h"
+#include "node/node.h"
+#include "struct/comm_pair.h"
+#include "struct/comm_round.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+namespace {
+using counted = std::tuple<int, int, int>; // src rank, dst rank of the first pair of a link, its count
+
+/// @brief nodes of a list with the ranks bound to their cores, as comm_pair expects them.
+std::vector<hlop::const_node_ptr_t> bound_nodes(const hlop::node_list_t &nl) {
+	std::vector<std::shared_ptr<hlop::df_node>> nodes;
+	for (const auto &node : nl.get_node_list())
+		nodes.push_back(std::make_shared<hlop::df_node>(node->name()));
+	for (int r = 0; r < nl.get_rank_num(); ++r)
+		nodes[nl.get_node_id_by_rank(r)]->bind_core(r, nl.get_core_id_by_rank(r));
+	return std::vector<hlop::const_node_ptr_t>(nodes.begin(), nodes.end());
+}
+
+/// @brief the former count of collective::get_contentions, a std::map searched by comm_pair::operator==.
+std::vector<counted> reference_count(const hlop::node_list_t &nl, const std::vector<std::pair<int, int>> &round) {
+	const auto nodes = bound_nodes(nl);
+	std::map<hlop::comm_pair, int> res;
+	for (const auto &[src, dst] : round) {
+		const hlop::comm_pair_t p{nodes[nl.get_node_id_by_rank(src)], src, nodes[nl.get_node_id_by_rank(dst)], dst};
+		const auto &iter = std::find_if(res.begin(), res.end(),
+		                                [&p](const auto &pair) { return pair.first == p; });
+		if (iter != res.end())
+			++iter->second;
+		else
+			res.emplace(p, 1);
+	}
+	std::vector<counted> v;
+	for (const auto &[p, count] : res)
+		v.emplace_back(p.get_src_rank(), p.get_dst_rank(), count);
+	std::sort(v.begin(), v.end());
+	return v;
+}
+
+std::vector<counted> dense_count(const hlop::node_list_t &nl, const std::vector<std::pair<int, int>> &round) {
+	hlop::comm_round_t r;
+	for (const auto &[src, dst] : round)
+		r.add(nl, src, dst);
+	std::vector<counted> v;
+	for (const auto &c : r.count_contentions(nl))
+		v.emplace_back(c.pair.src_rank, c.pair.dst_rank, c.count);
+	std::sort(v.begin(), v.end());
+	return v;
+}
+
+void check(const std::string &name, const hlop::node_list_t &nl, const std::vector<std::pair<int, int>> &round) {
+	const auto expect = reference_count(nl, round);
+	const auto got = dense_count(nl, round);
+	if (got != expect)
+		HLOP_ERR(hlop::format("{}: {} links counted, {} by the map, first differing link {}", name, got.size(),
+		                      expect.size(), [&]() {
+			                      const auto d = std::mismatch(got.begin(), got.end(), expect.begin(), expect.end());
+			                      return d.first == got.end() ? std::string{"none"}
+			                                                  : hlop::format("{}->{} x{}", std::get<0>(*d.first),
+			                                                                 std::get<1>(*d.first),
+			                                                                 std::get<2>(*d.first));
+		                      }()));
+}
+} // namespace
+
+int main(int argc, char const *argv[]) {
+	const hlop::arrangement_t block_cyclic{.node_arrange = hlop::rank_arrangement::BLOCK,
+	                                       .core_arrange = hlop::rank_arrangement::CYCLIC};
+	const hlop::arrangement_t cyclic_block{.node_arrange = hlop::rank_arrangement::CYCLIC,
+	                                       .core_arrange = hlop::rank_arrangement::BLOCK};
+	// irregular lists: gaps in the node ranges, several racks and groups, a non-pof2 ppn, an explicit placement
+	const std::vector<std::pair<std::string, hlop::node_list_t>> lists{
+	    {"gaps", hlop::node_list_t{hlop::platform::DF, "i10r4n[03-04,06,08-10],j10r4n04", 16, block_cyclic}},
+	    {"groups", hlop::node_list_t{hlop::platform::DF, "i10r4n[01-03],i11r1n[05-06],i12r2n07", 6, cyclic_block}},
+	    {"explicit", hlop::node_list_t{hlop::platform::DF, "i10r4n[03-05]", 8, {0, 2, 1, 0, 2, 2, 1, 0, 0},
+	                                   {0, 7, 3, 5, 1, 2, 4, 6, 1}}}};
+
+	std::mt19937 gen{20240601};
+	for (const auto &[name, nl] : lists) {
+		const int n = nl.get_rank_num();
+		int rounds = 0;
+		// shifts put pairs within a unit, across units of a node and across nodes into one round
+		for (const int d : {1, 2, 3, nl.get_ppn() - 1, nl.get_ppn(), nl.get_ppn() + 1, n / 2}) {
+			if (d <= 0 || d >= n)
+				continue;
+			std::vector<std::pair<int, int>> round;
+			for (int r = 0; r < n; ++r)
+				round.emplace_back(r, (r + d) % n);
+			check(hlop::format("{} shift {}", name, d), nl, round);
+			++rounds;
+		}
+		// random rounds, with repeated and reversed pairs
+		std::uniform_int_distribution<int> rank{0, n - 1};
+		for (int i = 0; i < 20; ++i) {
+			std::vector<std::pair<int, int>> round;
+			for (int k = 0; k < n; ++k) {
+				const int src = rank(gen), dst = rank(gen);
+				if (src != dst)
+					round.emplace_back(src, dst);
+			}
+			check(hlop::format("{} random {}", name, i), nl, round);
+			++rounds;
+		}
+		INFO("{}: {} ranks, {} rounds counted as by the map", name, n, rounds);
+	}
+	return 0;
+}
@@ -0,0 +1,180 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bcast.h"
+#include "disk_cache.h"
+#include "err.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "platform.h"
+#include "prediction_cache.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+namespace {
+const hlop::arrangement_t arrange{.node_arrange = hlop::rank_arrangement::BLOCK,
+                                  .core_arrange = hlop::rank_arrangement::BLOCK};
+
+hlop::disk_cache_key_t key_of(std::uint64_t i) {
+	return hlop::disk_cache_key_t{i * 0x9e3779b97f4a7c15ull + 1, i * 0xc2b2ae3d27d4eb4full + 7};
+}
+
+/// @brief a value that tells a torn write from a whole one.
+hlop::disk_cache_value_t value_of(const hlop::disk_cache_key_t &k, std::uint64_t writer) {
+	return hlop::disk_cache_value_t{k.hi ^ writer, k.lo ^ writer};
+}
+
+bool whole(const hlop::disk_cache_key_t &k, const hlop::disk_cache_value_t &v) {
+	return (v.first ^ k.hi) == (v.second ^ k.lo);
+}
+
+long file_size(const std::string &path) {
+	struct stat st;
+	return ::stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+} // namespace
+
+int main(int argc, char const *argv[]) {
+	const std::string path = hlop::format("/tmp/test_disk_cache-{}", ::getpid());
+	std::remove(path.c_str());
+
+	// a round trip, kept by the file
+	{
+		hlop::disk_cache_t c{path, 64};
+		if (!c.insert(key_of(1), value_of(key_of(1), 0)))
+			HLOP_ERR("insert into an empty cache failed");
+	}
+	{
+		hlop::disk_cache_t c{path, 1024};
+		hlop::disk_cache_value_t v;
+		if (c.capacity() != 64)
+			HLOP_ERR(hlop::format("a reopened cache has {} slots, expect 64", c.capacity()));
+		if (!c.find(key_of(1), v) || !whole(key_of(1), v) || c.find(key_of(2), v))
+			HLOP_ERR("a reopened cache lost its entry");
+		INFO("the cache file keeps its entries and its capacity");
+
+		// the file never grows, the least recently used entries are evicted
+		const long size = file_size(path);
+		for (std::uint64_t i = 0; i < 10000; ++i)
+			c.insert(key_of(i), value_of(key_of(i), 0));
+		std::size_t found = 0;
+		for (std::uint64_t i = 0; i < 10000; ++i)
+			found += c.find(key_of(i), v) ? 1 : 0;
+		if (file_size(path) != size || found > c.capacity() || found == 0)
+			HLOP_ERR(hlop::format("{} of 10000 entries in a cache of {} slots", found, c.capacity()));
+		INFO("{} of 10000 entries kept in {} slots, {} bytes", found, c.capacity(), size);
+	}
+	std::remove(path.c_str());
+
+	// concurrent writers of other processes and threads, a reader never sees a torn value
+	{
+		const int nproc = 4, nthread = 2;
+		const std::uint64_t nkey = 4000;
+		hlop::disk_cache_t c{path, 2048};
+		std::vector<pid_t> children;
+		for (int p = 0; p < nproc; ++p) {
+			const pid_t pid = ::fork();
+			if (pid == 0) {
+				hlop::disk_cache_t child{path, 0};
+				for (std::uint64_t i = 0; i < nkey; ++i)
+					child.insert(key_of(i), value_of(key_of(i), p + 1));
+				::_exit(0);
+			}
+			children.push_back(pid);
+		}
+		std::vector<std::thread> threads;
+		std::atomic<bool> torn{false};
+		for (int t = 0; t < nthread; ++t)
+			threads.emplace_back([&c, t, &torn]() {
+				hlop::disk_cache_value_t v;
+				for (std::uint64_t i = 0; i < nkey; ++i) {
+					c.insert(key_of(nkey - i), value_of(key_of(nkey - i), 100 + t));
+					if (c.find(key_of(i), v) && !whole(key_of(i), v))
+						torn = true;
+				}
+			});
+		for (auto &t : threads)
+			t.join();
+		for (const pid_t pid : children) {
+			int status = 0;
+			::waitpid(pid, &status, 0);
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				HLOP_ERR("a writer process failed");
+		}
+		std::size_t found = 0;
+		hlop::disk_cache_value_t v;
+		for (std::uint64_t i = 0; i <= nkey; ++i)
+			if (c.find(key_of(i), v)) {
+				++found;
+				if (!whole(key_of(i), v))
+					torn = true;
+			}
+		if (torn)
+			HLOP_ERR("a torn value was read");
+		INFO("{} processes and {} threads wrote {} keys, {} kept, none torn", nproc, nthread, nkey, found);
+	}
+	std::remove(path.c_str());
+
+	// a file of something else is not taken
+	{
+		std::ofstream{path} << "not a cache";
+		bool thrown = false;
+		try {
+			hlop::disk_cache_t c{path, 64};
+		} catch (const std::exception &e) {
+			thrown = true;
+			INFO("invalid cache file: {}", e.what());
+		}
+		if (!thrown)
+			HLOP_ERR("an invalid cache file was opened");
+	}
+	std::remove(path.c_str());
+
+	// the predictions of the cache are the ones of the library, the spelling of a node list does not matter
+	{
+		const std::vector<int> msg_sizes{1, 100, 1024, 65536};
+		const hlop::bcast b{};
+		const hlop::node_list_t nl{hlop::platform::DF, "i02r1n[18-19]", 16, arrange};
+		const hlop::node_list_t alias{hlop::platform::DF, "i02r1n18,i02r1n19", 16, arrange};
+		const hlop::node_list_t other{hlop::platform::DF, "i02r1n[18-19]", 8, arrange};
+		if (hlop::prediction_cache_t::fingerprint(nl).lo != hlop::prediction_cache_t::fingerprint(alias).lo ||
+		    hlop::prediction_cache_t::fingerprint(nl).lo == hlop::prediction_cache_t::fingerprint(other).lo)
+			HLOP_ERR("the fingerprint of a node list depends on its spelling, or not on its ppn");
+
+		const auto expected = b.predict(hlop::algo_type::BINOMIAL, nl, msg_sizes, 0);
+		{
+			hlop::prediction_cache_t cache{path, 1024};
+			if (cache.predict(b, hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, nl, msg_sizes) != expected)
+				HLOP_ERR("the cache predicted otherwise than the library");
+			const auto best = b.select_best(nl, msg_sizes, 0, nullptr);
+			const auto cached = cache.select_best(b, hlop::op_type::BCAST, nl, msg_sizes, false);
+			for (std::size_t i = 0; i < msg_sizes.size(); ++i)
+				if (cached[i].algo != best[i].front().algo || cached[i].time != best[i].front().time)
+					HLOP_ERR(hlop::format("the cache selected otherwise than the library for {}", msg_sizes[i]));
+		}
+		hlop::prediction_cache_t cache{path, 1024};
+		if (cache.predict(b, hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, alias, msg_sizes) != expected ||
+		    cache.select_best(b, hlop::op_type::BCAST, alias, msg_sizes, true).size() != msg_sizes.size())
+			HLOP_ERR("the reopened cache predicted otherwise than the library");
+		const auto stats = cache.get_stats();
+		if (stats.hits != 2 * msg_sizes.size() || stats.misses != 0)
+			HLOP_ERR(hlop::format("{} hits and {} misses, expect {} hits", stats.hits, stats.misses,
+			                      2 * msg_sizes.size()));
+		std::ostringstream oss;
+		oss << stats;
+		INFO("a second run is answered from the file, {}", oss.str());
+	}
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "aux.h"
+#include "bcast.h"
+#include "client.h"
+#include "err.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "platform.h"
+#include "protocol.h"
+#include "server.h"
+#include "struct/node_list.h"
+#include "struct/type.h"
+
+namespace {
+const hlop::arrangement_t arrange{.node_arrange = hlop::rank_arrangement::BLOCK,
+                                  .core_arrange = hlop::rank_arrangement::BLOCK};
+
+hlop::hlopd_request_t query(hlop::op_type_t op, std::optional<hlop::algo_type_t> algo, const std::string &nl,
+                            const std::vector<int> &msz) {
+	hlop::hlopd_request_t req{};
+	req.type = hlop::hlopd_msg_type::QUERY;
+	req.op = op;
+	req.algo = algo;
+	req.pf = hlop::platform::DF;
+	req.rule = arrange;
+	req.ppn = 16;
+	req.nl = nl;
+	req.msz = msz;
+	return req;
+}
+
+bool same(const std::vector<hlop::hlopd_result_t> &a, const std::vector<hlop::hlopd_result_t> &b) {
+	if (a.size() != b.size())
+		return false;
+	for (std::size_t i = 0; i < a.size(); ++i)
+		if (a[i].algo != b[i].algo || a[i].status != b[i].status || a[i].time != b[i].time)
+			return false;
+	return true;
+}
+} // namespace
+
+int main(int argc, char const *argv[]) {
+	const std::string path = hlop::format("/tmp/test_hlopd-{}.sock", ::getpid());
+	const std::string cache_path = path + ".cache";
+	std::remove(cache_path.c_str());
+	hlop::hlopd_server_t server{hlop::hlopd_config_t{.socket_path = path,
+	                                                 .nthread = 2,
+	                                                 .topology_capacity = 16,
+	                                                 .result_capacity = 1024,
+	                                                 .cache_path = cache_path,
+	                                                 .cache_capacity = 4096}};
+	std::thread loop{[&] { server.run(); }};
+	hlop::hlopd_client_t client{path};
+
+	// the predictions are the ones of the library
+	const std::string hl = "i10r4n[03-04,08-09,13-14,16,18-19]";
+	const std::vector<int> msg_sizes{1, 100, 1024, 65536};
+	const hlop::bcast b{};
+	const hlop::node_list_t nl{hlop::platform::DF, hl, 16, arrange};
+	const auto res = client.request(query(hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, hl, msg_sizes));
+	if (!res.ok || res.results.size() != msg_sizes.size())
+		HLOP_ERR(hlop::format("hlopd failed: {}", res.error));
+	for (std::size_t i = 0; i < msg_sizes.size(); ++i) {
+		const double expected = b.predict(hlop::algo_type::BINOMIAL, nl, msg_sizes[i], 0);
+		if (res.results[i].status != hlop::algo_status::OK || std::abs(res.results[i].time - expected) > 1e-12)
+			HLOP_ERR(hlop::format("hlopd predicted {} for message size {}, expect {}", res.results[i].time,
+			                      msg_sizes[i], expected));
+	}
+	INFO("hlopd predicted {} message sizes of BCAST BINOMIAL as the library", msg_sizes.size());
+
+	// a repeated query is answered from the caches
+	const int nrepeat = 1000;
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < nrepeat; ++i)
+		if (!same(client.request(query(hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, hl, msg_sizes)).results, res.results))
+			HLOP_ERR("a cached hlopd response differs from the first one");
+	const auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	INFO("cached query round trip: {} us", us / nrepeat);
+
+	// the same hosts written another way are one topology
+	const auto before = client.get_stats();
+	const auto alias = client.request(query(hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, "i02r1n[18-19]", {1024}));
+	const auto other = client.request(query(hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, "i02r1n18,i02r1n19", {1024}));
+	const auto after = client.get_stats();
+	if (!alias.ok || !other.ok || !same(alias.results, other.results))
+		HLOP_ERR("hlopd predicted two spellings of a node list differently");
+	if (after.topology_misses != before.topology_misses + 1 || after.topology_hits != before.topology_hits + 1)
+		HLOP_ERR("the second spelling of a node list is not a topology hit");
+	INFO("i02r1n[18-19] and i02r1n18,i02r1n19 share a topology");
+
+	// the best algorithm, and an error
+	const auto best = client.request(query(hlop::op_type::BCAST, std::nullopt, hl, msg_sizes));
+	if (!best.ok)
+		HLOP_ERR(hlop::format("hlopd failed to select an algorithm: {}", best.error));
+	for (std::size_t i = 0; i < msg_sizes.size(); ++i)
+		INFO("BCAST AUTO {}: {} {} {}", msg_sizes[i], hlop::enum_name(best.results[i].algo),
+		     hlop::enum_name(best.results[i].status),
+		     best.results[i].time);
+	const auto bad = client.request(query(hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, "i10r4n[03-", {1}));
+	if (bad.ok)
+		HLOP_ERR("hlopd answered an invalid node list");
+	INFO("invalid node list: {}", bad.error);
+
+	std::ostringstream oss;
+	oss << client.get_stats();
+	INFO("{}", oss.str());
+	server.stop();
+	loop.join();
+
+	// a new server answers from the cache file of the old one
+	{
+		// the first server still listens on its socket
+		hlop::hlopd_server_t again{hlop::hlopd_config_t{.socket_path = path + ".2",
+		                                                .nthread = 1,
+		                                                .topology_capacity = 16,
+		                                                .result_capacity = 1024,
+		                                                .cache_path = cache_path,
+		                                                .cache_capacity = 4096}};
+		std::thread again_loop{[&] { again.run(); }};
+		hlop::hlopd_client_t again_client{path + ".2"};
+		const auto cached = again_client.request(query(hlop::op_type::BCAST, hlop::algo_type::BINOMIAL, hl, msg_sizes));
+		again.stop();
+		again_loop.join();
+		if (!cached.ok || !same(cached.results, res.results) || again.get_cache_stats()->hits != msg_sizes.size())
+			HLOP_ERR("a restarted hlopd did not answer from the cache file");
+		INFO("a restarted hlopd answered {} message sizes from the cache file", msg_sizes.size());
+	}
+	std::remove(cache_path.c_str());
+	return 0;
+}
@@ -1,7 +1,89 @@
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "err.h"
 #include "m_debug.h"
+#include "msg.h"
+#include "node/df_node.h"
+#include "node/node.h"
 #include "struct/node_list.h"
+#include "struct/symmetric.h"
 #include "struct/type.h"
 
+namespace {
+/**
+ * @brief check a regular node list against the same ranks bound one by one, and its level spans.
+ * @param name string, the name of the case.
+ * @param nl node_list, a node list of a regular arrangement.
+ * @param spans vector<int>, the expected level spans.
+ * @param symmetric bool, the expected is_symmetric.
+ */
+void check(const std::string &name, const hlop::node_list_t &nl, const std::vector<int> &spans, bool symmetric) {
+	// the explicit rank set maps every rank through the arrangement handlers and keeps per-rank arrays
+	std::vector<int> ranks(nl.get_rank_num());
+	std::iota(ranks.begin(), ranks.end(), 0);
+	const auto nodes_str = [&]() {
+		std::string res;
+		for (const auto &node : nl.get_node_list())
+			res += (res.empty() ? "" : ",") + node->name();
+		return res;
+	}();
+	const hlop::node_list_t bound{nl.get_platform(), nodes_str, nl.get_ppn(), nl.get_arrangement(), ranks};
+	if (!nl.is_regular() || bound.is_regular())
+		HLOP_ERR(hlop::format("{}: the arithmetic and the explicit list are not told apart", name));
+
+	// nodes with the ranks bound to their cores, the levels of the former per-node lookups
+	std::vector<std::shared_ptr<hlop::df_node>> nodes;
+	for (const auto &node : nl.get_node_list())
+		nodes.push_back(std::make_shared<hlop::df_node>(node->name()));
+	const int ncore_per_unit = nodes.front()->get_ncore_per_unit();
+	for (const int r : ranks) {
+		const int node = nl.get_node_id_by_rank(r), core = nl.get_core_id_by_rank(r);
+		if (node != bound.get_node_id_by_rank(r) || core != bound.get_core_id_by_rank(r) ||
+		    nl.get_unit_id_by_rank(r) != core / ncore_per_unit ||
+		    bound.get_unit_id_by_rank(r) != nl.get_unit_id_by_rank(r))
+			HLOP_ERR(hlop::format("{}: rank {} is on node {} core {}, bound on node {} core {}", name, r, node, core,
+			                      bound.get_node_id_by_rank(r), bound.get_core_id_by_rank(r)));
+		nodes[node]->bind_core(r, core);
+	}
+	for (const int r1 : ranks)
+		for (const int r2 : ranks) {
+			if (r1 == r2)
+				continue;
+			const auto &n1 = *nodes[nl.get_node_id_by_rank(r1)], &n2 = *nodes[nl.get_node_id_by_rank(r2)];
+			const int expect = &n1 == &n2 ? n1.get_core_level(r1, r2) : n1 - n2;
+			if (&n1 == &n2 && expect != n1.get_unit_level(nl.get_unit_id_by_rank(r1), nl.get_unit_id_by_rank(r2)))
+				HLOP_ERR(hlop::format("{}: unit level of ranks {} and {} is not their core level", name, r1, r2));
+			if (nl.get_level(r1, r2) != expect || bound.get_level(r1, r2) != expect)
+				HLOP_ERR(hlop::format("{}: level of ranks {} and {} is {}, bound {}, expect {}", name, r1, r2,
+				                      nl.get_level(r1, r2), bound.get_level(r1, r2), expect));
+		}
+
+	// with spans, the net level is the highest level whose groups part the two nodes
+	if (nl.get_level_spans() != spans)
+		HLOP_ERR(hlop::format("{}: level spans are [{}], expect [{}]", name, hlop::vtos(nl.get_level_spans()),
+		                      hlop::vtos(spans)));
+	for (int i = 0; i < nodes.size() && !spans.empty(); ++i)
+		for (int j = 0; j < nodes.size(); ++j) {
+			if (i == j)
+				continue;
+			int level = 0;
+			for (int l = 1; l < spans.size(); ++l)
+				if (spans[l] != 0 && i / spans[l] != j / spans[l])
+					level = l;
+			if (level != *nodes[i] - *nodes[j])
+				HLOP_ERR(hlop::format("{}: spans give level {} between nodes {} and {}, expect {}", name, level, i, j,
+				                      *nodes[i] - *nodes[j]));
+		}
+	if (hlop::is_symmetric(nl) != symmetric)
+		HLOP_ERR(hlop::format("{}: is_symmetric is {}, expect {}", name, !symmetric, symmetric));
+	INFO("{}: {} ranks on {} nodes, spans [{}], {}symmetric", name, ranks.size(), nodes.size(),
+	     hlop::vtos(spans), symmetric ? "" : "not ");
+}
+} // namespace
+
 int main(int argc, char const *argv[]) {
 	hlop::node_list_t nlist{hlop::platform::DF,
 	                        "i10r4n[03-04,06,08-10],j10r4n04",
@@ -9,5 +91,26 @@ int main(int argc, char const *argv[]) {
 	                        {.node_arrange = hlop::rank_arrangement::BLOCK,
 	                         .core_arrange = hlop::rank_arrangement::CYCLIC}};
 	INFO_VEC("node list", nlist.get_node_list());
+
+	const hlop::arrangement_t block{.node_arrange = hlop::rank_arrangement::BLOCK,
+	                                .core_arrange = hlop::rank_arrangement::BLOCK};
+	const hlop::arrangement_t cyclic{.node_arrange = hlop::rank_arrangement::CYCLIC,
+	                                 .core_arrange = hlop::rank_arrangement::CYCLIC};
+	const hlop::arrangement_t block_cyclic{.node_arrange = hlop::rank_arrangement::BLOCK,
+	                                       .core_arrange = hlop::rank_arrangement::CYCLIC};
+	// one rack, the groups of the upper levels hold the whole list
+	check("block", hlop::node_list_t{hlop::platform::DF, "i10r4n[01-08]", 16, block}, {1, 0, 0}, true);
+	// a non-pof2 ppn spreads the ranks over the units unevenly
+	check("ppn 6", hlop::node_list_t{hlop::platform::DF, "i10r1n[01-02],i10r2n[01-02]", 6, cyclic}, {1, 2, 0},
+	      false);
+	// two groups of two racks of four nodes
+	check("groups",
+	      hlop::node_list_t{hlop::platform::DF, "i10r1n[01-04],i10r2n[01-04],i11r1n[01-04],i11r2n[01-04]", 4,
+	                        block_cyclic},
+	      {1, 4, 8}, true);
+	// racks of 3 nodes, or of 2 nodes not aligned to the groups, are not uniform
+	check("uneven racks", hlop::node_list_t{hlop::platform::DF, "i10r1n[01-03],i10r2n[01-03]", 4, block}, {}, false);
+	check("unaligned groups", hlop::node_list_t{hlop::platform::DF, "i10r1n[01-02],i10r2n01,i11r1n01", 4, block}, {},
+	      false);
 	return 0;
-}
\ No newline at end of file
+}
@@ -1,8 +1,25 @@
+#include <chrono>
+#include <string>
+
 #include "m_debug.h"
 #include "node/df_node.h"
+#include "node/hostlist.h"
 
 int main(int argc, char const *argv[]) {
 	auto v = hlop::df_node::parse_node_list("i10r4n[03-04,06,08-10],j10r4n04");
 	INFO_VEC("node list", v);
+	INFO_VEC("hostlist", hlop::expand_hostlist("a[8-10],b[098-101],c7,d[3]"));
+	INFO("i10r4n03 {}, i10r4n {}, i10r4n03x {}", hlop::match_grouped_name("i10r4n03", 3),
+	     hlop::match_grouped_name("i10r4n", 3), hlop::match_grouped_name("i10r4n03x", 3));
+
+	// throughput of a large allocation, 64 islands of 16 racks of 128 nodes
+	std::string host_list;
+	for (int i = 0; i < 64; ++i)
+		for (int r = 0; r < 16; ++r)
+			host_list += "i" + std::to_string(i) + "r" + std::to_string(r) + "n[000-063,064-127],";
+	const auto start = std::chrono::steady_clock::now();
+	auto nodes = hlop::df_node::parse_node_list(host_list);
+	const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	INFO("parsed {} nodes in {} s, {} nodes/s", nodes.size(), elapsed, nodes.size() / elapsed);
 	return 0;
 }
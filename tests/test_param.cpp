@@ -1,25 +1,100 @@
-#include <iostream>
-#include <string>
+#include <algorithm>
 #include <cmath>
+#include <exception>
+#include <string>
+#include <vector>
 
+#include "err.h"
+#include "interp.h"
+#include "m_debug.h"
+#include "msg.h"
 #include "param/param.h"
+#include "resources.h"
 
 int main(int argc, char const *argv[]) {
-	std::string path = "/home/huang/project/H-Lop/resources/东方超算N-Hop参数.csv";
-	hlop::param_t p{path};
-	std::cout << p.get_categorys().size() << std::endl;
-
+	const std::string path = hlop::RESOURCE_BASE + hlop::DF_HLOP_PARAM_LAT;
+	const hlop::param_t p{path};
 	const auto &range = p.get_msg_size_range();
-	for (const auto &i : range) {
-		const auto &v = p.get_param(std::pow(2, static_cast<int>(i)), "L0", "PING", "1");
-		std::cout << v << ",";
+	INFO("{}: {} categories, {} message sizes", path, p.get_categorys().size(), range.size());
+
+	std::vector<hlop::param_key_t> keys;
+	for (const auto category : p.get_categorys()) {
+		hlop::param_key_t key;
+		if (hlop::param::parse_category(std::string{category}, key))
+			keys.push_back(key);
 	}
-	std::cout << std::endl;
+	if (keys.empty())
+		HLOP_ERR(hlop::format("no typed category in {}", path));
+
+	// every mode reproduces the measured values on the grid,
+	// the piecewise modes stay between the neighbouring measured values off the grid
+	for (const auto mode : {hlop::interp_mode::EXPONENTIAL, hlop::interp_mode::LOG_LINEAR,
+	                        hlop::interp_mode::MONOTONE_CUBIC}) {
+		const hlop::param_t pm{path, mode};
+		const bool piecewise = mode != hlop::interp_mode::EXPONENTIAL;
+		for (const auto &key : keys) {
+			const auto name = hlop::format("L{}_{}_{}", static_cast<int>(key.cls), key.level, key.contention);
+			const auto measured = pm.get_category_params(name);
+			for (std::size_t i = 0; i < range.size(); ++i) {
+				const int size = 1 << static_cast<int>(range[i]);
+				if (pm.get_param(size, key) != measured[i] || pm.get_param(size, name) != measured[i])
+					HLOP_ERR(hlop::format("{} of {} at {} bytes is {}, measured {}", mode, name, size,
+					                      pm.get_param(size, key), measured[i]));
+				if (!piecewise || i + 1 == range.size())
+					continue;
+				const double v = pm.get_param(size + size / 2, key);
+				// a curve interpolated in log space is off by the rounding of exp(log(v))
+				const double eps = 1e-12 * std::max(std::abs(measured[i]), std::abs(measured[i + 1]));
+				const double lo = std::min(measured[i], measured[i + 1]) - eps;
+				const double hi = std::max(measured[i], measured[i + 1]) + eps;
+				if (!(v >= lo && v <= hi))
+					HLOP_ERR(hlop::format("{} of {} at {} bytes is {}, out of [{}, {}]", mode, name, size + size / 2,
+					                      v, lo, hi));
+			}
+		}
+		INFO("{}: {} categories exact on the grid{}", mode, keys.size(),
+		     piecewise ? ", between the neighbouring values off the grid" : "");
+
+		// a batch is the same as a lookup of each message size, on and off the grid and beyond it
+		std::vector<int> sizes;
+		for (const double e : range) {
+			const int size = 1 << static_cast<int>(e);
+			sizes.insert(sizes.end(), {size, size + 5, size + size / 2});
+		}
+		sizes.push_back(1 << 22);
+		std::vector<double> batch(sizes.size());
+		for (const auto &key : keys) {
+			const auto name = hlop::format("L{}_{}_{}", static_cast<int>(key.cls), key.level, key.contention);
+			pm.get_param_batch(sizes.data(), sizes.size(), key, batch.data());
+			for (std::size_t i = 0; i < sizes.size(); ++i)
+				if (batch[i] != pm.get_param(sizes[i], key))
+					HLOP_ERR(hlop::format("{} batch of {} at {} bytes is {}, expect {}", mode, name, sizes[i],
+					                      batch[i], pm.get_param(sizes[i], key)));
+			pm.get_param_batch(sizes.data(), sizes.size(), name, batch.data());
+			for (std::size_t i = 0; i < sizes.size(); ++i)
+				if (batch[i] != pm.get_param(sizes[i], name))
+					HLOP_ERR(hlop::format("{} batch of {} at {} bytes is {}, expect {}", mode, name, sizes[i],
+					                      batch[i], pm.get_param(sizes[i], name)));
+		}
+		INFO("{}: batches of {} message sizes equal to their lookups", mode, sizes.size());
 
-	for (const auto &i : range) {
-		const auto &v = p.get_param(std::pow(2, static_cast<int>(i)) + 5, "L0", "PING", "1");
-		std::cout << v << ",";
+		// a message size that is not positive is rejected before it reaches the table
+		for (const int size : {0, -1, -1024}) {
+			const auto name = hlop::format("L{}_{}_{}", static_cast<int>(keys[0].cls), keys[0].level, keys[0].contention);
+			bool thrown_key = false, thrown_name = false;
+			try {
+				pm.get_param(size, keys[0]);
+			} catch (const std::exception &e) {
+				thrown_key = true;
+			}
+			try {
+				pm.get_param(size, name);
+			} catch (const std::exception &e) {
+				thrown_name = true;
+			}
+			if (!thrown_key || !thrown_name)
+				HLOP_ERR(hlop::format("{} of {} at {} bytes does not throw", mode, name, size));
+		}
 	}
-	std::cout << std::endl;
 	return 0;
 }
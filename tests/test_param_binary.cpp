@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "err.h"
+#include "interp.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "param/param.h"
+#include "resources.h"
+
+namespace {
+std::string read_file(const std::string &path) {
+	std::ifstream fin{path, std::ios::binary};
+	std::stringstream ss;
+	ss << fin.rdbuf();
+	return ss.str();
+}
+
+void write_file(const std::string &path, const std::string &s) {
+	std::ofstream fout{path, std::ios::binary | std::ios::trunc};
+	if (!(fout << s))
+		HLOP_ERR(hlop::format("cannot write {}", path));
+}
+
+void compile(const std::string &csv, const std::string &bin) {
+	const auto cmd = hlop::format("{} --in={} --out={} > /dev/null", HLOP_PARAM_COMPILE, csv, bin);
+	if (std::system(cmd.c_str()) != 0)
+		HLOP_ERR(hlop::format("{} failed", cmd));
+}
+} // namespace
+
+int main(int argc, char const *argv[]) {
+	// a copy of the csv, so that it can be made stale
+	const std::string csv = hlop::format("/tmp/test_param_binary-{}.csv", ::getpid());
+	const std::string bin = hlop::format("/tmp/test_param_binary-{}.bin", ::getpid());
+	const std::string text = read_file(hlop::RESOURCE_BASE + hlop::DF_HLOP_PARAM_LAT);
+	write_file(csv, text);
+	compile(csv, bin);
+	if (!hlop::param::is_binary(bin) || !hlop::param::is_compiled_from(bin, csv) ||
+	    hlop::param::choose_file(bin, csv) != bin)
+		HLOP_ERR(hlop::format("{} is not chosen as compiled from {}", bin, csv));
+
+	// the binary file reproduces the csv for every category, on and off the grid
+	const hlop::param_t from_csv{csv};
+	const hlop::param_t from_bin{bin};
+	// the categories are listed in no particular order
+	auto bin_categorys = from_bin.get_categorys();
+	auto csv_categorys = from_csv.get_categorys();
+	std::sort(bin_categorys.begin(), bin_categorys.end());
+	std::sort(csv_categorys.begin(), csv_categorys.end());
+	if (from_bin.get_interp_mode() != from_csv.get_interp_mode() ||
+	    from_bin.get_msg_size_range() != from_csv.get_msg_size_range() || bin_categorys != csv_categorys)
+		HLOP_ERR(hlop::format("{} does not have the table of {}", bin, csv));
+	std::vector<int> sizes{3, 5, 100, 1000, 12345, 1 << 22};
+	for (const double e : from_csv.get_msg_size_range()) {
+		const int size = 1 << static_cast<int>(e);
+		sizes.insert(sizes.end(), {size, size + 5, size + size / 2});
+	}
+	for (const auto category : from_csv.get_categorys()) {
+		const std::string name{category};
+		hlop::param_key_t key;
+		const bool typed = hlop::param::parse_category(name, key);
+		for (const int size : sizes) {
+			const double expect = from_csv.get_param(size, name);
+			if (from_bin.get_param(size, name) != expect || (typed && from_bin.get_param(size, key) != expect))
+				HLOP_ERR(hlop::format("{} of {} bytes is {} in {}, {} in {}", name, size, from_bin.get_param(size, name),
+				                      bin, expect, csv));
+		}
+	}
+	INFO("{}: {} categories of {} message sizes equal to {}", bin, from_csv.get_categorys().size(), sizes.size(), csv);
+
+	// a changed csv makes the binary file stale, the csv is loaded instead
+	const std::size_t first_row_end = text.find('\n', text.find('\n') + 1);
+	write_file(csv, text.substr(0, first_row_end) + "1" + text.substr(first_row_end));
+	if (hlop::param::is_compiled_from(bin, csv) || hlop::param::choose_file(bin, csv) != csv)
+		HLOP_ERR(hlop::format("{} is not rejected as stale after {} changed", bin, csv));
+	INFO("{}: rejected as stale after {} changed", bin, csv);
+
+	std::remove(csv.c_str());
+	std::remove(bin.c_str());
+	return 0;
+}
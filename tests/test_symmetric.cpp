@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "allgather.h"
+#include "bcast.h"
+#include "err.h"
+#include "m_debug.h"
+#include "msg.h"
+#include "platform.h"
+#include "scatter.h"
+#include "struct/comm_round.h"
+#include "struct/node_list.h"
+#include "struct/plan.h"
+#include "struct/symmetric.h"
+#include "struct/type.h"
+
+namespace {
+/**
+ * @brief make a host list of the first total nodes of islands of racks of nodes.
+ */
+std::string make_host_list(int nisland, int nrack, int nnode, int total) {
+	std::string res;
+	for (int i = 0; i < nisland; ++i)
+		for (int r = 0; r < nrack; ++r)
+			for (int n = 0; n < nnode && total > 0; ++n, --total)
+				res += hlop::format("{}i{}r{}n{}", res.empty() ? "" : ",", i, r, n);
+	return res;
+}
+
+/**
+ * @brief enumerate the pairs of a mask pattern, the same pairs as the explicit simulation.
+ */
+void enumerate(const hlop::node_list_t &nl, const hlop::mask_pattern_t &mp, hlop::comm_round_t &r) {
+	r.clear();
+	for (int rank = 0; rank + mp.mask < nl.get_rank_num() && rank < mp.limit; ++rank)
+		if (rank % (2 * mp.mask) < mp.len)
+			r.add(nl, rank, rank + mp.mask);
+}
+
+std::string to_string(const std::vector<hlop::plan_group_t> &groups) {
+	std::string res;
+	for (const auto &g : groups)
+		res += hlop::format(" {}*{}", g.key, g.links);
+	return res;
+}
+
+bool same(const std::vector<hlop::plan_group_t> &a, const std::vector<hlop::plan_group_t> &b) {
+	if (a.size() != b.size())
+		return false;
+	for (std::size_t i = 0; i < a.size(); ++i)
+		if (a[i].key.cls != b[i].key.cls || a[i].key.level != b[i].key.level ||
+		    a[i].key.contention != b[i].key.contention || a[i].links != b[i].links)
+			return false;
+	return true;
+}
+} // namespace
+
+int main(int argc, char const *argv[]) {
+	// islands, racks per island, nodes per rack, nodes of the list, the last group may be partial
+	const std::vector<std::vector<int>> shapes{{1, 1, 64, 64}, {1, 4, 16, 64}, {2, 2, 8, 32},
+	                                           {1, 3, 8, 24}, {1, 2, 8, 13}, {4, 2, 4, 29}};
+	const std::vector<hlop::rank_arrangement_t> core_arranges{hlop::rank_arrangement::BLOCK,
+	                                                          hlop::rank_arrangement::CYCLIC};
+	hlop::comm_round_t r;
+	std::vector<hlop::plan_group_t> explicit_groups, symmetric_groups;
+	int nround = 0;
+	for (const auto &s : shapes)
+		for (int ppn = 1; ppn <= 16; ppn <<= 1)
+			for (const auto ca : core_arranges) {
+				hlop::node_list_t nl{hlop::platform::DF, make_host_list(s[0], s[1], s[2], s[3]), ppn,
+				                     {.node_arrange = hlop::rank_arrangement::BLOCK, .core_arrange = ca}};
+				if (!hlop::is_symmetric(nl))
+					HLOP_ERR(hlop::format("{} x {} is not symmetric", nl, ppn));
+				for (int mask = 1; mask < nl.get_rank_num(); mask <<= 1)
+					for (const int len : {1, mask})
+						// no limit, and limits cutting a node, a link or nothing off
+						for (const int limit : {std::numeric_limits<int>::max(), 0, 1, ppn - 1, ppn + len / 2,
+						                        nl.get_rank_num() / 3, nl.get_rank_num() - mask}) {
+							const hlop::mask_pattern_t mp{mask, len, std::max(0, limit)};
+							enumerate(nl, mp, r);
+							explicit_groups.clear();
+							symmetric_groups.clear();
+							hlop::plan::append_histogram(nl, r, explicit_groups);
+							hlop::append_symmetric_histogram(nl, mp, symmetric_groups);
+							if (!same(explicit_groups, symmetric_groups))
+								HLOP_ERR(hlop::format("{} x {} mask {} len {} limit {}: explicit{}, symmetric{}", nl, ppn,
+								                      mask, len, mp.limit, to_string(explicit_groups),
+								                      to_string(symmetric_groups)));
+							++nround;
+						}
+			}
+	INFO("{} rounds of symmetric node lists are the same as the explicit ones", nround);
+
+	// irregular lists fall back to the explicit simulation
+	hlop::node_list_t uneven{hlop::platform::DF, "i10r4n[03-04,06],i10r5n[01-02]", 4,
+	                         {.node_arrange = hlop::rank_arrangement::BLOCK, .core_arrange = hlop::rank_arrangement::BLOCK}};
+	hlop::node_list_t odd_ppn{hlop::platform::DF, "i10r4n[00-07]", 6,
+	                          {.node_arrange = hlop::rank_arrangement::BLOCK, .core_arrange = hlop::rank_arrangement::BLOCK}};
+	hlop::node_list_t ranks{hlop::platform::DF, "i10r4n[00-07]", 4,
+	                        {.node_arrange = hlop::rank_arrangement::BLOCK, .core_arrange = hlop::rank_arrangement::BLOCK},
+	                        {0, 1, 2, 3, 4, 5}};
+	INFO("symmetric: uneven racks {}, 6 ppn {}, rank set {}",
+	     hlop::is_symmetric(uneven), hlop::is_symmetric(odd_ppn), hlop::is_symmetric(ranks));
+
+	// the same predictions as the rank set of all ranks, which is simulated pair by pair
+	hlop::bcast b{};
+	hlop::scatter sc{};
+	hlop::allgather ag{};
+	int npredict = 0;
+	for (const auto &s : shapes)
+		for (int ppn = 1; ppn <= 4; ppn <<= 1) {
+			const std::string host_list = make_host_list(s[0], s[1], s[2], s[3]);
+			const hlop::arrangement_t arrange{.node_arrange = hlop::rank_arrangement::BLOCK,
+			                                  .core_arrange = hlop::rank_arrangement::BLOCK};
+			hlop::node_list_t nl{hlop::platform::DF, host_list, ppn, arrange};
+			std::vector<int> all(nl.get_rank_num());
+			for (int rank = 0; rank < nl.get_rank_num(); ++rank)
+				all[rank] = rank;
+			hlop::node_list_t nl_all{hlop::platform::DF, host_list, ppn, arrange, all};
+			if (hlop::is_symmetric(nl_all))
+				HLOP_ERR(hlop::format("{} with a rank set is symmetric", nl_all));
+			for (const int msg_size : {1, 2, 100, 4096, 65536, 1 << 20}) {
+				const std::vector<double> p{sc.predict(hlop::algo_type::BINOMIAL, nl, msg_size, 0),
+				                            b.predict(hlop::algo_type::BINOMIAL, nl, msg_size, 0),
+				                            ag.predict(hlop::algo_type::RECURSIVE_DOUBLING, nl, msg_size, 0)},
+				    q{sc.predict(hlop::algo_type::BINOMIAL, nl_all, msg_size, 0),
+				      b.predict(hlop::algo_type::BINOMIAL, nl_all, msg_size, 0),
+				      ag.predict(hlop::algo_type::RECURSIVE_DOUBLING, nl_all, msg_size, 0)};
+				if (p != q)
+					HLOP_ERR(hlop::format("{} x {} msg {}: symmetric {} {} {}, rank set {} {} {}", nl, ppn, msg_size,
+					                      p[0], p[1], p[2], q[0], q[1], q[2]));
+				npredict += p.size();
+			}
+		}
+	INFO("{} predictions of symmetric node lists are the same as the rank sets", npredict);
+
+	// 4096 nodes x 16 ppn, 65536 ranks
+	hlop::node_list_t large{hlop::platform::DF, make_host_list(4, 16, 64, 4096), 16,
+	                        {.node_arrange = hlop::rank_arrangement::BLOCK, .core_arrange = hlop::rank_arrangement::BLOCK}};
+	auto start = std::chrono::steady_clock::now();
+	const auto p = b.make_plan(hlop::algo_type::BINOMIAL, large, 0);
+	auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	INFO("plan of {} ranks in {} us: {}", large.get_rank_num(), elapsed, p);
+	start = std::chrono::steady_clock::now();
+	const double cost = sc.predict(hlop::algo_type::BINOMIAL, large, 1024, 0);
+	elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	INFO("scatter of {} ranks in {} us: {}", large.get_rank_num(), elapsed, cost);
+	return 0;
+}